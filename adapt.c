@@ -0,0 +1,315 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Fill/Drain Model                                           //
+//                                                                                                     //
+//                                                                                                     //
+// File              : adapt.c                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Learns how fast the pumps move the level from the float trips the machine already sees.  Aerating   //
+// from the float going full until it goes empty is one hysteresis band with both pumps on, the drain  //
+// winning: a fall sample.  LOWER_LEVEL then takes the level some way below the empty trip, and        //
+// RAISE_LEVEL_IN_DURATION brings it back up past the full trip with the fill pump alone: with the     //
+// depth worked out from the fall rate, that is a fill sample.  Each kind goes into a running average  //
+// that moves 1 / 2^ADAPT_SHIFT of the way to every new trip, so a pump that slows with age or a weak  //
+// battery is followed, and a trip cut short by a knob or the drain override is simply not counted.    //
+//                                                                                                     //
+// With both pumps on while lowering, the fill pump only fights the drain, but switching it off for    //
+// every exchange costs a fill start each time, far more starts than the pump time it saves is worth.  //
+// Built with LWC_ADAPTIVE, once ADAPT_TRIPS of each kind are in, only the exchange that opens an      //
+// aeration period runs the drain alone, as the fill pump is already off for the rest.  The drain      //
+// takes the level from the full trip down past the empty one, and LOWER_LEVEL carries on for the time //
+// that takes it as deep as the drain knob asked for with both pumps on, as the rates add up           //
+// T * fill / ( fill + fall ).  The rest runs longer by the time that saves, so the fill burst starts  //
+// the refill when the both-pump lowering would have ended and every exchange after it falls where it  //
+// did: no start is added, and both pumps skip the opening run.  Nothing is started ahead of a float   //
+// trip; the fill pump still runs from the end of a lowering to the full trip.  Otherwise the model is //
+// only kept, traced and sent in telemetry.                                                            //
+//                                                                                                     //
+// Underway, water sloshing about the trip point makes the float chatter, and a trip settles late, or  //
+// early on a splash, by however long that lasts.  The samples are off by as much, and a drain-alone   //
+// lowering timed from them can take the level well below where both pumps would have.  The level only //
+// falls in LOWER_LEVEL, so the float reading full there gives it away.  That trip is not learned, and //
+// the model is not used again until ADAPT_CALM exchanges have gone by without it.                     //
+//                                                                                                     //
+// Each well has its own model, as each has its own pumps and plumbing.  The models live in ordinary   //
+// RAM and start again after any reset.                                                                //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "adapt.h"
+#include "pumps.h"
+#include "timebase.h"
+#include "trace.h"
+
+#define PH_NONE                     0           // nothing being timed
+#define PH_FALL                     1           // aerating, from the float going full to empty
+#define PH_LOWER                    2           // LOWER_LEVEL
+#define PH_REFILL                   3           // RAISE_LEVEL_IN_DURATION, back up to full
+#define PH_TOFULL                   4           // RAISE_LEVEL or RAISE_LEVEL_B4_ALL_STOP
+
+#define SAMPLE_MAX                  0xFFFFUL    // longest trip that counts, ms
+
+ADAPTMODEL Adapt[ LWC_WELLS ];
+
+static unsigned char Phase[ LWC_WELLS ];        // PH_NONE
+static unsigned long Depth[ LWC_WELLS ];        // fall sample while lowering, then below the empty trip, 1/256 bands
+
+// Folds one trip into a running average, the first one taken as it is
+static void Learn( unsigned int *m, unsigned char *n, unsigned long ms, unsigned char id, unsigned char w ) {
+
+    unsigned int was = *m;
+    long d;
+
+    if( !ms || ms > SAMPLE_MAX ) return;
+
+    if( !*n ) *m = ( unsigned int )ms;
+    else {
+        d = ( long )ms - ( long )*m;
+        *m = ( unsigned int )( *m + d / ( 1 << ADAPT_SHIFT ) );
+    }
+    if( *n < ADAPT_TRIPS ) ( *n )++;
+
+    TRACE_KNOB_W( id, w, was >> 6, *m >> 6 );             // 64 ms units, 16 s at most
+}
+
+// Already full on entry is not a time to full
+static void ToFull( ADAPTMODEL *a, unsigned long ms ) {
+
+    if( !ms ) return;
+    ms /= 100;
+    a->tofull = ms > 0xFFFF ? 0xFFFF : ( unsigned int )ms;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Tells whether enough trips of each kind are in for a well's model to be used.          //
+// Arguments:   w - well                                                                               //
+// Returns:     Nonzero when ready                                                                     //
+//                                                                                                     //
+// Notes/Warnings/Caveats: None                                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int AdaptReady( unsigned char w ) {
+
+    return( Adapt[ w ].falls >= ADAPT_TRIPS && Adapt[ w ].fills >= ADAPT_TRIPS );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Decides how an aeration period starts in a well, at the end of its rest.               //
+// Arguments:   w - well                                                                               //
+// Returns:     Nonzero to run the drain alone down to the first exchange, zero for both pumps         //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Always zero without LWC_ADAPTIVE.  The answer holds until that exchange's   //
+//                         LOWER_LEVEL is over, or the period ends first.                              //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int AdaptAerate( unsigned char w ) {
+
+#ifdef LWC_ADAPTIVE
+    Adapt[ w ].alone = ( unsigned char )( AdaptReady( w ) && !Adapt[ w ].slosh );
+#else
+    Adapt[ w ].alone = 0;
+#endif
+    return( Adapt[ w ].alone );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Tells how the LOWER_LEVEL starting now in a well lowers.                               //
+// Arguments:   w - well                                                                               //
+// Returns:     Nonzero to run the drain alone, zero for both pumps                                    //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Only the exchange AdaptAerate started with the drain alone carries on so,   //
+//                         with the fill pump still off; AdaptLowerTime follows the same answer.       //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int AdaptLower( unsigned char w ) {
+
+    return( Adapt[ w ].alone );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: LOWER_LEVEL timeout for the way it is lowering.                                        //
+// Arguments:   w  - well                                                                              //
+//              ms - its DrainDurationTime, the time with both pumps on                                //
+// Returns:     ms, or the time the drain alone takes to the same depth                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: None                                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned long AdaptLowerTime( unsigned char w, unsigned long ms ) {
+
+    const ADAPTMODEL *a = &Adapt[ w ];
+    unsigned long sum = ( unsigned long )a->fill + a->fall;
+
+    if( !a->alone || !sum ) return( ms );
+    return( ms * a->fill / sum );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: AERATE's rest timeout, for the way the aeration period after it starts.                //
+// Arguments:   w  - well                                                                              //
+//              ms - CycleIntervalTime                                                                 //
+// Returns:     ms, or ms and the time the drain alone saves taking the level down to the first refill //
+//                                                                                                     //
+// Notes/Warnings/Caveats: The drain alone reaches the depth both pumps would, the band and then       //
+//                         DrainDurationTime, as much sooner as the fill pump would have held it back. //
+//                         Resting that much longer starts the refill when it would have started, so   //
+//                         the exchanges and the starts after it fall where they did.  Worked in 16 ms //
+//                         steps so it cannot overflow.  Always ms without LWC_ADAPTIVE.               //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned long AdaptRestTime( unsigned char w, unsigned long ms ) {
+
+#ifdef LWC_ADAPTIVE
+    const ADAPTMODEL *a = &Adapt[ w ];
+    unsigned long sum = ( ( unsigned long )a->fill + a->fall ) >> 4;
+
+    if( AdaptReady( w ) && !a->slosh && sum ) ms += ( DrainDurationTime[ w ] + a->fall ) * ( a->fall >> 4 ) / sum;
+#else
+    ( void )w;
+#endif
+    return( ms );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Watches a well's float for the water sloshing.                                         //
+// Arguments:   w  - well                                                                              //
+//              ev - event PumpEvent is about to run                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: PumpEvent calls it with every event, ignored ones too.  A trip caught       //
+//                         chattering is traced once.                                                  //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void AdaptFloat( unsigned char w, unsigned char ev ) {
+
+    if( ev != EV_FULL || LiveWellState[ w ] != LOWER_LEVEL ) return;
+
+    if( Phase[ w ] == PH_LOWER ) TRACE_W( TR_SLOSH, w, ADAPT_CALM );
+    Phase[ w ] = PH_NONE;
+    Adapt[ w ].slosh = ADAPT_CALM;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Times the trips from a well's state machine transitions.                               //
+// Arguments:   w    - well                                                                            //
+//              from - state the transition left                                                       //
+//              ev   - event that drove it                                                             //
+//              to   - state it entered                                                                //
+//              ms   - time the well spent in from, to the float settling for EV_FULL and EV_EMPTY     //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: PumpEvent calls it after every transition, in the main loop.  It takes ms   //
+//                         from TimeSince48, so a phase past a wrap of the clock reads too long to     //
+//                         learn from rather than short.                                               //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void AdaptStep( unsigned char w, unsigned char from, unsigned char ev, unsigned char to, unsigned long ms ) {
+
+    ADAPTMODEL *a = &Adapt[ w ];
+    unsigned char phase = Phase[ w ];
+
+    Phase[ w ] = PH_NONE;
+
+    switch( from ) {
+
+    case RAISE_LEVEL_IN_DURATION:               // EV_FULL, aerating again
+        if( phase == PH_REFILL ) {
+            if( a->slosh ) a->slosh--;
+            if( ms <= SAMPLE_MAX ) Learn( &a->fill, &a->fills, ms * 256 / ( 256 + Depth[ w ] ), TR_FILL, w );
+            ToFull( a, ms );
+        }
+        Phase[ w ] = PH_FALL;
+        break;
+
+    case AERATE:
+        if( ev != EV_EMPTY ) break;
+        Depth[ w ] = phase == PH_FALL ? ms : 0;  // learned once the lowering shows the float was calm
+        Phase[ w ] = PH_LOWER;
+        break;
+
+    case LOWER_LEVEL:                           // EV_DRAINED
+        if( phase != PH_LOWER ) break;
+        Learn( &a->fall, &a->falls, Depth[ w ], TR_FALL, w );
+        if( !a->falls || ms > SAMPLE_MAX ) break;
+        Depth[ w ] = ms * 256 / a->fall;
+        if( a->alone && a->fills ) Depth[ w ] += ms * 256 / a->fill;
+        Phase[ w ] = PH_REFILL;
+        break;
+
+    case RAISE_LEVEL:
+    case RAISE_LEVEL_B4_ALL_STOP:               // EV_FULL
+        if( phase == PH_TOFULL ) {
+            ToFull( a, ms );
+            TRACE_W( TR_TO_FULL, w, ms / 1000 > 255 ? 255 : ms / 1000 );
+        }
+        break;
+    }
+
+    if( to == RAISE_LEVEL || to == RAISE_LEVEL_B4_ALL_STOP ) Phase[ w ] = PH_TOFULL;
+
+    // A drain-alone start lasts until its lowering is over
+    if( to != AERATE && to != LOWER_LEVEL ) a->alone = 0;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Drops the trip being timed in a well.                                                  //
+// Arguments:   w - well                                                                               //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: ReadPots calls it when the well's drain override goes on or off, as the     //
+//                         level then moves in a way the model does not know about.  A drain-alone     //
+//                         start is dropped too, so the well carries on with both pumps.               //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void AdaptCancel( unsigned char w ) {
+
+    Phase[ w ] = PH_NONE;
+    Adapt[ w ].alone = 0;
+}
@@ -0,0 +1,45 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Fill/Drain Model                                           //
+//                                                                                                     //
+//                                                                                                     //
+// File              : adapt.h                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef ADAPT_H
+#define ADAPT_H
+
+#include "wells.h"
+
+#define ADAPT_SHIFT                 2           // each trip moves the model 1/4 of the way to it
+#define ADAPT_TRIPS                 3           // trips of each kind before the model is used
+#define ADAPT_CALM                  3           // exchanges without the float chattering before it is used again
+
+// Times are in ms for the level to cross the float's hysteresis band, the one length the float gives
+typedef struct {
+    unsigned int    fall;                       // both pumps on, the drain winning
+    unsigned int    fill;                       // fill pump alone
+    unsigned int    tofull;                     // last RAISE_* state to the float full, 100 ms units
+    unsigned char   falls;                      // trips measured, stops counting at ADAPT_TRIPS
+    unsigned char   fills;
+    unsigned char   alone;                      // the exchange under way runs the drain alone
+    unsigned char   slosh;                      // ADAPT_CALM after the float chattered, counts down to 0
+} ADAPTMODEL;
+
+extern ADAPTMODEL Adapt[ LWC_WELLS ];           // one per well, each has its own pumps and plumbing
+
+int AdaptReady( unsigned char w );
+int AdaptAerate( unsigned char w );
+int AdaptLower( unsigned char w );
+unsigned long AdaptLowerTime( unsigned char w, unsigned long ms );
+unsigned long AdaptRestTime( unsigned char w, unsigned long ms );
+void AdaptFloat( unsigned char w, unsigned char ev );
+void AdaptStep( unsigned char w, unsigned char from, unsigned char ev, unsigned char to, unsigned long ms );
+void AdaptCancel( unsigned char w );
+
+#endif
@@ -0,0 +1,121 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                           Pot Acquisition                                           //
+//                                                                                                     //
+//                                                                                                     //
+// File              : adc.c                                                                           //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// The pots are sampled in the background.  Every POT_SAMPLE_MS Timer1_A0 sets ADC10SC and the         //
+// ADC10 converts A3..A0 with no further CPU help.  The DTC runs in continuous two-block mode, so      //
+// each sequence lands in the other half of AdcBuffer and is never overwritten while ADC10_ISR is      //
+// still filtering it.  The ISR runs the trimmed-mean filter on every channel and only wakes the main  //
+// loop when a filtered value moved past the CAL_HYST band; PotFiltered and PotDirty are all it has to //
+// read.  More wells only lengthen the one sequence (A7..A0) and the one filter pass.                  //
+//                                                                                                     //
+// The ADC10 can also be started by a Timer_A output (SHSx), but only Timer0_A3 is wired to it on the  //
+// G2553, and Timer0 is kept free.  Setting ADC10SC from Timer1_A0 costs a couple of instructions.     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "adc.h"
+#include "filter.h"
+#include "cal.h"
+
+volatile unsigned int PotFiltered[ POT_CHANNELS ];
+volatile unsigned char PotDirty;
+
+static unsigned int AdcBuffer[ 2 * ADC_SEQ_LEN ];
+static const unsigned char AdcSlot[ ] = ADC_SLOTS;      // may list channels for more wells than built
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Sets up the ADC10 and DTC for background pot sequences.                                //
+// Arguments:   None                                                                                   //
+// Returns:     None                                                                                   //
+//                                                                                                     //
+// Notes/Warnings/Caveats: ENC stays set from here on; each ADC10SC starts another sequence.  Every    //
+//                         PotFiltered reads 0xFFFF, out of range, until its first sequence.           //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void AdcInit( void ) {
+
+    unsigned char ch;
+
+    for( ch = 0; ch < POT_CHANNELS; ch++ ) PotFiltered[ ch ] = 0xFFFF;
+
+    ADC10CTL0 = 0;
+    ADC10CTL1 = ADC_INCH + CONSEQ_1;                    // ADC_INCH down to A0, single sequence
+    ADC10CTL0 = ADC10SHT_3 + MSC + ADC10ON + ADC10IE;
+    ADC10DTC0 = ADC10TB + ADC10CT;                      // two blocks, continuous
+    ADC10DTC1 = ADC_SEQ_LEN;                            // conversions per block
+    ADC10AE0 |= ADC_AE;                                 // ADC10 option select for the pot pins
+    ADC10SA = HAL_DTC_ADDR( AdcBuffer );                // Data buffer start, starts the DTC
+    ADC10CTL0 |= ENC;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Triggers one pot sequence.                                                             //
+// Arguments:   None                                                                                   //
+// Returns:     None                                                                                   //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Called from Timer1_A0.  A sequence still converting is left alone so the    //
+//                         DTC never gets out of step with the channel order.                          //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void AdcStart( void ) {
+
+    if( !( ADC10CTL1 & ADC10BUSY ) ) ADC10CTL0 |= ADC10SC;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: ADC10 Interrupt Service Routine                                                        //
+//                                                                                                     //
+//              The DTC has filled one block of AdcBuffer.  Runs each channel through AvgAuxAI and     //
+//              marks the ones whose filtered value moved more than CAL_HYST counts.                   //
+//                                                                                                     //
+// Notes/Warnings/Caveats: ADC10B1 set means the first block just filled.                              //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#pragma vector=ADC10_VECTOR
+__interrupt void ADC10_ISR( void ) {
+
+    const unsigned int *blk;
+    unsigned int v;
+    unsigned char ch;
+
+    blk = ( ADC10DTC0 & ADC10B1 ) ? AdcBuffer : AdcBuffer + ADC_SEQ_LEN;
+
+    for( ch = 0; ch < POT_CHANNELS; ch++ ) {
+        v = AvgAuxAI( blk[ AdcSlot[ ch ] ], ch );
+        if( CAL_MOVED( PotFiltered[ ch ], v ) ) {
+            PotFiltered[ ch ] = v;
+            PotDirty |= 1 << ch;
+        }
+    }
+
+    if( PotDirty ) {
+        WakeEvents |= WAKE_POTS;
+        __bic_SR_register_on_exit( LPM3_bits );
+    }
+}
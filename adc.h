@@ -0,0 +1,61 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                           Pot Acquisition                                           //
+//                                                                                                     //
+//                                                                                                     //
+// File              : adc.h                                                                           //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef ADC_H
+#define ADC_H
+
+#include "wells.h"
+
+//
+// Filter channels.  The interval and duration knobs set one aeration schedule for the boat; every
+//  well has its own drain knob, well 0's on channel 0 and the others after the shared two.
+//
+#define POT_DRAIN                   0           // A3, P1.3
+#define POT_DURATION                1           // A2, P1.2 (A4, P1.4 with LWC_TELEMETRY)
+#define POT_INTERVAL                2           // A1, P1.1
+#define POT_WELL_DRAIN( w )         ( ( w ) ? 2 + ( w ) : POT_DRAIN )   // wells 1-3: A5, A6, A7
+#define POT_CHANNELS                ( 2 + LWC_WELLS )
+#define POT_ALL                     ( ( 1 << POT_CHANNELS ) - 1 )       // PotDirty, every channel
+
+#if LWC_WELLS > 1
+// The multi-well board converts A7..A0 in one sequence; slot k holds A( 7 - k )
+#define ADC_INCH                    INCH_7
+#define ADC_SEQ_LEN                 8
+#ifdef LWC_TELEMETRY
+#define ADC_SLOTS                   { 4, 3, 6, 2, 1, 0 }    // by channel: A3, A4, A1, A5, A6, A7
+#define ADC_AE_SHARED               0x1A
+#else
+#define ADC_SLOTS                   { 4, 5, 6, 2, 1, 0 }    // by channel: A3, A2, A1, A5, A6, A7
+#define ADC_AE_SHARED               0x0E
+#endif
+#define ADC_AE                      ( ADC_AE_SHARED | ( 0xE0 & ~( 0xE0 << ( LWC_WELLS - 1 ) ) ) )
+#elif defined( LWC_TELEMETRY )
+// P1.2 is UCA0TXD on the telemetry board, so the duration pot is on A4 and the sequence starts there
+#define ADC_INCH                    INCH_4
+#define ADC_SEQ_LEN                 5           // INCH_4 sequence is A4..A0, A2 and A0 are unused
+#define ADC_SLOTS                   { 1, 0, 3 } // block slot of POT_DRAIN, POT_DURATION, POT_INTERVAL
+#define ADC_AE                      0x1A        // P1.4,3,1
+#else
+#define ADC_INCH                    INCH_3
+#define ADC_SEQ_LEN                 4           // INCH_3 sequence is A3..A0, the A0 result is unused
+#define ADC_SLOTS                   { 0, 1, 2 }
+#define ADC_AE                      0x0E        // P1.3,2,1
+#endif
+
+extern volatile unsigned int PotFiltered[ POT_CHANNELS ];
+extern volatile unsigned char PotDirty;
+
+void AdcInit( void );
+void AdcStart( void );
+
+#endif
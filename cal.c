@@ -0,0 +1,65 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                        Pot Calibration Tables                                       //
+//                                                                                                     //
+//                                                                                                     //
+// File              : cal.c                                                                           //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Pot counts to milliseconds by piecewise-linear tables instead of a 32-bit multiply and divide per   //
+// knob, which the G2553 has to do in software.  The knots every 32 counts are worked out by the       //
+// compiler from the regression constants in cal.h, so the curve fit stays the one place to change.    //
+// Between knots the 5-bit offset into the segment times the segment rise is done with five shift      //
+// and add steps.  The tables are 132 bytes each in flash.                                             //
+//                                                                                                     //
+// sim/calbench.c checks every count of every knob against the regression, to within 1 ms.             //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "cal.h"
+
+#define CAL_MS( s, o, n )           ( ( ( unsigned long )( n ) * ( s ) + ( o ) ) / 1000 )
+#define CAL_KNOT( s, o, k )         CAL_MS( s, o, ( unsigned long )( k ) << CAL_SEG_SHIFT )
+#define CAL_KNOT4( s, o, k )        CAL_KNOT( s, o, k ), CAL_KNOT( s, o, k + 1 ), \
+                                    CAL_KNOT( s, o, k + 2 ), CAL_KNOT( s, o, k + 3 )
+#define CAL_TABLE( s, o )           { CAL_KNOT4( s, o, 0 ), CAL_KNOT4( s, o, 4 ), CAL_KNOT4( s, o, 8 ), \
+                                      CAL_KNOT4( s, o, 12 ), CAL_KNOT4( s, o, 16 ), CAL_KNOT4( s, o, 20 ), \
+                                      CAL_KNOT4( s, o, 24 ), CAL_KNOT4( s, o, 28 ), CAL_KNOT( s, o, 32 ) }
+
+const unsigned long CalInterval[ CAL_KNOTS ] = CAL_TABLE( CAL_INTERVAL_SLOPE, CAL_INTERVAL_OFFSET );
+const unsigned long CalDuration[ CAL_KNOTS ] = CAL_TABLE( CAL_DURATION_SLOPE, CAL_DURATION_OFFSET );
+const unsigned long CalDrain[ CAL_KNOTS ] = CAL_TABLE( CAL_DRAIN_SLOPE, CAL_DRAIN_OFFSET );
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Interpolates a knob table.                                                             //
+// Arguments:   tab - CalInterval, CalDuration or CalDrain, counts - filtered ADC counts (10 bit)      //
+// Returns:     milliseconds                                                                           //
+//                                                                                                     //
+// Notes/Warnings/Caveats: The segment rise is rounded to the nearest ms, never more than 1 ms off.    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned long CalLookup( const unsigned long *tab, unsigned int counts ) {
+
+    const unsigned long *k = &tab[ counts >> CAL_SEG_SHIFT ];
+    unsigned long rise = k[ 1 ] - k[ 0 ];
+    unsigned long acc = 1UL << ( CAL_SEG_SHIFT - 1 );
+    unsigned char off = counts & CAL_SEG_MASK;
+
+    while( off ) {
+        if( off & 1 ) acc += rise;
+        rise <<= 1;
+        off >>= 1;
+    }
+
+    return( k[ 0 ] + ( acc >> CAL_SEG_SHIFT ) );
+}
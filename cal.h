@@ -0,0 +1,44 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                        Pot Calibration Tables                                       //
+//                                                                                                     //
+//                                                                                                     //
+// File              : cal.h                                                                           //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef CAL_H
+#define CAL_H
+
+//
+// Knob curves, ms = ( counts * SLOPE + OFFSET ) / 1000.  Slope and offset come from a linear
+//  regression curve fit to make the potentiometer ADC counts match the time scale of the knob/dial.
+//
+#define CAL_INTERVAL_SLOPE          557074UL    // 0 to 10 minutes >> 0 to 600,000 ms
+#define CAL_INTERVAL_OFFSET         28097185UL
+#define CAL_DURATION_SLOPE          554866UL    // 0 to 10 minutes >> 0 to 600,000 ms
+#define CAL_DURATION_OFFSET         42290131UL
+#define CAL_DRAIN_SLOPE             9211UL      // 0 to 10 seconds >> 0 to 10,000 ms
+#define CAL_DRAIN_OFFSET            499849UL
+
+#define CAL_SEG_SHIFT               5           // 32 counts per segment
+#define CAL_SEG_MASK                0x1F
+#define CAL_KNOTS                   ( ( 1024 >> CAL_SEG_SHIFT ) + 1 )
+
+#define CAL_HYST                    1           // filtered counts ignored either side of the last value
+
+// Nonzero when filtered counts v should replace last; the ends of the scale are always taken
+#define CAL_MOVED( last, v )        ( ( v ) != ( last ) && ( ( v ) > ( last ) + CAL_HYST \
+                                    || ( v ) + CAL_HYST < ( last ) || ( v ) == 0 || ( v ) == 1023 ) )
+
+extern const unsigned long CalInterval[ CAL_KNOTS ];
+extern const unsigned long CalDuration[ CAL_KNOTS ];
+extern const unsigned long CalDrain[ CAL_KNOTS ];
+
+unsigned long CalLookup( const unsigned long *tab, unsigned int counts );
+
+#endif
@@ -0,0 +1,165 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                         Float Switch Debounce                                       //
+//                                                                                                     //
+//                                                                                                     //
+// File              : debounce.c                                                                      //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// A float edge interrupt starts a run of 1 ms samples taken from Timer1_A0.  The published FloatState //
+// only changes after FLOAT_DEBOUNCE_MS identical samples in a row, and FloatSince records the time of //
+// the first of them, when the level reached the trip.  Between runs Timer1_A0 does not wake up for    //
+// the floats at all.  Readers never wait; until the first run completes FloatState is FLOAT_UNKNOWN.  //
+//                                                                                                     //
+// Every well's float is on port 2, so one read of P2IN samples them all, and each well keeps its own  //
+// run: an edge on one float restarts that well's run only, and the others carry on in the same 1 ms   //
+// pass rather than waiting out a debounce delay of their own.                                         //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "debounce.h"
+
+volatile unsigned char FloatState[ LWC_WELLS ] = WELLS_OF( FLOAT_UNKNOWN );
+volatile TBTICKS FloatSince[ LWC_WELLS ];
+
+static unsigned char FloatRaw[ LWC_WELLS ] = WELLS_OF( FLOAT_UNKNOWN );
+static unsigned char FloatRun[ LWC_WELLS ];
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Arms the float edge interrupts and starts the first debounce runs.                     //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Call once at startup, before interrupts are enabled.                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void FloatDebounceInit( void ) {
+
+    FloatEdge( FLOAT_BITS );
+    P2IFG &= ~FLOAT_BITS;
+    P2IE |= FLOAT_BITS;
+}
+
+
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Float switch edges: watch for the opposite edges and restart those wells' runs.        //
+// Arguments:   bits - FLOAT_BIT of each float that moved                                              //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Called from the PORT2 interrupt.                                            //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void FloatEdge( unsigned char bits ) {
+
+    unsigned char w;
+
+    P2IES = ( P2IES & ~bits ) | ( P2IN & bits );            // high, next edge is falling
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        if( bits & FLOAT_BIT( w ) ) FloatRun[ w ] = 0;
+    }
+}
+
+
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Takes one sample of every float whose debounce run is in progress.                     //
+// Arguments:   now - time of the sample                                                               //
+// Returns:     Bit w set for each well w whose FloatState changed                                     //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Call from Timer1_A0 only, every 1 ms while FloatDebouncing().  The samples  //
+//                         are 32 or 33 ticks apart, so FloatSince is the first of the run to a tick.  //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned char FloatDebounce( TBTICKS now ) {
+
+    unsigned char in = P2IN, changed = 0, raw, w;
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        if( FloatRun[ w ] >= FLOAT_DEBOUNCE_MS ) continue;
+
+        raw = ( in & FLOAT_BIT( w ) ) ? INDICATES_FULL : INDICATES_EMPTY;
+
+        if( raw != FloatRaw[ w ] ) {
+            FloatRaw[ w ] = raw;
+            FloatRun[ w ] = 0;
+        }
+
+        if( ++FloatRun[ w ] == FLOAT_DEBOUNCE_MS && raw != FloatState[ w ] ) {
+            FloatSince[ w ] = now - TB_WHOLE( FLOAT_DEBOUNCE_MS - 1 );
+            FloatState[ w ] = raw;
+            changed |= 1 << w;
+        }
+    }
+    return( changed );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Whether a debounce run is in progress.                                                 //
+// Arguments:   None                                                                                   //
+// Returns:     Nonzero while FloatDebounce needs its 1 ms samples                                     //
+//                                                                                                     //
+// Notes/Warnings/Caveats: None                                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int FloatDebouncing( void ) {
+
+    unsigned char w;
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        if( FloatRun[ w ] < FLOAT_DEBOUNCE_MS ) return( 1 );
+    }
+    return( 0 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Time at which a well's float switch settled into its FloatState.                       //
+// Arguments:   w - well                                                                               //
+// Returns:     TimeTicks() at the first of the agreeing samples                                       //
+//                                                                                                     //
+// Notes/Warnings/Caveats: FloatSince is two words, so it is copied with the timer interrupt held off. //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+TBTICKS FloatStableSince( unsigned char w ) {
+
+    unsigned int sr = __get_SR_register( );
+    TBTICKS t;
+
+    __disable_interrupt( );
+    t = FloatSince[ w ];
+    if( sr & GIE ) __enable_interrupt( );
+
+    return( t );
+}
@@ -0,0 +1,35 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                         Float Switch Debounce                                       //
+//                                                                                                     //
+//                                                                                                     //
+// File              : debounce.h                                                                      //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+// Consecutive 1 ms samples that must agree before the float state changes.  Matches the three reads
+// 5 ms apart the state machine used to spin on.
+#define FLOAT_DEBOUNCE_MS           10
+
+#define FLOAT_UNKNOWN               0xFF
+
+#include "timebase.h"
+#include "wells.h"
+
+extern volatile unsigned char FloatState[ LWC_WELLS ];  // INDICATES_EMPTY, INDICATES_FULL or FLOAT_UNKNOWN
+extern volatile TBTICKS FloatSince[ LWC_WELLS ];        // when FloatState last changed, see FloatStableSince
+
+void FloatDebounceInit( void );
+unsigned char FloatDebounce( TBTICKS now );
+int FloatDebouncing( void );
+void FloatEdge( unsigned char bits );
+TBTICKS FloatStableSince( unsigned char w );
+
+#endif
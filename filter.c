@@ -0,0 +1,147 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                        Pot Trimmed-Mean Filter                                      //
+//                                                                                                     //
+//                                                                                                     //
+// File              : filter.c                                                                        //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Rolling average of the last 16 samples with the highest and lowest thrown away, as the original     //
+// AvgAuxAI did it: each call stores the sample and scans the window once for its sum, minimum and     //
+// maximum.  The sum of 16 ten-bit samples fits 16 bits, and the /14 is done with shifts and adds      //
+// because the G2553 has neither a multiplier nor a divider; the original took a 32-bit sum and a      //
+// library divide.                                                                                     //
+//                                                                                                     //
+// Output is identical to the original version (see sim/filtbench.c).                                  //
+//                                                                                                     //
+// RAM is the scarce part on the G2553, so the window keeps each 10-bit sample as its low byte and two //
+// high bits, packed four to a byte: 21 bytes a channel where plain ints took 34.  The scan unpacks a  //
+// high byte every fourth sample, a shift and a mask a sample.  An incremental version, a running sum  //
+// and monotonic queues for the minimum and maximum, was tried and dropped: it took 44 bytes a channel //
+// even packed, and more time a call.                                                                  //
+//                                                                                                     //
+// The windows live in no-init RAM so the knobs are not re-learned after a watchdog reset.  They need  //
+// no checksum of their own.  Packed samples have no spare bits left to check, so AuxValid only checks //
+// the index; WarmStart only asks once WarmSnap's checksum has shown RAM held.                         //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "hal.h"
+#include "filter.h"
+
+HAL_NOINIT AUXFILTER AuxFilter[ AUX_CHANNELS ];
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: x / 14 without a divide: halve, then divide by 7 (Hacker's Delight, divu7).            //
+// Arguments:   x - at most 14 * 1023                                                                  //
+// Returns:     x / 14, truncated                                                                      //
+//                                                                                                     //
+// Notes/Warnings/Caveats: q underestimates n / 7 by at most one; the remainder step corrects it.      //
+//                         All intermediates stay below 2^16 for this range.                           //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static unsigned int Div14( unsigned int x ) {
+
+    unsigned int n, q, r;
+
+    n = x >> 1;
+    q = ( n >> 1 ) + ( n >> 4 );
+    q += q >> 6;
+    q += q >> 12;
+    q >>= 2;
+    r = n - ( ( q << 3 ) - q );
+    return( q + ( ( r + 1 ) >> 3 ) );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Adds a sample to a channel's window.                                                   //
+// Arguments:   newval - ADC counts (10 bit), ch - channel                                             //
+// Returns:     newval until the window has filled, then the trimmed mean of the window                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Sixteen loads, unpacks, adds and compare pairs a call; no divide.           //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned int AvgAuxAI( unsigned int newval, unsigned char ch ) {
+
+    AUXFILTER *f = &AuxFilter[ ch ];
+    unsigned int sum, tmp, min, max;
+    unsigned char u0, hi = 0, s;
+
+    u0 = f->indx++ & AUX_MASK;
+    s = ( u0 & 3 ) << 1;
+    f->lo[ u0 ] = ( unsigned char )newval;
+    f->hi[ u0 >> 2 ] = ( unsigned char )( ( f->hi[ u0 >> 2 ] & ~( 3 << s ) ) | ( ( newval >> 8 ) & 3 ) << s );
+
+    if( f->indx & 0x10 ) f->indx |= AUX_FULL;
+    f->indx &= AUX_FULL | AUX_MASK;
+
+    if( !( f->indx & AUX_FULL ) ) return( newval );
+
+    min = 1024;
+    max = 0;
+    for( sum = 0, u0 = 0; u0 < AUX_SAMPLES; u0++ ) {
+        if( !( u0 & 3 ) ) hi = f->hi[ u0 >> 2 ];
+        sum += tmp = f->lo[ u0 ] | ( hi & 3 ) << 8;
+        hi >>= 2;
+        if( tmp < min ) min = tmp;
+        if( tmp > max ) max = tmp;
+    }
+    return( Div14( sum - min - max ) );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Empties every channel's window.                                                        //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: AuxFilter is no-init, so a cold start must call this before the first       //
+//                         sample.                                                                     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void AuxReset( void ) {
+
+    unsigned char ch;
+
+    for( ch = 0; ch < AUX_CHANNELS; ch++ ) AuxFilter[ ch ].indx = 0;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Checks that a channel's window survived a reset intact.                                //
+// Arguments:   ch - channel                                                                           //
+// Returns:     Nonzero when the window holds at least one sample and its index is in range            //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Every packed sample is 10 bits whatever RAM holds, so there is no more to   //
+//                         check; startup only.                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int AuxValid( unsigned char ch ) {
+
+    unsigned char indx = AuxFilter[ ch ].indx;
+
+    return( !( indx & ~( AUX_FULL | AUX_MASK ) ) && indx != 0 );
+}
@@ -0,0 +1,37 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                        Pot Trimmed-Mean Filter                                      //
+//                                                                                                     //
+//                                                                                                     //
+// File              : filter.h                                                                        //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "adc.h"
+
+#define AUX_CHANNELS                POT_CHANNELS
+#define AUX_SAMPLES                 16          // window; the trimmed mean divides by AUX_SAMPLES - 2
+#define AUX_MASK                    0x0F
+#define AUX_FULL                    0x80        // indx flag, window has been filled once
+
+// 21 bytes a channel on the G2553, where the original auxsamp/auxindx pair took 34
+typedef struct {
+    unsigned char   lo[ AUX_SAMPLES ];          // ring of the last AUX_SAMPLES inputs, low 8 bits
+    unsigned char   hi[ AUX_SAMPLES / 4 ];      // and their top 2 bits, slot k's at bit 2 * ( k & 3 )
+    unsigned char   indx;                       // next slot in the low bits, AUX_FULL
+} AUXFILTER;
+
+extern AUXFILTER AuxFilter[ AUX_CHANNELS ];    // no-init, see AuxValid
+
+unsigned int AvgAuxAI( unsigned int newval, unsigned char ch );
+void AuxReset( void );
+int AuxValid( unsigned char ch );
+
+#endif
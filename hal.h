@@ -0,0 +1,76 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                    Hardware Abstraction Layer                                       //
+//                                                                                                     //
+//                                           MSP430G2553                                               //
+//                                                                                                     //
+//                                                                                                     //
+// File              : hal.h                                                                           //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// The firmware includes this header instead of <msp430.h>.  On the target it is <msp430.h> plus a     //
+// few hooks that compile to nothing.  When built with LWC_SIM defined (see sim/Makefile) the          //
+// registers, intrinsics and hooks come from the host simulator instead.                               //
+//                                                                                                     //
+// HAL_IDLE( )          Body of every busy-wait.  The simulator advances its clock to the next         //
+//                      pending peripheral event (timer compare, ADC completion, input edge).          //
+// HAL_DTC_ADDR( p )    Address of a RAM buffer as loaded into ADC10SA.                                //
+// HAL_INFO( a )        Byte pointer to information memory at address a, for reading.                  //
+// HAL_FLASH_WORD( a, w )                                                                              //
+//                      Writes w to the flash word at a; FCTL1 decides whether it programs or erases.  //
+// HAL_NOINIT           Placed on a variable that the C startup must leave alone, so it keeps its      //
+//                      contents over a watchdog or brownout reset.  The simulator keeps these in      //
+//                      section fw_noinit and fills it with noise at power up.                         //
+// HAL_STACK_LOW        First RAM word above the variables, as deep as the stack can go.               //
+// HAL_STACK_TOP        One past the last RAM word, where the stack starts.                            //
+// HAL_SP( )            The stack pointer.  The simulator gives the firmware a block of words for      //
+//                      these three, which its host stack never uses.                                  //
+// HAL_COUNT( n )       Adds one to a bench counter n.  The counters exist only in the simulator, so   //
+//                      they cost the G2553 no RAM.                                                    //
+// HAL_COUNTER          Placed on a bench counter.  The simulator keeps them in section sim_counters,  //
+//                      outside the firmware's RAM: memreport leaves them out and a reset keeps them.  //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef HAL_H
+#define HAL_H
+
+#ifdef LWC_SIM
+
+#include "sim/sim_msp430.h"
+
+#define HAL_IDLE( )             sim_idle( )
+#define HAL_DTC_ADDR( p )       ( ( sim_addr_t )( p ) )
+#define HAL_INFO( a )           sim_info( a )
+#define HAL_FLASH_WORD( a, w )  sim_flash_word( ( a ), ( w ) )
+#define HAL_NOINIT              __attribute__(( section( "fw_noinit" ) ))
+#define HAL_STACK_LOW           ( sim_stack )
+#define HAL_STACK_TOP           ( sim_stack + SIM_STACK_WORDS )
+#define HAL_SP( )               ( sim_stack + SIM_STACK_WORDS )
+#define HAL_COUNT( n )          ( ( n )++ )
+#define HAL_COUNTER             __attribute__(( section( "sim_counters" ) ))
+
+#else
+
+#include <msp430.h>
+
+#define HAL_IDLE( )
+#define HAL_DTC_ADDR( p )       ( ( unsigned int )( p ) )
+#define HAL_INFO( a )           ( ( const unsigned char * )( a ) )
+#define HAL_FLASH_WORD( a, w )  ( *( volatile unsigned int * )( a ) = ( w ) )
+#define HAL_NOINIT              __attribute__(( noinit ))
+
+extern unsigned int end[ ], __stack[ ];         // from the linker script: end of .noinit, top of RAM
+
+#define HAL_STACK_LOW           ( end )
+#define HAL_STACK_TOP           ( __stack )
+#define HAL_SP( )               ( ( unsigned int * )__get_SP_register( ) )
+#define HAL_COUNT( n )          ( ( void )0 )
+#define HAL_COUNTER
+
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                    Board and Controller Definitions                                 //
+//                                                                                                     //
+//                                                                                                     //
+// File              : lwc.h                                                                           //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef LWC_H
+#define LWC_H
+
+#include "hal.h"
+#include "wells.h"
+
+#define SYS_STATUS_LED_ON       P2OUT |= BIT5
+#define SYS_STATUS_LED_OFF      P2OUT &= ~BIT5
+
+// Lit while any well's float reads empty
+#define FLOAT_STATUS_LED_ON     P2OUT |= BIT3
+#define FLOAT_STATUS_LED_OFF    P2OUT &= ~BIT3
+
+#if LWC_WELLS == 1
+
+// Relays active low on P2.0 and P2.1, float on P2.4, each relay with an LED on P1.0 and P1.6
+#define RELAY_OUT               P2OUT
+#define RELAY_DIR               P2DIR
+
+#define SPRAY_FILL_LED_ON( w )  P1OUT |= BIT0
+#define SPRAY_FILL_LED_OFF( w ) P1OUT &= ~BIT0
+
+#define DRAIN_LED_ON( w )       P1OUT |= BIT6
+#define DRAIN_LED_OFF( w )      P1OUT &= ~BIT6
+
+#else
+
+//
+// Multi-well board, the 28 pin G2553: well w's relays are P3.2w (fill) and P3.2w+1 (drain), active
+//  low, and its float is P2.4 for well 0, then P2.0, P2.1, P2.2.  The pump LEDs are on the relay
+//  board, which frees P1.0 and P1.6 for the extra drain pots (see adc.h).
+//
+#define RELAY_OUT               P3OUT
+#define RELAY_DIR               P3DIR
+
+#define SPRAY_FILL_LED_ON( w )  ( ( void )0 )
+#define SPRAY_FILL_LED_OFF( w ) ( ( void )0 )
+
+#define DRAIN_LED_ON( w )       ( ( void )0 )
+#define DRAIN_LED_OFF( w )      ( ( void )0 )
+
+#endif
+
+// Well 0 is the single-well board's pins; the shifts only move the rest
+#define FILL_BIT( w )           ( BIT0 << 2 * ( w ) )
+#define DRAIN_BIT( w )          ( BIT1 << 2 * ( w ) )
+#define RELAY_BITS              ( ( 1 << 2 * LWC_WELLS ) - 1 )
+#define FLOAT_BIT( w )          ( ( w ) ? BIT0 << ( ( w ) - 1 ) : BIT4 )
+#define FLOAT_BITS              ( BIT4 | ( ( 1 << ( LWC_WELLS - 1 ) ) - 1 ) )
+
+#define SPRAY_FILL_RELAY_ON( w )    RELAY_OUT &= ~FILL_BIT( w )
+#define SPRAY_FILL_RELAY_OFF( w )   RELAY_OUT |= FILL_BIT( w )
+
+#define DRAIN_RELAY_ON( w )         RELAY_OUT &= ~DRAIN_BIT( w )
+#define DRAIN_RELAY_OFF( w )        RELAY_OUT |= DRAIN_BIT( w )
+
+#define ALL_STOP                    0
+#define RAISE_LEVEL                 1
+#define AERATE                      2
+#define RAISE_LEVEL_IN_DURATION     3
+#define LOWER_LEVEL                 4
+#define RAISE_LEVEL_B4_ALL_STOP     5
+
+#define INDICATES_EMPTY             0
+#define INDICATES_FULL              1
+
+#define ON                          0
+#define OFF                         1
+
+#define FLOAT_SWITCH( w )           (P2IN & FLOAT_BIT( w ))
+
+#define POT_SAMPLE_MS               32          // pot sequence period, 16 samples fill the filter in 0.5 s
+
+// WakeEvents, posted by interrupts to bring the main loop out of LPM3
+#define WAKE_DEADLINE               0x01        // TMR_PUMP expired, see PumpArm()
+#define WAKE_POTS                   0x02        // a filtered pot value changed
+#define WAKE_FLOAT                  0x04        // FloatState changed
+#define WAKE_TELEM                  0x08        // a telemetry frame is due, see telem.c
+#define WAKE_STATS                  0x10        // time to commit the pump statistics, see stats.c
+#define WAKE_RELAY                  0x20        // a relay held by its minimum time may switch, see relay.c
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shared Globals (main.c)                                                                             //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+extern volatile unsigned char WakeEvents;
+
+#endif
@@ -17,77 +17,67 @@
 // dd-mmm-yyyy   v.mm.bbbb       ...                ...                                                //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //                                                                                                     //
+// 17-Oct-2026   1.00.0017       CFL         Relays paced and coalesced by relay.c, drain soft-start.  //
+// 17-Oct-2026   1.00.0016       CFL         Packed pot filter windows, stack high-water mark.         //
+// 17-Oct-2026   1.00.0015       CFL         Up to four wells, each with its own float, relays, state. //
+// 17-Oct-2026   1.00.0014       CFL         Fill/drain rates learned; adaptive build drains alone.    //
+// 17-Oct-2026   1.00.0013       CFL         Watchdog, warm restart from a no-init RAM snapshot.       //
+// 17-Oct-2026   1.00.0012       CFL         Pump hours and relay cycles logged to info flash.         //
+// 17-Oct-2026   1.00.0011       CFL         USCI_A0 telemetry frames, telemetry board variant.        //
+// 17-Oct-2026   1.00.0010       CFL         Binary event trace ring, decoded by sim/tracedump.        //
+// 17-Oct-2026   1.00.0009       CFL         Pump states as a flash transition table, see pumps.c.     //
+// 17-Oct-2026   1.00.0008       CFL         Deadline scheduler; states arm TMR_PUMP, no polling.      //
+// 17-Oct-2026   1.00.0007       CFL         Tickless 32-bit ACLK clock and wraps replace 1 ms 'time'. //
+// 17-Oct-2026   1.00.0006       CFL         Knob times from piecewise-linear tables, hysteresis band. //
+// 17-Oct-2026   1.00.0005       CFL         Pots sampled in background, DTC two-block, ISR filters.   //
+// 17-Oct-2026   1.00.0004       CFL         AvgAuxAI in filter.c, one scan, /14 shifts, ~1058 cycles. //
+// 17-Oct-2026   1.00.0003       CFL         LPM3 between events, TA0 stopped, pots sampled by TA1.    //
+// 17-Oct-2026   1.00.0002       CFL         Float switch debounced from Timer0_A0, no busy-waits.     //
+// 17-Oct-2026   1.00.0001       CFL         Hardware abstraction layer, host simulation build.        //
 // 27-Nov-2019   1.00.0000       CFL         Initial Development.                                      //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-#include <msp430.h>
-
-#define SYS_STATUS_LED_ON       P2OUT |= BIT5
-#define SYS_STATUS_LED_OFF      P2OUT &= ~BIT5
-
-#define FLOAT_STATUS_LED_ON     P2OUT |= BIT3
-#define FLOAT_STATUS_LED_OFF    P2OUT &= ~BIT3
-
-#define SPRAY_FILL_LED_ON       P1OUT |= BIT0
-#define SPRAY_FILL_LED_OFF      P1OUT &= ~BIT0
-
-#define DRAIN_LED_ON            P1OUT |= BIT6
-#define DRAIN_LED_OFF           P1OUT &= ~BIT6
-
-#define SPRAY_FILL_RELAY_ON     P2OUT &= ~BIT0
-#define SPRAY_FILL_RELAY_OFF    P2OUT |= BIT0
-
-#define DRAIN_RELAY_ON          P2OUT &= ~BIT1
-#define DRAIN_RELAY_OFF         P2OUT |= BIT1
-
-#define ALL_STOP                    0
-#define RAISE_LEVEL                 1
-#define AERATE                      2
-#define RAISE_LEVEL_IN_DURATION     3
-#define LOWER_LEVEL                 4
-#define RAISE_LEVEL_B4_ALL_STOP     5
-
-#define INDICATES_EMPTY             0
-#define INDICATES_FULL              1
-
-#define ON                          0
-#define OFF                         1
-
-#define FLOAT_SWITCH                (P2IN & BIT4)
+#include "lwc.h"
+#include "debounce.h"
+#include "adc.h"
+#include "cal.h"
+#include "timebase.h"
+#include "sched.h"
+#include "pumps.h"
+#include "relay.h"
+#include "trace.h"
+#include "telem.h"
+#include "stats.h"
+#include "warm.h"
+#include "adapt.h"
+#include "stack.h"
 
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Global Variables                                                                                    //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-volatile unsigned long time;
-volatile unsigned long CycleIntervalTime, CycleDurationTime, DrainDurationTime;
-unsigned int Status_LED_cnt;
-volatile unsigned int cdtmr0;
-unsigned int ADC_ConversionResults[3];
+volatile unsigned char WakeEvents;
 
-int AerateStatus = 0;
-int LiveWellState = ALL_STOP;
-int Draining = 0;
+// MainBeat, how far the main loop has got since WatchdogTick last looked
+#define BEAT_STALE                  0           // awake and already seen by WatchdogTick
+#define BEAT_AWAKE                  1           // started a pass
+#define BEAT_ASLEEP                 2           // in LPM3 waiting for an event
 
-unsigned long tAerate;
-unsigned long tLower;
-
-unsigned int auxsamp[3][16];
-unsigned int auxindx[3];
+static volatile unsigned char MainBeat;
 
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Function Prototypes                                                                                 //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-void ReadPots( void );
-void LiveWellAllStop( void );
-void LiveWellRaiseLevel( void );
-void LiveWellLowerLevel( void );
-void LiveWellAerate( void );
-void ManagePumps( void );
-unsigned int AvgAuxAI( unsigned int newval, unsigned char ch );
+int ReadPots( void );
+int ReadDrainPot( unsigned char w, unsigned int pot );
+void FloatLed( void );
+void StatusLedTick( TBTICKS now );
+void PotTick( TBTICKS now );
+void FloatSample( TBTICKS now );
+void WatchdogTick( TBTICKS now );
 
 //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -105,35 +95,47 @@ unsigned int AvgAuxAI( unsigned int newval, unsigned char ch );
 //
 int main( void ) {
 
+    unsigned char events, w;
+    int changed, warm;
+    TBTICKS start;
+
     //
-    // Stop Watchdog Timer
+    // Stop Watchdog Timer, it is started again once the pumps are running
     //
     WDTCTL = WDTPW | WDTHOLD;
+
+    // Before anything else runs, so everything the stack reaches from here on shows up
+    StackPaint();
 	
     BCSCTL1 = CALBC1_1MHZ;
     DCOCTL = CALDCO_1MHZ;
 
+    // A watchdog or brownout reset that left the snapshot and the pot filters intact carries on
+    warm = WarmStart();
+
     //
-    // Setup Timer TA0, SMCLK/1, Cont Mode
+    // Timer TA0 stays stopped but for LWC_SOFTSTART's gate PWM (relay.c); SMCLK is off in LPM3, so all
+    //  periodic work runs from TA1 on ACLK
     //
-    TA0CTL = TASSEL_2 + MC_2 + TACLR;
-    // Configure TA0CCR0 for 1 millisecond
-    TA0CCR0 = 1000;
-    TA0CCTL0 |= CCIE;
 
     //
-    // Setup Timer TA1, ACLK/1, Cont Mode
+    // Setup Timer TA1, ACLK/1, Cont Mode; TA1CCR0 follows the next deadline
     //
-    TA1CTL = TASSEL_1 + MC_2 + TACLR;
-    // Configure TA1CCR0 for 1 millisecond
-    TA1CCR0 = 33;
-    TA1CCTL0 |= CCIE;
+#ifndef LWC_NO_WARM
+    TimebaseInit( warm ? WarmSnap.clock : 0, warm ? WarmSnap.epoch : 0 );
+#else
+    TimebaseInit( 0, 0 );
+#endif
+    TRACE_INIT( warm );
+
+    // Periodic deadlines count on from the clock, which a warm restart does not start at zero
+    start = TimeTicks();
 
     //
     // Configure Port Pins
     //
-    P2DIR &= ~BIT4;                             // float switch input
-    P2REN |= BIT4;                              // enable pullup
+    P2DIR &= ~FLOAT_BITS;                       // float switch inputs
+    P2REN |= FLOAT_BITS;                        // enable pullups
 
     SYS_STATUS_LED_OFF;
     P2DIR |= BIT5;
@@ -141,32 +143,42 @@ int main( void ) {
     FLOAT_STATUS_LED_OFF;
     P2DIR |= BIT3;
 
-    SPRAY_FILL_LED_OFF;
+#if LWC_WELLS == 1
+    SPRAY_FILL_LED_OFF( 0 );
     P1DIR |= BIT0;
 
-    DRAIN_LED_OFF;
+    DRAIN_LED_OFF( 0 );
     P1DIR |= BIT6;
+#endif
 
-    SPRAY_FILL_RELAY_OFF;
-    P2DIR |= BIT0;
+    RELAY_OUT |= RELAY_BITS;                    // every relay off before its pin drives
+    RELAY_DIR |= RELAY_BITS;
+    RelayInit();
 
-    DRAIN_RELAY_OFF;
-    P2DIR |= BIT1;
+    // Timer1_A0 starts a sequence every POT_SAMPLE_MS, the first as soon as interrupts are on
+    AdcInit();
 
-    ADC10CTL1 = INCH_3 + CONSEQ_1;              // A3/A2/A1, single sequence
-    ADC10CTL0 = ADC10SHT_3 + MSC + ADC10ON;
-    ADC10DTC1 = 0x03;                           // 3 conversions
-    ADC10AE0 |= 0x0E;                           // P1.3,2,1 ADC10 option select
+    // 9600 baud telemetry on P1.2, telemetry board only
+    TELEM_INIT();
 
-    // Can't run for more than 49 days continous
-    time = 0L;
+    FloatDebounceInit();
 
-    ReadPots();
+    // Pump totals so far from information flash, commits every STATS_COMMIT_MIN
+    STATS_INIT();
+
+    // Periodic work starts at the first dispatch
+    SchedArm( TMR_STATUS_LED, start, StatusLedTick );
+    SchedArm( TMR_POTS, start, PotTick );
+    SchedArm( TMR_FLOAT, start, FloatSample );
 
     //
-    // Unused port save power
+    // Unused port save power; on the multi-well board P3 also holds the relays, left off
     //
+#if LWC_WELLS == 1
     P3OUT = 0;
+#else
+    P3OUT = RELAY_BITS;
+#endif
     P3DIR = 0xFF;
 
     //
@@ -174,31 +186,69 @@ int main( void ) {
     //
     _EINT( );
 
-    // Determine where to start
-    if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-        cdtmr0 = 5; while( cdtmr0 );
-        if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-            cdtmr0 = 5; while( cdtmr0 );
-            if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                LiveWellRaiseLevel();
-                LiveWellState = RAISE_LEVEL;
-            }
+#ifndef LWC_NO_WARM
+    if( warm ) {
+        // Float, pots and relays as they were saved, then the saved state, all without waiting
+        WarmRestore();
+        RelayResume( &WarmSnap );
+        ReadPots();
+        PumpResume( &WarmSnap );
+    } else
+#endif
+    {
+        // Determine where to start, once every float has settled and every pot has been read
+        for( w = 0; w < LWC_WELLS; w++ ) {
+            while( FloatState[ w ] == FLOAT_UNKNOWN ) HAL_IDLE( );
         }
-    } else {
-        LiveWellAerate();
-        tLower = tAerate = time;
-        AerateStatus = 2;
-        LiveWellState = AERATE;
+        while( PotDirty != POT_ALL ) HAL_IDLE( );
+        ReadPots();
     }
 
+    FloatLed();
+
+    // ALL_STOP goes to RAISE_LEVEL or AERATE on each float level; after a warm restart it only catches up
+    PumpUpdate();
+    RelayCommit();
+    WARM_SAVE();
+
+    // From here on a main loop that stops going round is reset within 1.5 s
+    WDT_KICK();
+    SchedArm( TMR_WATCHDOG, start, WatchdogTick );
+
 	while(1) {
 
-        ReadPots();
+        //
+        // Sleep in LPM3 until an interrupt posts an event.  GIE and LPM3 are set together, so an
+        //  event posted after the test still wakes us.
+        //
+        __disable_interrupt();
+        MainBeat = BEAT_ASLEEP;
+        if( !WakeEvents ) __bis_SR_register( LPM3_bits + GIE );
+
+        __disable_interrupt();
+        MainBeat = BEAT_AWAKE;
+        events = WakeEvents;
+        WakeEvents = 0;
+        __enable_interrupt();
+
+        changed = events & ( WAKE_DEADLINE | WAKE_FLOAT );
+
+        if( events & WAKE_POTS ) changed |= ReadPots();
+
+        if( events & WAKE_FLOAT ) FloatLed();
+
+        if( changed ) PumpUpdate();
+
+        // Relays asked for on this pass, or held by their minimum time until now
+        RelayCommit();
+
+        if( events & WAKE_TELEM ) TELEM_SEND();
 
-        if( !FLOAT_SWITCH ) FLOAT_STATUS_LED_ON;
-        else FLOAT_STATUS_LED_OFF;
+        // Flash writes stall the CPU, so they come after the pumps have been serviced
+        if( events & WAKE_STATS ) STATS_COMMIT();
 
-        ManagePumps();
+        WARM_SAVE();
+        StackCheck();
 	}
 }
 
@@ -209,124 +259,47 @@ int main( void ) {
 //                                                                                                     //
 //                                                                                                     //
 //                                                                                                     //
-// Description:                                                                                        //
-// Arguments:                                                                                          //
-// Returns:                                                                                            //
+// Description: Updates the knob derived times from the pots ADC10_ISR marked dirty.                   //
+// Arguments:   None                                                                                   //
+// Returns:     Nonzero when a time or a drain override changed                                        //
 //                                                                                                     //
-// Notes/Warnings/Caveats:                                                                             //
+// Notes/Warnings/Caveats: Channels that have not moved are not looked up again (see cal.c).           //
 //                                                                                                     //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-void ManagePumps( void ) {
+int ReadPots( void ) {
 
-    static unsigned long tNow;
+    unsigned long interval = CycleIntervalTime, duration = CycleDurationTime;
+    unsigned int pot[ POT_CHANNELS ];
+    unsigned char dirty, ch, w;
+    int changed;
 
-    if( Draining ) return;
+    __disable_interrupt();
+    dirty = PotDirty;
+    PotDirty = 0;
+    for( ch = 0; ch < POT_CHANNELS; ch++ ) pot[ ch ] = PotFiltered[ ch ];
+    __enable_interrupt();
 
-    switch( LiveWellState ) {
+    // 0 to 10 minutes >> 0 to 600,000 ms
+    if( dirty & ( 1 << POT_INTERVAL ) ) {
+        CycleIntervalTime = CalLookup( CalInterval, pot[ POT_INTERVAL ] );
+        TRACE_KNOB( TR_INTERVAL, interval >> 12, CycleIntervalTime >> 12 );
+    }
 
-    default:
-    case ALL_STOP:
-        LiveWellAllStop();
-        break;
+    // 0 to 10 minutes >> 0 to 600,000 ms
+    if( dirty & ( 1 << POT_DURATION ) ) {
+        CycleDurationTime = CalLookup( CalDuration, pot[ POT_DURATION ] );
+        TRACE_KNOB( TR_DURATION, duration >> 12, CycleDurationTime >> 12 );
+    }
 
-    case RAISE_LEVEL:
+    changed = interval != CycleIntervalTime || duration != CycleDurationTime;
 
-        // WAIT FOR filled up
-        if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-            cdtmr0 = 5; while( cdtmr0 );
-            if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                cdtmr0 = 5; while( cdtmr0 );
-                if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                    break;
-                }
-            }
-        }
-        tAerate = time;
-        AerateStatus = 1;
-        LiveWellAllStop();
-        LiveWellState = AERATE;
-        break;
-
-    case RAISE_LEVEL_IN_DURATION:
-
-        // WAIT FOR filled up
-        if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-            cdtmr0 = 5; while( cdtmr0 );
-            if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                cdtmr0 = 5; while( cdtmr0 );
-                if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                    break;
-                }
-            }
-        }
-        LiveWellAerate();
-        LiveWellState = AERATE;
-        break;
-
-    case RAISE_LEVEL_B4_ALL_STOP:
-
-        // WAIT FOR filled up
-        if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-            cdtmr0 = 5; while( cdtmr0 );
-            if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                cdtmr0 = 5; while( cdtmr0 );
-                if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                    break;
-                }
-            }
-        }
-        AerateStatus = 1;
-        tAerate = time;
-        LiveWellState = AERATE;
-        LiveWellAllStop();
-        break;
-
-    case LOWER_LEVEL:
-        tNow = time;
-        if( tNow - tLower > DrainDurationTime ) {
-            LiveWellRaiseLevel();
-            LiveWellState = RAISE_LEVEL_IN_DURATION;
-        }
-        break;
-
-    case AERATE:
-
-        tNow = time;
-
-        if( AerateStatus == 1 ) {
-            if( tNow - tAerate > CycleIntervalTime ) {
-                AerateStatus = 2;
-                tAerate = time;
-                LiveWellAerate();
-            }
-        } else {
-            if( tNow - tAerate > CycleDurationTime ) {
-                LiveWellRaiseLevel();
-                LiveWellState = RAISE_LEVEL_B4_ALL_STOP;
-            } else {
-                //
-                // Check for level FALLING, Pump out exceeds pump in
-                //  because fill tube is 1/2 inch ID and pump out tube
-                //  is 3/4" ID.
-                //
-                if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                    cdtmr0 = 5; while( cdtmr0 );
-                    if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                        cdtmr0 = 5; while( cdtmr0 );
-                        if( FLOAT_SWITCH == INDICATES_EMPTY ) {
-                            tLower = time;
-                            LiveWellState = LOWER_LEVEL;
-                            LiveWellLowerLevel();
-                        }
-                    }
-                }
-            }
-        }
-        break;
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        if( dirty & ( 1 << POT_WELL_DRAIN( w ) ) ) changed |= ReadDrainPot( w, pot[ POT_WELL_DRAIN( w ) ] );
     }
-}
 
+    return( changed );
+}
 
 
 //
@@ -334,62 +307,65 @@ void ManagePumps( void ) {
 //                                                                                                     //
 //                                                                                                     //
 //                                                                                                     //
-// Description:                                                                                        //
-// Arguments:                                                                                          //
-// Returns:                                                                                            //
+// Description: Updates a well's drain time, or its drain override with the knob fully down.           //
+// Arguments:   w   - well                                                                             //
+//              pot - its filtered drain pot                                                           //
+// Returns:     Nonzero when the time or the override changed                                          //
 //                                                                                                     //
-// Notes/Warnings/Caveats:                                                                             //
+// Notes/Warnings/Caveats: The override asks for the drain pump itself and holds the well's machine.   //
 //                                                                                                     //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-void ReadPots( void ) {
+int ReadDrainPot( unsigned char w, unsigned int pot ) {
 
-    unsigned long i;
+    unsigned long drain = DrainDurationTime[ w ];
+    unsigned char draining = Draining[ w ];
 
-    ADC10SA = (unsigned int)ADC_ConversionResults;      // Data buffer start
-    ADC10CTL0 |= ENC + ADC10SC;                         // Sampling and conversion start
+    if( pot < 6 ) {
+        if( !Draining[ w ] ) TRACE_W( TR_DRAIN, w, 1 );
+        Draining[ w ] = 1;
+        RelaySet( w, RELAY_DRAIN );
+    } else {
+        // 0 to 10 seconds >> 0 to 10,000 ms
+        DrainDurationTime[ w ] = CalLookup( CalDrain, pot );
+        TRACE_KNOB_W( TR_DRAIN_TIME, w, drain >> 6, DrainDurationTime[ w ] >> 6 );
+        if( Draining[ w ] ) {
+            TRACE_W( TR_DRAIN, w, 0 );
+            Draining[ w ] = 0;
+            PumpDrive( w );                     // PumpUpdate catches up with the float and the timeouts
+        }
+    }
 
-    while( ADC10CTL1 & ADC10BUSY )                      // Wait if ADC10 core is active
-                 ;
-    ADC10CTL0 &= ~ENC;
+    if( draining != Draining[ w ] ) AdaptCancel( w );
 
-    i = AvgAuxAI( ADC_ConversionResults[2], 2 );
-    // 0 to 10 minutes >> 0 to 600,000 ms
-    // Calculated a slope and offset from a linear regression curve fit
-    //  to make the potentiometer ADC counts match the time scale of the knob/dial
-    i = ( i * 557074 ) + 28097185;
-    i /= 1000;
-    CycleIntervalTime = i;
+    return( drain != DrainDurationTime[ w ] || draining != Draining[ w ] );
+}
 
 
-    i = AvgAuxAI( ADC_ConversionResults[1], 1);
-    // 0 to 10 minutes >> 0 to 600,000 ms
-    // Calculated a slope and offset from a linear regression curve fit
-    //  to make the potentiometer ADC counts match the time scale of the knob/dial
-    i = ( i * 554866 ) + 42290131;
-    i /= 1000;
-    CycleDurationTime = i;
-
-
-    i = AvgAuxAI( ADC_ConversionResults[0], 0);
-    if( i < 6 ) {
-        Draining = 1;
-        DRAIN_RELAY_ON;
-        DRAIN_LED_ON;
-        SPRAY_FILL_RELAY_OFF;
-        SPRAY_FILL_LED_OFF;
-    } else {
-        // 0 to 10 seconds >> 0 to 10,000 ms
-        // Calculated a slope and offset from a linear regression curve fit
-        //  to make the potentiometer ADC counts match the time scale of the knob/dial
-        i = ( i * 9211 ) + 499849;
-        i /= 1000;
-        DrainDurationTime = i;
-        if( Draining ) {
-            Draining = 0;
-            LiveWellAllStop();
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Lights the float LED while any well's float reads empty.                               //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: None                                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void FloatLed( void ) {
+
+    unsigned char w;
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        if( FloatState[ w ] == INDICATES_EMPTY ) {
+            FLOAT_STATUS_LED_ON;
+            return;
         }
     }
+    FLOAT_STATUS_LED_OFF;
 }
 
 
@@ -406,40 +382,62 @@ void ReadPots( void ) {
 //                                                                                                     //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-void LiveWellAllStop( void ) {
+// Timer A1 CCR0 interrupt service routine (DERIVED FROM 32.768 Khz ACLK XTAL)                         //
+//  Runs only when a scheduler timer is due.
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void Timer1_A0( void ) {
 
-    DRAIN_RELAY_OFF;
-    DRAIN_LED_OFF;
+    SchedDispatch();
 
-    SPRAY_FILL_RELAY_OFF;
-    SPRAY_FILL_LED_OFF;
+    if( WakeEvents ) __bic_SR_register_on_exit( LPM3_bits );
 }
 
-void LiveWellRaiseLevel( void ) {
 
-    DRAIN_RELAY_OFF;
-    DRAIN_LED_OFF;
-
-    SPRAY_FILL_RELAY_ON;
-    SPRAY_FILL_LED_ON;
-}
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: TMR_STATUS_LED handler, blinks the status LED at 5 Hz.                                 //
+// Arguments:   now - unused                                                                           //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Re-arms itself from its own deadline so the blink never drifts.             //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void StatusLedTick( TBTICKS now ) {
 
-void LiveWellLowerLevel( void ) {
+    static unsigned char sled = 0;
 
-    DRAIN_RELAY_ON;
-    DRAIN_LED_ON;
+    ( void )now;
+    sled ^= 1;
+    if( sled ) SYS_STATUS_LED_ON;
+    else SYS_STATUS_LED_OFF;
 
-    SPRAY_FILL_RELAY_ON;
-    SPRAY_FILL_LED_ON;
+    SCHED_EVERY( TMR_STATUS_LED, 100, StatusLedTick );
 }
 
-void LiveWellAerate( void ) {
 
-    DRAIN_RELAY_ON;
-    DRAIN_LED_ON;
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: TMR_POTS handler, starts a pot sequence every POT_SAMPLE_MS.                           //
+// Arguments:   now - unused                                                                           //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: None                                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void PotTick( TBTICKS now ) {
+
+    ( void )now;
+    AdcStart();
 
-    SPRAY_FILL_RELAY_ON;
-    SPRAY_FILL_LED_ON;
+    SCHED_EVERY( TMR_POTS, POT_SAMPLE_MS, PotTick );
 }
 
 
@@ -448,31 +446,23 @@ void LiveWellAerate( void ) {
 //                                                                                                     //
 //                                                                                                     //
 //                                                                                                     //
-// Description:                                                                                        //
-// Arguments:                                                                                          //
-// Returns:                                                                                            //
+// Description: TMR_WATCHDOG handler, kicks the watchdog while the main loop is healthy.               //
+// Arguments:   now - dispatch time                                                                    //
+// Returns:     Nothing                                                                                //
 //                                                                                                     //
-// Notes/Warnings/Caveats:                                                                             //
+// Notes/Warnings/Caveats: Asleep counts as healthy, so LPM3 needs no extra wakes.  A pass still       //
+//                         running at a second tick gets no kick, and the watchdog bites 1 s after     //
+//                         the last one.  Also moves the warm restart snapshot's clock on.             //
 //                                                                                                     //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-// Timer A0 interrupt service routine
-#pragma vector=TIMER0_A0_VECTOR
-__interrupt void Timer0_A0( void ) {
+void WatchdogTick( TBTICKS now ) {
 
-    static unsigned char sled = 0;
-
-    if( ++Status_LED_cnt == 100 ) {
-        Status_LED_cnt = 0;
-        sled ^= 1;
-        if( sled ) SYS_STATUS_LED_ON;
-        else SYS_STATUS_LED_OFF;
-    }
-
-    if( cdtmr0 ) cdtmr0--;
+    if( MainBeat != BEAT_STALE ) WDT_KICK();
+    if( MainBeat == BEAT_AWAKE ) MainBeat = BEAT_STALE;
+    WARM_CLOCK( now );
 
-    // Interrupt every 1 Millisecond
-    TA0CCR0 = TA0R + 1000;
+    SCHED_EVERY( TMR_WATCHDOG, WDT_KICK_MS, WatchdogTick );
 }
 
 
@@ -481,22 +471,27 @@ __interrupt void Timer0_A0( void ) {
 //                                                                                                     //
 //                                                                                                     //
 //                                                                                                     //
-// Description:                                                                                        //
-// Arguments:                                                                                          //
-// Returns:                                                                                            //
+// Description: TMR_FLOAT handler, one debounce sample of the float switches.                          //
+// Arguments:   now - dispatch time                                                                    //
+// Returns:     Nothing                                                                                //
 //                                                                                                     //
-// Notes/Warnings/Caveats:                                                                             //
+// Notes/Warnings/Caveats: Keeps itself armed at 1 ms only while a debounce run is in progress;        //
+//                         Port_2 arms it again on the next edge.  The samples are 32 or 33 ticks      //
+//                         apart, 1 ms on average, so FLOAT_DEBOUNCE_MS is what the float waits.       //
 //                                                                                                     //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-// Timer A1 CCR0 interrupt service routine (DERIVED FROM 32.768 Khz ACLK XTAL)
-#pragma vector=TIMER1_A0_VECTOR
-__interrupt void Timer1_A0( void ) {
+void FloatSample( TBTICKS now ) {
 
-    time++;
+    unsigned char changed = FloatDebounce( now ), w;
 
-    // Interrupt every 1 millisecond
-    TA1CCR0 = TA1R + 33;
+    if( changed ) {
+        for( w = 0; w < LWC_WELLS; w++ ) {
+            if( changed & ( 1 << w ) ) TRACE_AT( TR_FLOAT | w << TR_WELL_SHIFT, FloatState[ w ], FloatSince[ w ] );
+        }
+        WakeEvents |= WAKE_FLOAT;
+    }
+    if( FloatDebouncing() ) SCHED_EVERY( TMR_FLOAT, 1, FloatSample );
 }
 
 
@@ -505,41 +500,25 @@ __interrupt void Timer1_A0( void ) {
 //                                                                                                     //
 //                                                                                                     //
 //                                                                                                     //
-// Description:                                                                                        //
-// Arguments:                                                                                          //
-// Returns:                                                                                            //
+// Description: Float switch edge on any of FLOAT_BITS, P2.4 for well 0.                               //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
 //                                                                                                     //
-// Notes/Warnings/Caveats:                                                                             //
+// Notes/Warnings/Caveats: Only restarts the debounce; the CPU is woken when the level has settled.    //
 //                                                                                                     //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-//
-// Rolling average, 8 terms, throw away highest and lowest
-//
-unsigned int AvgAuxAI( unsigned int newval, unsigned char ch ) {
+#pragma vector=PORT2_VECTOR
+__interrupt void Port_2( void ) {
 
-    unsigned long tlwrk;
-    unsigned long tmp, min, max;
-    unsigned char u0;
+    unsigned char bits = P2IFG & FLOAT_BITS, w;
 
-    auxsamp[ ch ][ auxindx[ ch ]++ & 0x0F ] = newval;
-
-    if( auxindx[ ch ] & 0x10 ) auxindx[ ch ] |= 0x80;
-    auxindx[ ch ] &= 0x8F;
-
-    if( auxindx[ ch ] & 0x80 ){
-        min = 1024;
-        max = 0;
-        for( tlwrk = 0, u0 = 0; u0 < 16; ){
-            tlwrk += tmp = auxsamp[ ch ][ u0++ ];
-            if( tmp < min ) min = tmp;
-            if( tmp > max ) max = tmp;
+    P2IFG &= ~bits;
+    FloatEdge( bits );
+    if( !SchedArmed( TMR_FLOAT ) ) {
+        for( w = 0; w < LWC_WELLS; w++ ) {
+            if( bits & FLOAT_BIT( w ) ) TRACE_W( TR_EDGE, w, FLOAT_SWITCH( w ) != 0 );
         }
-        tlwrk -= min;
-        tlwrk -= max;
-        tlwrk /= 14;
-
-        newval = ( unsigned int )tlwrk;
+        SchedArm( TMR_FLOAT, TimeTicks(), FloatSample );                       // start sampling now
     }
-    return( newval );
 }
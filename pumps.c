@@ -0,0 +1,563 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Pump State Machine                                         //
+//                                                                                                     //
+//                                                                                                     //
+// File              : pumps.c                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// The fill/drain sequence as a table of ( guard, action, next state ) indexed by state and event,     //
+// kept in flash.  Dispatch is one lookup, an optional guard call and an action call, whatever the     //
+// state.  Every cell is written out, ignored events included: ROW() takes exactly one cell per event, //
+// so a row that forgets an event does not compile, and a missing row fails the size check below.      //
+// sim/fsmcheck runs every action and checks the relays it leaves against PumpRelaysAllowed.           //
+//                                                                                                     //
+// Each well runs its own copy of the machine from the one table: the state is kept as one small array //
+// per field, indexed by well, and every guard and action gets the well it acts for.  The wells share  //
+// TMR_PUMP, armed for the earliest of their timeouts.                                                 //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "adapt.h"
+#include "debounce.h"
+#include "sched.h"
+#include "pumps.h"
+#include "relay.h"
+#include "trace.h"
+#include "warm.h"
+
+volatile unsigned long CycleIntervalTime, CycleDurationTime;
+volatile unsigned long DrainDurationTime[ LWC_WELLS ];
+
+unsigned char AerateStatus[ LWC_WELLS ];
+unsigned char LiveWellState[ LWC_WELLS ];                   // ALL_STOP
+unsigned char Draining[ LWC_WELLS ];
+
+static TBTICKS tAerate[ LWC_WELLS ];
+static TBTICKS tLower[ LWC_WELLS ];
+static TBTIME48 tEntered[ LWC_WELLS ];                      // when each well entered its state, from its event
+static TBTICKS PumpDue[ LWC_WELLS ];                        // when each well's timeout is due
+
+// Event TMR_PUMP will post for each well, and those posted but not yet dispatched
+static unsigned char PumpArmed[ LWC_WELLS ] = WELLS_OF( EV_NONE );
+static volatile unsigned char PumpTimeout[ LWC_WELLS ] = WELLS_OF( EV_NONE );
+
+static void PumpExpired( TBTICKS now );
+static unsigned char PumpPost( TBTICKS now );
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Guards and Actions                                                                                  //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static int Aerating( unsigned char w ) {
+
+    return( AerateStatus[ w ] == 2 );
+}
+
+// Float full at power up, aerate from now
+static void StartAerate( unsigned char w ) {
+
+    tLower[ w ] = tAerate[ w ] = tEntered[ w ].ticks;
+    AerateStatus[ w ] = 2;
+    LiveWellAerate( w );
+}
+
+// Filled up, rest for CycleIntervalTime
+static void Rest( unsigned char w ) {
+
+    tAerate[ w ] = tEntered[ w ].ticks;
+    AerateStatus[ w ] = 1;
+    LiveWellAllStop( w );
+}
+
+// Rest over, aerate for CycleDurationTime; an adapted well rested longer and lowers first, the fill
+// pump left off, its period timed from before the longer part of the rest
+static void Aerate( unsigned char w ) {
+
+    AerateStatus[ w ] = 2;
+    tAerate[ w ] = tEntered[ w ].ticks - MsToTicks( AdaptRestTime( w, 0 ) );
+    if( AdaptAerate( w ) ) LiveWellDrainLevel( w );
+    else LiveWellAerate( w );
+}
+
+// Topped up after a drain, carry on with the same aeration period
+static void Resume( unsigned char w ) {
+
+    LiveWellAerate( w );
+}
+
+//
+// Check for level FALLING, Pump out exceeds pump in                                                   //
+//  because fill tube is 1/2 inch ID and pump out tube                                                 //
+//  is 3/4" ID.                                                                                        //
+//
+static void Lower( unsigned char w ) {
+
+    tLower[ w ] = tEntered[ w ].ticks;
+    if( AdaptLower( w ) ) LiveWellDrainLevel( w );  // the fill pump is still off from the rest
+    else LiveWellLowerLevel( w );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Transition Table                                                                                    //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#if PUMP_EVENTS != 5
+#error ROW() takes one cell per event
+#endif
+
+#define ROW( full, empty, interval, duration, drained ) { full, empty, interval, duration, drained }
+#define GO( guard, action, next )   { guard, action, next }
+#define IGNORE                      { 0, 0, PUMP_STAY }
+
+const PUMPTRANS PumpTable[][ PUMP_EVENTS ] = {
+
+    [ ALL_STOP ] = ROW(
+        GO( 0, StartAerate, AERATE ),                                           // EV_FULL
+        GO( 0, LiveWellRaiseLevel, RAISE_LEVEL ),                               // EV_EMPTY
+        IGNORE,                                                                 // EV_INTERVAL
+        IGNORE,                                                                 // EV_DURATION
+        IGNORE                                                                  // EV_DRAINED
+    ),
+
+    [ RAISE_LEVEL ] = ROW(
+        GO( 0, Rest, AERATE ),                                                  // EV_FULL
+        IGNORE,                                                                 // EV_EMPTY
+        IGNORE,                                                                 // EV_INTERVAL
+        IGNORE,                                                                 // EV_DURATION
+        IGNORE                                                                  // EV_DRAINED
+    ),
+
+    [ AERATE ] = ROW(
+        IGNORE,                                                                 // EV_FULL
+        GO( Aerating, Lower, LOWER_LEVEL ),                                     // EV_EMPTY
+        GO( 0, Aerate, AERATE ),                                                // EV_INTERVAL
+        GO( 0, LiveWellRaiseLevel, RAISE_LEVEL_B4_ALL_STOP ),                   // EV_DURATION
+        IGNORE                                                                  // EV_DRAINED
+    ),
+
+    [ RAISE_LEVEL_IN_DURATION ] = ROW(
+        GO( 0, Resume, AERATE ),                                                // EV_FULL
+        IGNORE,                                                                 // EV_EMPTY
+        IGNORE,                                                                 // EV_INTERVAL
+        IGNORE,                                                                 // EV_DURATION
+        IGNORE                                                                  // EV_DRAINED
+    ),
+
+    [ LOWER_LEVEL ] = ROW(
+        IGNORE,                                                                 // EV_FULL
+        IGNORE,                                                                 // EV_EMPTY
+        IGNORE,                                                                 // EV_INTERVAL
+        IGNORE,                                                                 // EV_DURATION
+        GO( 0, LiveWellRaiseLevel, RAISE_LEVEL_IN_DURATION )                    // EV_DRAINED
+    ),
+
+    [ RAISE_LEVEL_B4_ALL_STOP ] = ROW(
+        GO( 0, Rest, AERATE ),                                                  // EV_FULL
+        IGNORE,                                                                 // EV_EMPTY
+        IGNORE,                                                                 // EV_INTERVAL
+        IGNORE,                                                                 // EV_DURATION
+        IGNORE                                                                  // EV_DRAINED
+    ),
+};
+
+// Fails to compile unless there is one row per state
+typedef char PumpTableRowsCheck[ ( sizeof( PumpTable ) / sizeof( PumpTable[ 0 ] ) == PUMP_STATES )
+                                 ? 1 : -1 ];
+
+const unsigned char PumpRelaysAllowed[ PUMP_STATES ] = {
+    RELAYS_OFF,                                 // ALL_STOP
+    RELAYS_FILL,                                // RAISE_LEVEL
+    RELAYS_OFF | RELAYS_BOTH | RELAYS_DRAIN,    // AERATE, resting or aerating, adapted starts drain alone
+    RELAYS_FILL,                                // RAISE_LEVEL_IN_DURATION
+    RELAYS_BOTH | RELAYS_DRAIN,                 // LOWER_LEVEL, drain alone once adapted
+    RELAYS_FILL,                                // RAISE_LEVEL_B4_ALL_STOP
+};
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Times a well's event and moves its state entry time to it.                             //
+// Arguments:   w  - well                                                                              //
+//              ev - event about to run                                                                //
+// Returns:     Milliseconds the well spent in the state it is leaving                                 //
+//                                                                                                     //
+// Notes/Warnings/Caveats: A float event is timed from when the float settled, FloatStableSince, or    //
+//                         from when the well entered its state if the float already read so then; the //
+//                         rest from now.  A call of its own, so the 48-bit times are off the stack    //
+//                         before the actions and AdaptStep run (see cyclebench).                      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned long PumpEnter( unsigned char w, unsigned char ev ) {
+
+    TBTIME48 now, at;
+    unsigned long ms;
+
+    TimeNow48( &now );
+    at = now;
+    if( ev == EV_FULL || ev == EV_EMPTY ) {
+        TimeRecent48( &at, FloatStableSince( w ), &now );
+        if( TimeSince48( &at, &tEntered[ w ] ) ) at = tEntered[ w ];
+    }
+    ms = TicksToMs( TimeSince48( &tEntered[ w ], &at ) );
+    tEntered[ w ] = at;                         // the actions take their start times from it
+    return( ms );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Runs the transition for ev in a well's current state.                                  //
+// Arguments:   w  - well                                                                              //
+//              ev - EV_FULL .. EV_DRAINED, EV_NONE is ignored                                         //
+// Returns:     Nonzero if a transition ran, even one back into the same state                         //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Does nothing while the drain override holds the well.  PumpEnter times it.  //
+//                         AdaptFloat sees every event first, ignored ones too.                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int PumpEvent( unsigned char w, unsigned char ev ) {
+
+    const PUMPTRANS *t;
+    unsigned char from;
+    unsigned long ms;
+
+    if( Draining[ w ] || ev >= PUMP_EVENTS ) return( 0 );
+    AdaptFloat( w, ev );
+
+    t = &PumpTable[ LiveWellState[ w ] ][ ev ];
+    if( t->next == PUMP_STAY ) return( 0 );
+    if( t->guard && !t->guard( w ) ) return( 0 );
+
+    ms = PumpEnter( w, ev );
+
+    TRACE_W( TR_STATE, w, ( ev << 4 ) | t->next );
+    from = LiveWellState[ w ];
+    t->action( w );
+    LiveWellState[ w ] = t->next;
+    AdaptStep( w, from, ev, t->next, ms );
+    return( 1 );
+}
+
+static unsigned char FloatEvent( unsigned char w ) {
+
+    if( FloatState[ w ] == INDICATES_FULL ) return( EV_FULL );
+    if( FloatState[ w ] == INDICATES_EMPTY ) return( EV_EMPTY );
+    return( EV_NONE );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Brings every well up to date after a float, a knob or TMR_PUMP changed.                //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: A pending timeout is dispatched instead of the float level, as the old      //
+//                         switch checked one or the other.  A new state may already be satisfied      //
+//                         (e.g. the float is full on entry), so the float level is re-applied after   //
+//                         every transition until one is ignored, and TMR_PUMP is re-armed for where   //
+//                         they settled.  That includes AERATE's EV_INTERVAL back into AERATE: a float //
+//                         that went empty during the rest then lowers the level at once.  Every float //
+//                         transition leaves a state that ignores the same level, so this ends.        //
+//                         A timeout the new states have already passed is taken on the same pass, so  //
+//                         the relays are only asked for where the machine comes to rest.              //
+//                         A well whose float and timeout have not moved goes round once for nothing.  //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void PumpUpdate( void ) {
+
+    unsigned char ev[ LWC_WELLS ], w, overdue;
+
+    do {
+        __disable_interrupt();
+        for( w = 0; w < LWC_WELLS; w++ ) {
+            ev[ w ] = PumpTimeout[ w ];
+            PumpTimeout[ w ] = EV_NONE;
+        }
+        __enable_interrupt();
+
+        for( w = 0; w < LWC_WELLS; w++ ) {
+            if( ev[ w ] == EV_NONE ) ev[ w ] = FloatEvent( w );
+
+            while( PumpEvent( w, ev[ w ] ) ) ev[ w ] = FloatEvent( w );
+        }
+
+        PumpArm();
+
+        // The knob minimums keep every timeout tens of seconds long, so this goes round a few times at most
+        __disable_interrupt();
+        overdue = PumpPost( TimeTicks() );
+        __enable_interrupt();
+    } while( overdue );
+}
+
+// Arms TMR_PUMP for the earliest timeout still armed, with interrupts off
+static void PumpSchedule( void ) {
+
+    TBTICKS at = 0;
+    unsigned char w, armed = 0;
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        if( PumpArmed[ w ] == EV_NONE ) continue;
+        if( !armed++ || TB_BEFORE( PumpDue[ w ], at ) ) at = PumpDue[ w ];
+    }
+
+    if( !armed ) SchedCancel( TMR_PUMP );
+    else SchedArm( TMR_PUMP, at, PumpExpired );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Works out the timeout of each well's current state and arms TMR_PUMP for the           //
+//              earliest.                                                                              //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: The timeout runs from the state's own start time, so a knob turned          //
+//                         mid-state takes effect at once, and one that is already overdue fires       //
+//                         straight away.  States that only the float or a knob can end have no        //
+//                         timeout, and neither does a well under the drain override.  A start time    //
+//                         is only good for the 36 hours the clock takes to wrap; one left longer      //
+//                         under the override may time out again up to that late.                      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void PumpArm( void ) {
+
+    TBTICKS now = TimeTicks(), from = 0, at = 0;
+    unsigned long limit = 0;
+    unsigned char w, ev;
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+
+        ev = EV_NONE;
+        if( !Draining[ w ] ) switch( LiveWellState[ w ] ) {
+
+        case LOWER_LEVEL:
+            from = tLower[ w ];
+            limit = MsToTicks( AdaptLowerTime( w, DrainDurationTime[ w ] ) );
+            ev = EV_DRAINED;
+            break;
+
+        case AERATE:
+            from = tAerate[ w ];
+            if( AerateStatus[ w ] == 1 ) {
+                limit = MsToTicks( AdaptRestTime( w, CycleIntervalTime ) );
+                ev = EV_INTERVAL;
+            } else {
+                limit = MsToTicks( CycleDurationTime );
+                ev = EV_DURATION;
+            }
+            break;
+        }
+
+        // Measured as time gone rather than a deadline, so an overdue one is still overdue after a wrap
+        if( ev != EV_NONE ) at = now - from >= limit ? now : from + limit;
+
+        __disable_interrupt();
+        if( ev != EV_NONE ) PumpTimeout[ w ] = EV_NONE;
+        PumpArmed[ w ] = ev;
+        PumpDue[ w ] = at;
+        __enable_interrupt();
+    }
+
+    __disable_interrupt();
+    PumpSchedule();
+    __enable_interrupt();
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: TMR_PUMP handler, the earliest armed timeout is due.                                   //
+// Arguments:   now - time the handler runs                                                            //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Runs from Timer1_A0.  Posts every well that is due, as two may time         //
+//                         out together, and re-arms for the rest; PumpUpdate dispatches the           //
+//                         events in the main loop.                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static void PumpExpired( TBTICKS now ) {
+
+    PumpPost( now );
+    WakeEvents |= WAKE_DEADLINE;
+}
+
+// Posts every well whose timeout is due by now and re-arms for the rest; nonzero if any was
+static unsigned char PumpPost( TBTICKS now ) {
+
+    unsigned char w, posted = 0;
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        if( PumpArmed[ w ] == EV_NONE || !TB_DUE( PumpDue[ w ], now ) ) continue;
+        TRACE_W( TR_TIMEOUT, w, PumpArmed[ w ] );
+        PumpTimeout[ w ] = PumpArmed[ w ];
+        PumpArmed[ w ] = EV_NONE;
+        posted = 1;
+    }
+    if( posted ) PumpSchedule();
+    return( posted );
+}
+
+#ifndef LWC_NO_WARM
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Copies every well's state and start times into a warm restart snapshot.                //
+// Arguments:   s - snapshot being filled                                                              //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Interrupts must be off; WarmSave seals the record.                          //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void PumpSave( WARMSNAP *s ) {
+
+    unsigned char w;
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        s->state[ w ] = LiveWellState[ w ];
+        s->status[ w ] = AerateStatus[ w ];
+        s->aerate[ w ] = tAerate[ w ];
+        s->lower[ w ] = tLower[ w ];
+    }
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Picks every well up from a warm restart snapshot and drives its relays.                //
+// Arguments:   s - snapshot WarmStart accepted                                                        //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Call after ReadPots, which may have put a drain override back on, and       //
+//                         follow with PumpUpdate: that re-arms TMR_PUMP and catches up with a float   //
+//                         change or a timeout the reset cut off.                                      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void PumpResume( const WARMSNAP *s ) {
+
+    unsigned char w;
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+
+        LiveWellState[ w ] = s->state[ w ];
+        AerateStatus[ w ] = s->status[ w ];
+        tAerate[ w ] = s->aerate[ w ];
+        tLower[ w ] = s->lower[ w ];
+        TimeNow48( &tEntered[ w ] );
+
+        if( !Draining[ w ] ) PumpDrive( w );
+    }
+}
+
+#endif
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Drives a well's relays for the state it is in, after something else had them.          //
+// Arguments:   w - well                                                                               //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: For a warm restart and the end of the drain override.  The raise states     //
+//                         have no timeout and only the float ends them, so leaving their fill pump    //
+//                         off would leave the well empty for good.                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void PumpDrive( unsigned char w ) {
+
+    switch( LiveWellState[ w ] ) {
+
+    case ALL_STOP:
+        LiveWellAllStop( w );
+        break;
+
+    case AERATE:
+        if( Aerating( w ) ) LiveWellAerate( w );
+        else LiveWellAllStop( w );
+        break;
+
+    case LOWER_LEVEL:
+        AdaptCancel( w );                       // both pumps, the fill pump is back on
+        LiveWellLowerLevel( w );
+        break;
+
+    default:
+        LiveWellRaiseLevel( w );
+        break;
+    }
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Relay combinations, each one asks the output stage for both pumps of a well.           //
+// Arguments:   w - well                                                                               //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Aerating and lowering drive the same two pumps; RelaySet coalesces one      //
+//                         after the other, and RelayCommit drives the pins and the LEDs.              //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void LiveWellAllStop( unsigned char w ) {
+
+    RelaySet( w, 0 );
+}
+
+void LiveWellRaiseLevel( unsigned char w ) {
+
+    RelaySet( w, RELAY_FILL );
+}
+
+void LiveWellLowerLevel( unsigned char w ) {
+
+    RelaySet( w, RELAY_FILL | RELAY_DRAIN );
+}
+
+void LiveWellDrainLevel( unsigned char w ) {
+
+    RelaySet( w, RELAY_DRAIN );
+}
+
+void LiveWellAerate( unsigned char w ) {
+
+    RelaySet( w, RELAY_FILL | RELAY_DRAIN );
+}
@@ -0,0 +1,77 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Pump State Machine                                         //
+//                                                                                                     //
+//                                                                                                     //
+// File              : pumps.h                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef PUMPS_H
+#define PUMPS_H
+
+#include "timebase.h"
+#include "warm.h"
+#include "wells.h"
+
+// States are ALL_STOP .. RAISE_LEVEL_B4_ALL_STOP (lwc.h)
+#define PUMP_STATES                 6
+
+// Events; the float level is delivered as EV_FULL / EV_EMPTY, the rest are TMR_PUMP timeouts
+#define EV_FULL                     0
+#define EV_EMPTY                    1
+#define EV_INTERVAL                 2           // CycleIntervalTime over, resting -> aerating
+#define EV_DURATION                 3           // CycleDurationTime over, aerating -> top up
+#define EV_DRAINED                  4           // DrainDurationTime over
+#define PUMP_EVENTS                 5
+
+#define EV_NONE                     0xFF
+
+#define PUMP_STAY                   0xFF        // next state of a cell that ignores its event
+
+// Relay combinations a state may drive, one bit per ( fill on ) | ( drain on << 1 )
+#define RELAYS_OFF                  0x01        // both off
+#define RELAYS_FILL                 0x02        // fill only
+#define RELAYS_DRAIN                0x04        // drain only, the drain override or lowering alone
+#define RELAYS_BOTH                 0x08        // both on, aerating or lowering
+
+// Guards and actions get the well they act for
+typedef struct {
+    int ( *guard )( unsigned char w );          // 0 or must return nonzero for the transition to run
+    void ( *action )( unsigned char w );        // sets both relays; 0 only with PUMP_STAY
+    unsigned char next;                         // new state or PUMP_STAY
+} PUMPTRANS;
+
+extern const PUMPTRANS PumpTable[][ PUMP_EVENTS ];       // [ state ][ event ], in flash
+extern const unsigned char PumpRelaysAllowed[ PUMP_STATES ];
+
+// One of each per well
+extern unsigned char LiveWellState[ LWC_WELLS ];
+extern unsigned char AerateStatus[ LWC_WELLS ];             // 1 resting, 2 aerating
+extern unsigned char Draining[ LWC_WELLS ];                 // drain override, the machine is held
+extern volatile unsigned long DrainDurationTime[ LWC_WELLS ];
+
+// Shared, the aeration schedule is the boat's
+extern volatile unsigned long CycleIntervalTime, CycleDurationTime;
+
+unsigned long PumpEnter( unsigned char w, unsigned char ev );
+int PumpEvent( unsigned char w, unsigned char ev );
+void PumpUpdate( void );
+void PumpArm( void );
+#ifndef LWC_NO_WARM
+void PumpSave( WARMSNAP *s );
+void PumpResume( const WARMSNAP *s );
+#endif
+void PumpDrive( unsigned char w );
+
+void LiveWellAllStop( unsigned char w );
+void LiveWellRaiseLevel( unsigned char w );
+void LiveWellLowerLevel( unsigned char w );
+void LiveWellDrainLevel( unsigned char w );
+void LiveWellAerate( unsigned char w );
+
+#endif
@@ -0,0 +1,360 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Relay Output Stage                                         //
+//                                                                                                     //
+//                                                                                                     //
+// File              : relay.c                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// The relay helpers and the drain override only say which pumps a well wants; the main loop commits   //
+// the wants once a pass, after PumpUpdate.  A pass that asks for a combination and then takes it back //
+// (a timeout overdue behind a resume, LOWER_LEVEL's both pumps then AERATE's same two) never reaches  //
+// the pins, and asking again for what is already driven costs nothing.                                //
+//                                                                                                     //
+// A relay that switched stays as it is for RELAY_MIN_ON_MS or RELAY_MIN_OFF_MS, so a float sloshing   //
+// on its trip point cannot chatter a pump.  A want that has to wait arms TMR_RELAY for when it may    //
+// go, and the commit on that pass drives it if it is still wanted.  The one exception is the fill     //
+// going off with the float full, which happens at once, as holding it could only overfill the well.   //
+// The float's debounce is far shorter than a hold, so everything else the float asks for waits: the   //
+// drain starts up to RELAY_MIN_OFF_MS late with the float full and stops up to RELAY_MIN_ON_MS late   //
+// with it empty, which the well's headroom either side of the trip absorbs.  After a reset every      //
+// relay is free to switch at once, but a warm restart carries on with the relays and their times as   //
+// they were.                                                                                          //
+// The LEDs, TR_RELAYS and StatsRelays follow the relays as they are driven.                           //
+//                                                                                                     //
+// Built with LWC_SOFTSTART, the drain pump of the single-well board is also switched by a MOSFET      //
+// whose gate is the drain LED's pin, P1.6, which is TA0.1.  The relay closes with the gate driven by  //
+// TA0 in up mode off ACLK, its duty going up a step every RELAY_SOFT_MS / RELAY_SOFT_STEPS from       //
+// TMR_RELAY, and at full duty TA0 stops and the pin holds high as a plain output.  Switching off      //
+// takes the gate low before the relay opens, so the contacts never break the motor's current.         //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "debounce.h"
+#include "relay.h"
+#include "sched.h"
+#include "stats.h"
+#include "trace.h"
+
+#if defined( LWC_SOFTSTART ) && LWC_WELLS > 1
+#error LWC_SOFTSTART needs the drain LED pin, which only the single-well board has
+#endif
+
+#define RELAY_HOLD( on )            ( ( on ) ? TB_TICKS( RELAY_MIN_ON_MS ) : TB_TICKS( RELAY_MIN_OFF_MS ) )
+#define SOFT_STEP_TICKS             TB_TICKS( RELAY_SOFT_MS / RELAY_SOFT_STEPS )
+
+#ifdef LWC_SIM
+HAL_COUNTER unsigned long RelayAsked[ RELAY_PUMPS ];        // bench counters, HAL_COUNT only
+HAL_COUNTER unsigned long RelayCoalesced;
+HAL_COUNTER unsigned long RelaySoftStarts;
+#endif
+
+static unsigned char RelayWant[ LWC_WELLS ];                // as last asked
+static unsigned char RelayOn[ LWC_WELLS ];                  // as driven
+static TBTIME48 RelaySince[ LWC_WELLS ][ RELAY_PUMPS ];     // last switched, a hold ago after a reset
+static TBTICKS RelayHeld;                                   // earliest held want may go
+static unsigned char RelayHolding;                          // RelayHeld is set
+static volatile unsigned char RelayPending;                 // the next commit has something to do
+
+#ifndef LWC_NO_WARM
+// Fails to compile unless the warm restart snapshot has room for every relay's time; it keeps the ticks
+typedef char RelaySnapCheck[ sizeof( WarmSnap.since ) / sizeof( TBTICKS ) == LWC_WELLS * RELAY_PUMPS ? 1 : -1 ];
+#endif
+
+#ifdef LWC_SOFTSTART
+static unsigned char SoftStep;                              // ramp step under way, 0 while idle
+static TBTICKS SoftNext;
+
+// Gate on ramps up from the lowest duty, gate off stops the ramp wherever it is
+static void SoftGate( unsigned char on, TBTICKS now ) {
+
+    if( on ) {
+        TA0CCR0 = RELAY_PWM_TICKS - 1;
+        TA0CCR1 = RELAY_PWM_TICKS / RELAY_SOFT_STEPS;
+        TA0CCTL1 = OUTMOD_7;                    // reset/set, high from 0 to TA0CCR1
+        TA0CTL = TASSEL_1 + MC_1 + TACLR;
+        P1SEL |= BIT6;                          // TA0.1 drives the gate
+        SoftStep = 1;
+        SoftNext = now + SOFT_STEP_TICKS;
+        HAL_COUNT( RelaySoftStarts );
+    } else {
+        P1SEL &= ~BIT6;                         // back to P1OUT, whatever it holds
+        TA0CTL = MC_0;
+        SoftStep = 0;
+    }
+}
+
+static void SoftRamp( TBTICKS now ) {
+
+    if( ++SoftStep < RELAY_SOFT_STEPS ) {
+        TA0CCR1 = SoftStep * ( RELAY_PWM_TICKS / RELAY_SOFT_STEPS );
+        SoftNext = now + SOFT_STEP_TICKS;
+        return;
+    }
+    SoftGate( 0, now );                         // full on, P1OUT already holds the gate high
+}
+#endif
+
+static void RelayTick( TBTICKS now );
+
+// Nonzero if switching pump, a RELAY_* bit, to on is well w's fill going off with its float full
+static int RelayOverfills( unsigned char w, unsigned char pump, unsigned char on ) {
+
+    return( pump == RELAY_FILL && !on && FloatState[ w ] == INDICATES_FULL );
+}
+
+// Interrupts must be off; TMR_RELAY follows the held wants and the ramp
+static void RelayArm( void ) {
+
+    TBTICKS at = RelayHeld;
+    unsigned char armed = RelayHolding;
+
+#ifdef LWC_SOFTSTART
+    if( SoftStep && ( !armed++ || TB_BEFORE( SoftNext, at ) ) ) at = SoftNext;
+#endif
+    if( !armed ) SchedCancel( TMR_RELAY );
+    else SchedArm( TMR_RELAY, at, RelayTick );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: TMR_RELAY handler, a held want may go or the ramp takes its next step.                 //
+// Arguments:   now - time the handler runs                                                            //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Runs from Timer1_A0.  Only posts WAKE_RELAY for a held want, as switching   //
+//                         a relay adds to the pump statistics, which the main loop owns.              //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static void RelayTick( TBTICKS now ) {
+
+#ifdef LWC_SOFTSTART
+    if( SoftStep && TB_DUE( SoftNext, now ) ) SoftRamp( now );
+#endif
+    if( RelayHolding && TB_DUE( RelayHeld, now ) ) {
+        RelayHolding = 0;
+        RelayPending = 1;
+        WakeEvents |= WAKE_RELAY;
+    }
+    RelayArm();
+}
+
+// Drives well w's relays and LEDs to relays; interrupts must be off
+static void RelayDrive( unsigned char w, unsigned char relays, TBTICKS now ) {
+
+    TRACE_W( TR_RELAYS, w, relays );
+    STATS_RELAYS( w, relays );
+
+    if( relays & RELAY_DRAIN ) {
+        DRAIN_RELAY_ON( w );
+#ifdef LWC_SOFTSTART
+        if( !( RelayOn[ w ] & RELAY_DRAIN ) ) SoftGate( 1, now );
+#endif
+        DRAIN_LED_ON( w );
+    } else {
+        DRAIN_LED_OFF( w );
+#ifdef LWC_SOFTSTART
+        SoftGate( 0, now );
+#endif
+        DRAIN_RELAY_OFF( w );
+    }
+
+    if( relays & RELAY_FILL ) {
+        SPRAY_FILL_RELAY_ON( w );
+        SPRAY_FILL_LED_ON( w );
+    } else {
+        SPRAY_FILL_RELAY_OFF( w );
+        SPRAY_FILL_LED_OFF( w );
+    }
+
+    RelayOn[ w ] = relays;
+    ( void )now;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Takes the relays as the pins now drive them as wanted and driven, every one free to    //
+//              switch.                                                                                //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: At startup, once every relay pin is an output and the clock is running.     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void RelayInit( void ) {
+
+    TBTIME48 now, idle;
+    unsigned char w, p;
+
+    TimeNow48( &now );
+    TimeRecent48( &idle, now.ticks - RELAY_HOLD( 1 ) - RELAY_HOLD( 0 ), &now );
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        RelayOn[ w ] = RelayWant[ w ] = ( !( RELAY_OUT & FILL_BIT( w ) ) ? RELAY_FILL : 0 ) |
+                                        ( !( RELAY_OUT & DRAIN_BIT( w ) ) ? RELAY_DRAIN : 0 );
+        for( p = 0; p < RELAY_PUMPS; p++ ) RelaySince[ w ][ p ] = idle;
+    }
+    RelayHolding = 0;
+    RelayPending = 0;
+
+#ifdef LWC_SOFTSTART
+    TA0CTL = MC_0;
+    TA0CCTL1 = 0;
+    P1SEL &= ~BIT6;
+    SoftStep = 0;
+#endif
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Asks for a well's relays, for the next RelayCommit.                                    //
+// Arguments:   w      - well                                                                          //
+//              relays - RELAY_FILL | RELAY_DRAIN, either or both or neither                           //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Main loop only.                                                             //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void RelaySet( unsigned char w, unsigned char relays ) {
+
+    unsigned char p;
+
+    if( relays == RelayWant[ w ] ) {
+        HAL_COUNT( RelayCoalesced );
+        return;
+    }
+    for( p = 0; p < RELAY_PUMPS; p++ ) {
+        if( relays & ~RelayWant[ w ] & ( 1 << p ) ) HAL_COUNT( RelayAsked[ p ] );
+    }
+    RelayWant[ w ] = relays;
+    RelayPending = 1;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Drives every want whose relay has been as it is for long enough, and arms TMR_RELAY    //
+//              for the rest.                                                                          //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Main loop only, once a pass after PumpUpdate.  Returns at once unless a     //
+//                         want changed or one is held, for the float may have let it go.  Runs with   //
+//                         interrupts off, so RelayTick always sees the relays, the ramp and TMR_RELAY //
+//                         agree.  A relay is held by the time gone since it switched, taken from      //
+//                         TimeNow48, so one left alone for a wrap of the clock or more is free.       //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void RelayCommit( void ) {
+
+    TBTIME48 now;
+    TBTICKS at;
+    unsigned long hold;
+    unsigned char w, p, drive;
+
+    if( !RelayPending && !RelayHolding ) return;
+
+    __disable_interrupt();
+    RelayPending = 0;
+    RelayHolding = 0;
+    TimeNow48( &now );
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        drive = RelayOn[ w ];
+        for( p = 0; p < RELAY_PUMPS; p++ ) {
+            if( !( ( RelayWant[ w ] ^ drive ) & ( 1 << p ) ) ) continue;
+            hold = RELAY_HOLD( drive & ( 1 << p ) );
+            if( TimeSince48( &RelaySince[ w ][ p ], &now ) + TB_MIN_AHEAD >= hold
+             || RelayOverfills( w, 1 << p, !( drive & ( 1 << p ) ) ) ) {
+                drive ^= 1 << p;
+                RelaySince[ w ][ p ] = now;
+                continue;
+            }
+            at = RelaySince[ w ][ p ].ticks + hold;
+            if( !RelayHolding++ || TB_BEFORE( at, RelayHeld ) ) RelayHeld = at;
+        }
+        if( drive != RelayOn[ w ] ) RelayDrive( w, drive, now.ticks );
+    }
+
+    RelayArm();
+    __enable_interrupt();
+}
+
+#ifndef LWC_NO_WARM
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Copies every relay as driven, and when it last switched, into a warm restart snapshot. //
+// Arguments:   s - snapshot being filled                                                              //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Interrupts must be off; WarmSave seals the record.                          //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void RelaySave( WARMSNAP *s ) {
+
+    unsigned char w, p;
+
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        s->relays[ w ] = RelayOn[ w ];
+        for( p = 0; p < RELAY_PUMPS; p++ ) s->since[ w ][ p ] = RelaySince[ w ][ p ].ticks;
+    }
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Drives the relays as a warm restart snapshot left them, each still held for what is    //
+//              left of its minimum time.                                                              //
+// Arguments:   s - snapshot WarmStart accepted                                                        //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Call after RelayInit and before PumpResume, which only asks for the same    //
+//                         relays again.  The snapshot keeps the ticks alone, so a relay last switched //
+//                         over a wrap before the reset is held as if it had switched a wrap later.    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void RelayResume( const WARMSNAP *s ) {
+
+    TBTIME48 now;
+    unsigned char w, p;
+
+    __disable_interrupt();
+    TimeNow48( &now );
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        for( p = 0; p < RELAY_PUMPS; p++ ) TimeRecent48( &RelaySince[ w ][ p ], s->since[ w ][ p ], &now );
+        RelayWant[ w ] = s->relays[ w ] & ( RELAY_FILL | RELAY_DRAIN );
+        if( RelayWant[ w ] != RelayOn[ w ] ) RelayDrive( w, RelayWant[ w ], now.ticks );
+    }
+    __enable_interrupt();
+}
+
+#endif
@@ -0,0 +1,53 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Relay Output Stage                                         //
+//                                                                                                     //
+//                                                                                                     //
+// File              : relay.h                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef RELAY_H
+#define RELAY_H
+
+#include "warm.h"
+#include "wells.h"
+
+// Shortest time a relay stays on, and off, before it switches again, unless it is the fill going off with
+// the float full
+#ifndef RELAY_MIN_ON_MS
+#define RELAY_MIN_ON_MS             2000
+#endif
+#ifndef RELAY_MIN_OFF_MS
+#define RELAY_MIN_OFF_MS            2000
+#endif
+
+// LWC_SOFTSTART, single-well board: the drain pump's MOSFET gate on P1.6 (TA0.1) ramps up its duty
+#define RELAY_SOFT_MS               512         // zero to full on
+#define RELAY_SOFT_STEPS            16
+#define RELAY_PWM_TICKS             64          // ACLK ticks a PWM period, 512 Hz
+
+// RelaySet's relays, as StatsRelays and TR_RELAYS take them
+#define RELAY_FILL                  0x01
+#define RELAY_DRAIN                 0x02
+#define RELAY_PUMPS                 2
+
+#ifdef LWC_SIM
+extern unsigned long RelayAsked[ RELAY_PUMPS ];     // off to on asks, fill and drain, every well
+extern unsigned long RelayCoalesced;                // asks for what was already asked
+extern unsigned long RelaySoftStarts;               // drain starts ramped on the gate
+#endif
+
+void RelayInit( void );
+void RelaySet( unsigned char w, unsigned char relays );
+void RelayCommit( void );
+#ifndef LWC_NO_WARM
+void RelaySave( WARMSNAP *s );
+void RelayResume( const WARMSNAP *s );
+#endif
+
+#endif
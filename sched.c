@@ -0,0 +1,198 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Deadline Scheduler                                         //
+//                                                                                                     //
+//                                                                                                     //
+// File              : sched.c                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// A fixed pool of SCHED_TIMERS one-shot timers kept in a binary min-heap on their expiry time, so the //
+// earliest is always at the root.  Arming, re-arming and cancelling cost O(log n) and nothing is ever //
+// allocated.  Timer1_A0 calls SchedDispatch, which runs every handler that is due and then sets       //
+// TA1CCR0 for the new root; nothing else polls the clock.  A periodic timer re-arms itself from its   //
+// handler with SCHED_EVERY.  Expiries are ordered by TB_BEFORE, which holds across the clock's wrap   //
+// because no timer is ever armed more than minutes ahead.                                             //
+//                                                                                                     //
+// A timer's heap slot is found by scanning the heap, at most SCHED_TIMERS bytes, rather than kept in  //
+// a table of its own: RAM is the scarce part on the G2553, and the scan is only needed to re-arm or   //
+// cancel a timer that is already armed, never to dispatch one.                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "sched.h"
+
+static TBTICKS SchedAt[ SCHED_TIMERS ];
+static SCHEDFN SchedFn[ SCHED_TIMERS ];
+static unsigned char SchedFrac[ SCHED_TIMERS ]; // 1/125ths of a tick carried into the next period
+static unsigned char Heap[ SCHED_TIMERS ];      // timer ids, Heap[ 0 ] expires first
+static unsigned char HeapLen;
+
+// Heap slot + 1 of timer id, 0 while it is idle
+static unsigned char HeapSlot( unsigned char id ) {
+
+    unsigned char i = HeapLen;
+
+    while( i && Heap[ i - 1 ] != id ) i--;
+    return( i );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Moves the timer at heap slot i up or down until the heap is ordered again.             //
+// Arguments:   i - slot whose expiry changed                                                          //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Interrupts must be off.                                                     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static void HeapFix( unsigned char i ) {
+
+    unsigned char id = Heap[ i ];
+    unsigned char parent, child;
+
+    while( i && TB_BEFORE( SchedAt[ id ], SchedAt[ Heap[ parent = ( i - 1 ) >> 1 ] ] ) ) {
+        Heap[ i ] = Heap[ parent ];
+        i = parent;
+    }
+
+    while( ( child = ( i << 1 ) + 1 ) < HeapLen ) {
+        if( child + 1 < HeapLen
+         && TB_BEFORE( SchedAt[ Heap[ child + 1 ] ], SchedAt[ Heap[ child ] ] ) ) child++;
+        if( !TB_BEFORE( SchedAt[ Heap[ child ] ], SchedAt[ id ] ) ) break;
+        Heap[ i ] = Heap[ child ];
+        i = child;
+    }
+
+    Heap[ i ] = id;
+}
+
+// Takes the timer at heap slot i out of the heap
+static void HeapRemove( unsigned char i ) {
+
+    if( i == --HeapLen ) return;
+    Heap[ i ] = Heap[ HeapLen ];
+    HeapFix( i );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Arms a timer, or moves it if it is already armed.                                      //
+// Arguments:   id - TMR_*, at - expiry in ticks, fn - handler                                         //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: An expiry already in the past runs at the next dispatch.  Safe from any     //
+//                         context; from outside Timer1_A0 it wakes the dispatcher if it has to.       //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void SchedArm( unsigned char id, TBTICKS at, SCHEDFN fn ) {
+
+    unsigned int sr = __get_SR_register( );
+    unsigned char i;
+
+    __disable_interrupt( );
+
+    SchedAt[ id ] = at;
+    SchedFn[ id ] = fn;
+    SchedFrac[ id ] = 0;
+    if( !( i = HeapSlot( id ) ) ) Heap[ i = HeapLen++ ] = id;
+    else i--;
+    HeapFix( i );
+
+    if( Heap[ 0 ] == id ) TimebaseKick( at );
+
+    if( sr & GIE ) __enable_interrupt( );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Re-arms a periodic timer one period on from the expiry it has just run for.            //
+// Arguments:   id - TMR_*, whole - period in ticks, frac - plus 1/125ths of a tick, fn - handler      //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: From the timer's own handler only: the timer is idle, SchedAt still holds   //
+//                         the expiry and SchedDispatch sets the alarm once the handlers are done, so  //
+//                         it goes straight into the heap, no deeper on the stack than SchedArm.       //
+//                         SCHED_EVERY splits a period in ms at compile time.  The fraction carries    //
+//                         over in SchedFrac, so the period averages exactly and never drifts;         //
+//                         SchedArm starts the count afresh.                                           //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void SchedEvery( unsigned char id, TBTICKS whole, unsigned char frac, SCHEDFN fn ) {
+
+    TBTICKS at = SchedAt[ id ] + whole;
+
+    frac += SchedFrac[ id ];
+
+    if( frac >= 125 ) {
+        frac -= 125;
+        at++;
+    }
+    SchedAt[ id ] = at;
+    SchedFn[ id ] = fn;
+    SchedFrac[ id ] = frac;
+    Heap[ HeapLen ] = id;
+    HeapFix( HeapLen++ );
+}
+
+void SchedCancel( unsigned char id ) {
+
+    unsigned int sr = __get_SR_register( );
+    unsigned char i;
+
+    __disable_interrupt( );
+    if( ( i = HeapSlot( id ) ) != 0 ) HeapRemove( i - 1 );
+    if( sr & GIE ) __enable_interrupt( );
+}
+
+int SchedArmed( unsigned char id ) {
+
+    return( HeapSlot( id ) != 0 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Runs the handlers that are due and sets the alarm for the next one.                    //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Called from Timer1_A0 only.  Anything closer than TimebaseAlarm can set is  //
+//                         treated as due, so a handler may run up to TB_MIN_AHEAD ticks early.        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void SchedDispatch( void ) {
+
+    TBTICKS now;
+    unsigned char id;
+
+    do {
+        now = TimebaseUpdate();
+
+        while( HeapLen && TB_DUE( SchedAt[ id = Heap[ 0 ] ], now ) ) {
+            HeapRemove( 0 );
+            SchedFn[ id ]( now );
+        }
+
+    } while( TimebaseAlarm( HeapLen ? SchedAt[ Heap[ 0 ] ] : now + TB_MAX_AHEAD ) );
+}
@@ -0,0 +1,46 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Deadline Scheduler                                         //
+//                                                                                                     //
+//                                                                                                     //
+// File              : sched.h                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "timebase.h"
+
+// Timer ids; each one is either armed once or idle
+#define TMR_STATUS_LED              0
+#define TMR_POTS                    1
+#define TMR_FLOAT                   2
+#define TMR_PUMP                    3
+#define TMR_STATS                   4
+#define TMR_WATCHDOG                5
+#define TMR_RELAY                   6
+#ifdef LWC_TELEMETRY
+#define TMR_TELEM                   7
+#define SCHED_TIMERS                8
+#else
+#define SCHED_TIMERS                7
+#endif
+
+// Re-arms a periodic timer ms on from its last expiry, from its own handler
+#define SCHED_EVERY( id, ms, fn )   SchedEvery( ( id ), TB_WHOLE( ms ), TB_FRAC( ms ), ( fn ) )
+
+// Runs from Timer1_A0 with interrupts off; now is the clock at dispatch
+typedef void ( *SCHEDFN )( TBTICKS now );
+
+void SchedArm( unsigned char id, TBTICKS at, SCHEDFN fn );
+void SchedEvery( unsigned char id, TBTICKS whole, unsigned char frac, SCHEDFN fn );
+void SchedCancel( unsigned char id );
+int SchedArmed( unsigned char id );
+void SchedDispatch( void );
+
+#endif
@@ -0,0 +1,122 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                         Adaptive Drain Bench                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : adaptbench.c                                                                    //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs each scenario through lwcsim and lwcsim-adaptive, the same firmware built with LWC_ADAPTIVE,   //
+// and compares the pumps: seconds on and starts for each, and the lowest the level went once the      //
+// float had first read full.  Lowering with the drain alone should take the level no lower than both  //
+// pumps did, in less pump time, and without a start more: the adaptive build only runs the drain      //
+// alone where the fill pump is already off, and rests longer to start the refill when it would have.  //
+//                                                                                                     //
+// Exits 1 if a scenario fails to run, if the adaptive build does not save pump time on one, if it     //
+// starts either pump more often than the baseline, or if it takes the level more than MAX_LOWER_ML    //
+// below the baseline.  A recording has no plant, its float plays back whatever the pumps do, so its   //
+// level shows as - and is not checked: underway.rec is there for the float, chattering as it did on   //
+// the water, to show the adaptive build keeps its drain alone for calm water.                         //
+//                                                                                                     //
+// Usage: adaptbench [scenario ...], scenarios/day.txt, tournament.txt, sag.txt, underway.txt and      //
+//        underway.rec by default                                                                      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LOWER_ML            50.0            // a tenth of the float's band in the scenarios
+
+static const char * const defaults[ ] = {
+    "scenarios/day.txt", "scenarios/tournament.txt", "scenarios/sag.txt", "scenarios/underway.txt",
+    "scenarios/underway.rec"
+};
+
+typedef struct {
+    double          fill_s, drain_s;            // seconds on
+    unsigned long   fill_starts, drain_starts;
+    double          level_min;
+    int             plant;                      // level_min is good, not a recording
+} result_t;
+
+// Runs one simulator on a scenario and picks its summary lines apart
+static int run( const char *sim, const char *scenario, result_t *r ) {
+
+    char cmd[ 512 ], line[ 256 ];
+    FILE *p;
+    int found = 0;
+
+    memset( r, 0, sizeof( *r ) );
+    snprintf( cmd, sizeof( cmd ), "./%s -q -f %s", sim, scenario );
+    if( !( p = popen( cmd, "r" ) ) ) {
+        perror( sim );
+        return( -1 );
+    }
+    while( fgets( line, sizeof( line ), p ) ) {
+        if( sscanf( line, "# fill pump %lu starts, %lf s on", &r->fill_starts, &r->fill_s ) == 2 ) found |= 1;
+        if( sscanf( line, "# drain pump %lu starts, %lf s on", &r->drain_starts, &r->drain_s ) == 2 ) found |= 2;
+        if( sscanf( line, "# plant level %lf to", &r->level_min ) == 1 ) found |= 4;
+    }
+    if( pclose( p ) || ( found & 3 ) != 3 ) {
+        fprintf( stderr, "adaptbench: %s did not run %s\n", sim, scenario );
+        return( -1 );
+    }
+    r->plant = ( found & 4 ) != 0;
+    return( 0 );
+}
+
+int main( int argc, char **argv ) {
+
+    const char * const *scenarios = argc > 1 ? ( const char * const * )argv + 1 : defaults;
+    int n = argc > 1 ? argc - 1 : ( int )( sizeof( defaults ) / sizeof( defaults[ 0 ] ) );
+    result_t b, a;
+    char lows[ 16 ];
+    double on_b, on_a;
+    int k, failures = 0;
+
+    printf( "adaptbench: %-26s %19s %19s %15s %9s\n", "", "pump time, s", "starts fill/drain", "lowest, mL",
+            "saved" );
+    printf( "adaptbench: %-26s %9s %9s %9s %9s %7s %7s\n", "scenario", "baseline", "adaptive", "baseline",
+            "adaptive", "base", "adapt" );
+
+    for( k = 0; k < n; k++ ) {
+        if( run( "lwcsim", scenarios[ k ], &b ) || run( "lwcsim-adaptive", scenarios[ k ], &a ) ) {
+            failures++;
+            continue;
+        }
+        on_b = b.fill_s + b.drain_s;
+        on_a = a.fill_s + a.drain_s;
+
+        if( b.plant && a.plant ) snprintf( lows, sizeof( lows ), "%7.0f %7.0f", b.level_min, a.level_min );
+        else snprintf( lows, sizeof( lows ), "%7s %7s", "-", "-" );
+
+        printf( "adaptbench: %-26s %9.0f %9.0f %4lu/%-4lu %4lu/%-4lu %s %8.1f%%\n", scenarios[ k ], on_b, on_a,
+                b.fill_starts, b.drain_starts, a.fill_starts, a.drain_starts, lows,
+                on_b > 0.0 ? 100.0 * ( on_b - on_a ) / on_b : 0.0 );
+
+        if( on_a >= on_b ) {
+            printf( "  %s: no pump time saved\n", scenarios[ k ] );
+            failures++;
+        }
+        if( a.fill_starts > b.fill_starts || a.drain_starts > b.drain_starts ) {
+            printf( "  %s: the adaptive build started the pumps %lu/%lu times more\n", scenarios[ k ],
+                    a.fill_starts > b.fill_starts ? a.fill_starts - b.fill_starts : 0UL,
+                    a.drain_starts > b.drain_starts ? a.drain_starts - b.drain_starts : 0UL );
+            failures++;
+        }
+        if( b.plant && a.plant && a.level_min < b.level_min - MAX_LOWER_ML ) {
+            printf( "  %s: the adaptive build took the level %.0f mL lower\n", scenarios[ k ], b.level_min - a.level_min );
+            failures++;
+        }
+    }
+
+    printf( "adaptbench: %s\n", failures ? "FAILED" : "ok" );
+    return( failures ? 1 : 0 );
+}
@@ -0,0 +1,119 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                    Pot Calibration Table Check                                      //
+//                                                                                                     //
+//                                                                                                     //
+// File              : calbench.c                                                                      //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Compares CalLookup against the regression ReadPots used to evaluate, for every count of every       //
+// knob, and fails if any entry is more than 1 ms off.  Then feeds a noisy knob through AvgAuxAI and   //
+// counts how often the knob times would be recalculated with and without the CAL_HYST band.           //
+//                                                                                                     //
+// Usage: calbench [samples]                                                                           //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../cal.h"
+#include "../filter.h"
+
+typedef struct {
+    const char          *name;
+    const unsigned long *tab;
+    unsigned long       slope, offset;
+} KNOB;
+
+static const KNOB knobs[] = {
+    { "interval", CalInterval, CAL_INTERVAL_SLOPE, CAL_INTERVAL_OFFSET },
+    { "duration", CalDuration, CAL_DURATION_SLOPE, CAL_DURATION_OFFSET },
+    { "drain",    CalDrain,    CAL_DRAIN_SLOPE,    CAL_DRAIN_OFFSET }
+};
+
+#define NKNOBS                  ( sizeof( knobs ) / sizeof( knobs[ 0 ] ) )
+
+// What ReadPots computed before the tables, with the target's 32-bit unsigned long
+static unsigned long regression( const KNOB *k, unsigned int counts ) {
+
+    return( ( unsigned long )( ( ( uint32_t )counts * ( uint32_t )k->slope + ( uint32_t )k->offset ) / 1000 ) );
+}
+
+static unsigned int rng_state = 2463534242u;
+
+static unsigned int rng( void ) {
+
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return( rng_state );
+}
+
+static int check( const KNOB *k ) {
+
+    unsigned int c, exact = 0, worst_at = 0;
+    long err, worst = 0;
+
+    for( c = 0; c < 1024; c++ ) {
+        err = ( long )CalLookup( k->tab, c ) - ( long )regression( k, c );
+        if( !err ) exact++;
+        if( labs( err ) > labs( worst ) ) {
+            worst = err;
+            worst_at = c;
+        }
+    }
+    printf( "  %-10s %4u/1024 exact, worst %+ld ms at %u counts\n", k->name, exact, worst, worst_at );
+    return( labs( worst ) > 1 );
+}
+
+static void recalcs( unsigned long samples ) {
+
+    unsigned long k, plain = 0, banded = 0;
+    unsigned int v, last = 0xFFFF, shown = 0xFFFF;
+    int knob = 512;
+
+    for( k = 0; k < samples; k++ ) {
+        // The knob is turned now and then; the ADC reading wanders a few counts either side of it
+        if( !( k % 2000 ) ) knob = ( int )( rng( ) % 1024 );
+        v = knob + ( rng( ) % 9 ) - 4;
+        if( ( int )v < 0 ) v = 0;
+        if( v > 1023 ) v = 1023;
+
+        v = AvgAuxAI( v, 0 );
+        if( v != last ) plain++;
+        last = v;
+        if( CAL_MOVED( shown, v ) ) {
+            banded++;
+            shown = v;
+        }
+    }
+    printf( "  %lu samples: %lu recalculations on any change, %lu with a +/-%d count band\n",
+            samples, plain, banded, CAL_HYST );
+}
+
+int main( int argc, char **argv ) {
+
+    unsigned long samples = argc > 1 ? strtoul( argv[ 1 ], 0, 0 ) : 200000;
+    unsigned int k;
+    int bad = 0;
+
+    printf( "tables vs regression (%d knots per knob, %u bytes of flash each):\n",
+            CAL_KNOTS, ( unsigned int )( CAL_KNOTS * 4 ) );
+    for( k = 0; k < NKNOBS; k++ ) bad |= check( &knobs[ k ] );
+    if( bad ) {
+        printf( "FAILED: a table is more than 1 ms off the regression\n" );
+        return( 1 );
+    }
+
+    printf( "hysteresis, noisy knob through AvgAuxAI:\n" );
+    recalcs( samples );
+    return( 0 );
+}
@@ -0,0 +1,376 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                        Cycle Count Bench                                            //
+//                                                                                                     //
+//                                                                                                     //
+// File              : cyclebench.c                                                                    //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs the firmware image built for the G2553 on iss430 for some simulated minutes, with noisy pots,  //
+// a knob turned halfway through and a bouncing float every half minute or so, and counts the MCLK     //
+// cycles of the interrupt handlers and the main loop's hot paths: fewest, mean and most per call,     //
+// and the chain of calls under the longest one.  At 1 MHz a cycle is a microsecond.                   //
+//                                                                                                     //
+// Timer1_A0's latency, from TA1CCR0 matching to its first instruction, is the timebase's jitter: the  //
+// compare is absolute, so a late handler does not move the next deadline, but every deadline is late  //
+// by up to the longest stretch the main loop runs with GIE clear, which is reported with where it     //
+// started.                                                                                            //
+//                                                                                                     //
+// The stack is the deepest the main loop went with GIE set plus the deepest any interrupt went below  //
+// where it came in, the worst the two can nest (see iss430.c), or the main loop's own deepest if that //
+// is more, next to the firmware's own StackMax.  It fails if that would reach the variables below it, //
+// or pass the reserve -s gives.  sim/Makefile's STACK_BYTES and wells.h's WELL_STACK_BYTES are what   //
+// it measured.                                                                                        //
+//                                                                                                     //
+// With -b it compares each function's most cycles, the latency, the GIE-off stretch and the stack     //
+// against a baseline written by -w, and fails if any grew by more than -t percent or is not in the    //
+// baseline.  The run is the same every time, so a change in the numbers is a change in the code.  The //
+// counts are the compiler's as much as the code's, so the baseline names the toolchain from the       //
+// image's .comment, and an image another one built is refused rather than compared.                   //
+//                                                                                                     //
+// With -k, and no image, it checks iss430 itself instead: a short program assembled here, one         //
+// instruction of each addressing mode the family guide's tables list, an interrupt taken and left,    //
+// each of which must take the guide's cycles and end on the next instruction.                         //
+//                                                                                                     //
+// Usage: cyclebench [-b baseline] [-w baseline] [-t percent] [-m minutes] [-s bytes] lwc.elf          //
+//        cyclebench -k                                                                                //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iss430.h"
+
+#define STEP_CYC                1000ULL         // inputs change at most once a millisecond
+#define MINUTE_CYC              ( 60ULL * ISS_MCLK_HZ )
+#define FLOAT_PIN               0x10            // P2.4, well 0's float
+#define BOUNCES                 3               // extra edges on every float change
+#define RAM_TOP                 0x0400          // the G2553's stack starts here and grows down to end
+
+#define KNOWN_AT                0xC000          // the -k program, in flash like the firmware
+#define KNOWN_ISR               0xC200          // its Timer1_A0 handler, a RETI
+#define KNOWN_RAM               0x0300          // and the RAM it reads and writes
+#define HERE( b )               ( 0xFF00 | ( b ) )     // an operand: this instruction's address + b
+
+static const char * const watched[ ] = {
+    "Timer1_A0", "ADC10_ISR", "Port_2", "USCI0TX_ISR",
+    "SchedDispatch", "ReadPots", "AvgAuxAI", "PumpUpdate", "PumpEvent", "RelayCommit",
+    "TelemSend", "StatsCommit", "WarmSave",
+};
+#define WATCHED                 ( int )( sizeof( watched ) / sizeof( watched[ 0 ] ) )
+
+typedef struct {
+    char            name[ 32 ];
+    unsigned long   cycles;
+} base_t;
+
+// One instruction for -k, and its MCLK cycles in the MSP430x2xx family guide (tables 3-15, 3-16)
+typedef struct {
+    const char      *text;
+    uint16_t        op[ 3 ];
+    unsigned int    words;                      // 0: the interrupt taken where the program is
+    unsigned int    cycles;
+} known_t;
+
+static const known_t known[ ] = {
+    { "mov #0400h,sp",          { 0x4031, 0x0400 },             2, 2 },
+    { "mov #0300h,r5",          { 0x4035, KNOWN_RAM },          2, 2 },
+    { "mov r5,r6",              { 0x4506 },                     1, 1 },
+    { "mov @r5,r6",             { 0x4526 },                     1, 2 },
+    { "mov @r5+,r6",            { 0x4536 },                     1, 2 },
+    { "mov 2(r5),r6",           { 0x4516, 2 },                  2, 3 },
+    { "mov r6,4(r5)",           { 0x4685, 4 },                  2, 4 },
+    { "mov @r5,6(r5)",          { 0x45A5, 6 },                  2, 5 },
+    { "mov 2(r5),8(r5)",        { 0x4595, 2, 8 },               3, 6 },
+    { "add &0300h,&0302h",      { 0x5292, KNOWN_RAM, KNOWN_RAM + 2 }, 3, 6 },
+    { "mov #0,r7",              { 0x4307 },                     1, 1 },
+    { "add #1,r7",              { 0x5317 },                     1, 1 },
+    { "mov #4,r7",              { 0x4227 },                     1, 1 },
+    { "rra r6",                 { 0x1106 },                     1, 1 },
+    { "rra @r5",                { 0x1125 },                     1, 3 },
+    { "rrc 2(r5)",              { 0x1015, 2 },                  2, 4 },
+    { "swpb r6",                { 0x1086 },                     1, 1 },
+    { "push r6",                { 0x1206 },                     1, 3 },
+    { "push @r5",               { 0x1225 },                     1, 4 },
+    { "push @r5+",              { 0x1235 },                     1, 4 },
+    { "push #1234h",            { 0x1230, 0x1234 },             2, 4 },
+    { "push 2(r5)",             { 0x1215, 2 },                  2, 5 },
+    { "mov @sp+,r8",            { 0x4138 },                     1, 2 },
+    { "jmp $+2",                { 0x3C00 },                     1, 2 },
+    { "jne $+2",                { 0x2000 },                     1, 2 },
+    { "call #$+4",              { 0x12B0, HERE( 4 ) },          2, 5 },
+    { "add #2,sp",              { 0x5321 },                     1, 1 },
+    { "mov #$+6,r9",            { 0x4039, HERE( 6 ) },          2, 2 },
+    { "mov r9,pc",              { 0x4900 },                     1, 2 },
+    { "mov #$+6,r9",            { 0x4039, HERE( 6 ) },          2, 2 },
+    { "call r9",                { 0x1289 },                     1, 4 },
+    { "br #$+4",                { 0x4030, HERE( 4 ) },          2, 3 },
+    { "push #$+8",              { 0x1230, HERE( 8 ) },          2, 4 },
+    { "push #0",                { 0x1203 },                     1, 3 },
+    { "reti",                   { 0x1300 },                     1, 5 },
+    { "push #$+6",              { 0x1230, HERE( 6 ) },          2, 4 },
+    { "ret",                    { 0x4130 },                     1, 3 },
+    { "mov #0011h,&TA1CCTL0",   { 0x40B2, 0x0011, 0x0182 },     3, 5 },
+    { "eint",                   { 0xD232 },                     1, 1 },
+    { "Timer1_A0 taken, reti",  { 0 },                          0, 6 + 5 },
+    { "dint",                   { 0xC232 },                     1, 1 },
+};
+#define KNOWN                   ( int )( sizeof( known ) / sizeof( known[ 0 ] ) )
+
+static base_t base[ ISS_PROFILES + 2 ];
+static int nbase;
+static char base_by[ 128 ];                     // the toolchain the baseline's image came from
+static unsigned long seed = 12345;
+
+// Same numbers every run, so the baseline compares like with like
+static unsigned int rnd( unsigned int n ) {
+
+    seed = seed * 1103515245UL + 12345UL;
+    return( ( unsigned int )( ( seed >> 16 ) & 0x7FFF ) % n );
+}
+
+static long find_base( const char *name ) {
+
+    int k;
+
+    for( k = 0; k < nbase; k++ ) {
+        if( !strcmp( base[ k ].name, name ) ) return( ( long )base[ k ].cycles );
+    }
+    return( -1 );
+}
+
+// Baseline lines are "<name> <most cycles>", after "# built by <toolchain>"
+static int load_base( const char *path ) {
+
+    char line[ 128 ];
+    FILE *f = fopen( path, "r" );
+
+    if( !f ) {
+        perror( path );
+        return( -1 );
+    }
+    while( fgets( line, sizeof( line ), f ) && nbase < ( int )( sizeof( base ) / sizeof( base[ 0 ] ) ) ) {
+        if( !strncmp( line, "# built by ", 11 ) ) {
+            line[ strcspn( line, "\n" ) ] = 0;
+            snprintf( base_by, sizeof( base_by ), "%s", line + 11 );
+        }
+        if( line[ 0 ] == '#' || sscanf( line, "%31s %lu", base[ nbase ].name, &base[ nbase ].cycles ) != 2 ) continue;
+        nbase++;
+    }
+    fclose( f );
+    return( 0 );
+}
+
+// Prints one number against its baseline; 1 if it grew past the tolerance
+static int compare( const char *name, unsigned long now, int tol ) {
+
+    long was = find_base( name );
+
+    if( was < 0 ) {
+        printf( "       new" );
+        return( 1 );
+    }
+    if( ( long )now != was ) printf( " %+9ld", ( long )now - was );
+    else printf( " %9s", "" );
+    if( ( long )now * 100 <= was * ( 100 + tol ) ) return( 0 );
+    printf( " REGRESSED" );
+    return( 1 );
+}
+
+// Drives the pots and the float for the whole run
+static int drive( uint64_t end ) {
+
+    int knob[ 5 ] = { 20, 600, 300, 60, 500 };  // A0 .. A4; A3 is the drain, kept off
+    uint64_t next_float = 20 * ISS_MCLK_HZ, t;
+    uint8_t p2 = FLOAT_PIN;
+    int ch, b;
+
+    iss_set_p2( p2 );
+    for( t = 0; t < end; t += STEP_CYC ) {
+        if( t == end / 2 ) knob[ 4 ] = knob[ 2 ] = 800;    // both schedule knobs, whichever board
+        for( ch = 0; ch < 5; ch++ ) iss_set_analog( ch, ( unsigned int )( knob[ ch ] + ( int )rnd( 13 ) - 6 ) );
+
+        if( t >= next_float ) {
+            for( b = 0; b <= 2 * BOUNCES; b++ ) {
+                p2 ^= FLOAT_PIN;
+                iss_set_p2( p2 );
+                if( iss_run( iss_now( ) + 150 + rnd( 400 ) ) ) return( -1 );
+            }
+            next_float = t + ( 20 + rnd( 25 ) ) * ISS_MCLK_HZ;
+        }
+        if( iss_run( t + STEP_CYC ) ) return( -1 );
+    }
+    return( 0 );
+}
+
+// -k: assembles the known program, runs it an instruction at a time and checks every count
+static int known_cycles( void ) {
+
+    uint16_t at = KNOWN_AT, v;
+    uint64_t was;
+    unsigned int w;
+    int k, failures = 0;
+
+    iss_erase( );
+    for( k = 0; k < KNOWN; k++ ) {
+        for( w = 0; w < known[ k ].words; w++ ) {
+            v = known[ k ].op[ w ];
+            if( w && ( v & 0xFF00 ) == 0xFF00 ) v = ( uint16_t )( at + ( v & 0xFF ) );
+            iss_program( ( uint16_t )( at + 2 * w ), v );
+        }
+        at = ( uint16_t )( at + 2 * known[ k ].words );
+    }
+    iss_program( KNOWN_ISR, 0x1300 );
+    iss_program( 0xFFFA, KNOWN_ISR );           // Timer1_A0
+    iss_program( 0xFFFE, KNOWN_AT );            // reset
+
+    iss_reset( );
+    for( k = 0, at = KNOWN_AT; k < KNOWN; k++ ) {
+        was = iss_now( );
+        if( iss_pc( ) != at || iss_run( was + 1 ) ) {
+            printf( "cyclebench: %-24s at %04X, not %04X%s%s\n", known[ k ].text, iss_pc( ), at,
+                    iss_fault( ) ? ", " : "", iss_fault( ) ? iss_fault( ) : "" );
+            failures++;
+            break;
+        }
+        at = ( uint16_t )( at + 2 * known[ k ].words );
+        if( iss_now( ) - was == known[ k ].cycles ) continue;
+        printf( "cyclebench: %-24s %llu cycles, the guide gives %u\n", known[ k ].text,
+                ( unsigned long long )( iss_now( ) - was ), known[ k ].cycles );
+        failures++;
+    }
+    if( !failures && iss_pc( ) != at ) {
+        printf( "cyclebench: ended at %04X, not %04X\n", iss_pc( ), at );
+        failures++;
+    }
+
+    printf( "cyclebench: iss430 on %d instructions of known cycles\n", KNOWN );
+    printf( "cyclebench: %s\n", failures ? "FAILED" : "ok" );
+    return( failures );
+}
+
+static void usage( const char *me ) {
+
+    fprintf( stderr, "usage: %s [-b baseline] [-w baseline] [-t percent] [-m minutes] [-s bytes] lwc.elf\n"
+             "       %s -k\n", me, me );
+    exit( 2 );
+}
+
+int main( int argc, char **argv ) {
+
+    const char *bpath = 0, *wpath = 0;
+    const iss_prof_t *p;
+    const iss_latency_t *lat;
+    const iss_stack_t *st;
+    unsigned long minutes = 10;
+    unsigned int reserve = 0, used;
+    uint64_t gie_off;
+    uint16_t gie_pc, end;
+    int a, k, tol = 2, failures = 0;
+    FILE *w = 0;
+
+    if( argc == 2 && !strcmp( argv[ 1 ], "-k" ) ) return( known_cycles( ) ? 1 : 0 );
+    for( a = 1; a < argc && argv[ a ][ 0 ] == '-'; a++ ) {
+        if( a + 1 >= argc ) usage( argv[ 0 ] );
+        if( !strcmp( argv[ a ], "-b" ) ) bpath = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-w" ) ) wpath = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-t" ) ) tol = atoi( argv[ ++a ] );
+        else if( !strcmp( argv[ a ], "-m" ) ) minutes = strtoul( argv[ ++a ], 0, 0 );
+        else if( !strcmp( argv[ a ], "-s" ) ) reserve = ( unsigned int )atoi( argv[ ++a ] );
+        else usage( argv[ 0 ] );
+    }
+    if( a + 1 != argc || !minutes ) usage( argv[ 0 ] );
+
+    if( iss_load( argv[ a ] ) || ( bpath && load_base( bpath ) ) ) return( 1 );
+    if( bpath && strcmp( base_by, iss_built_by( ) ) ) {
+        printf( "cyclebench: %s is from %s, %s from %s; make cyclebase takes this toolchain's\n", bpath,
+                *base_by ? base_by : "an unnamed toolchain", argv[ a ], *iss_built_by( ) ? iss_built_by( ) : "an unnamed one" );
+        return( 1 );
+    }
+    for( k = 0; k < WATCHED; k++ ) {
+        if( iss_watch( watched[ k ] ) < 0 ) printf( "cyclebench: %-14s not in the image\n", watched[ k ] );
+    }
+
+    iss_reset( );
+    if( drive( minutes * MINUTE_CYC ) ) {
+        printf( "cyclebench: %s at %04X in %s, %.3f s\n", iss_fault( ), iss_pc( ), iss_symbol_at( iss_pc( ) ),
+                ( double )iss_now( ) / ISS_MCLK_HZ );
+        printf( "cyclebench: FAILED\n" );
+        return( 1 );
+    }
+
+    if( wpath && !( w = fopen( wpath, "w" ) ) ) {
+        perror( wpath );
+        return( 1 );
+    }
+    if( w ) fprintf( w, "# most MCLK cycles per call, lwc.elf on iss430; cyclebench -w rewrites it\n"
+                        "# built by %s\n", iss_built_by( ) );
+
+    printf( "cyclebench: %lu min simulated, cpu %.3f%% active\n", minutes,
+            100.0 * ( double )iss_active( ) / ( double )iss_now( ) );
+    printf( "cyclebench: %-14s %8s %7s %7s %7s %9s  %s\n", "function", "calls", "min", "mean", "max",
+            bpath ? "baseline" : "", "longest call's heaviest path" );
+    for( k = 0; ( p = iss_profile( k ) ); k++ ) {
+        if( !p->calls ) {
+            printf( "cyclebench: %-14s %8s\n", p->name, "none" );
+            continue;
+        }
+        printf( "cyclebench: %-14s %8lu %7llu %7llu %7llu", p->name, p->calls, ( unsigned long long )p->min,
+                ( unsigned long long )( p->total / p->calls ), ( unsigned long long )p->max );
+        if( bpath ) failures += compare( p->name, ( unsigned long )p->max, tol );
+        else printf( " %9s", "" );
+        printf( "  %s at %.3f s\n", iss_worst_path( k ), ( double )p->max_at / ISS_MCLK_HZ );
+        if( w ) fprintf( w, "%s %llu\n", p->name, ( unsigned long long )p->max );
+    }
+
+    lat = iss_timer1_latency( );
+    if( lat->n ) {
+        printf( "cyclebench: Timer1_A0 latency %llu to %llu cycles, mean %.1f, jitter %llu",
+                ( unsigned long long )lat->min, ( unsigned long long )lat->max, ( double )lat->total / lat->n,
+                ( unsigned long long )( lat->max - lat->min ) );
+        if( bpath ) failures += compare( "latency", ( unsigned long )lat->max, tol );
+        printf( "\n" );
+        if( w ) fprintf( w, "latency %llu\n", ( unsigned long long )lat->max );
+    } else {
+        printf( "cyclebench: Timer1_A0 never ran off its compare\n" );
+        failures++;
+    }
+
+    gie_off = iss_gie_off_max( &gie_pc );
+    printf( "cyclebench: GIE clear in the main loop for %llu cycles at most, from %04X in %s",
+            ( unsigned long long )gie_off, gie_pc, iss_symbol_at( gie_pc ) );
+    if( bpath ) failures += compare( "gie_off", ( unsigned long )gie_off, tol );
+    printf( "\n" );
+    if( w ) fprintf( w, "gie_off %llu\n", ( unsigned long long )gie_off );
+
+    st = iss_stack( );
+    used = st->open + st->isr > st->main ? st->open + st->isr : st->main;
+    printf( "cyclebench: stack %u B in the main loop, %u B with GIE set in %s + %u B in %s, %u B, StackMax %u",
+            st->main, st->open, iss_symbol_at( st->open_pc ), st->isr, iss_symbol_at( st->isr_pc ), used,
+            iss_symbol( "StackMax" ) ? iss_read16( iss_symbol( "StackMax" ) ) : 0 );
+    if( bpath ) failures += compare( "stack", used, tol );
+    printf( "\n" );
+    if( ( end = iss_symbol( "end" ) ) && used > ( unsigned int )( RAM_TOP - end ) ) {
+        printf( "cyclebench: the stack can reach %u B into the variables, which end at %04X\n",
+                used - ( RAM_TOP - end ), end );
+        failures++;
+    }
+    if( reserve && used > reserve ) {
+        printf( "cyclebench: the stack needs %u B, over the %u B reserve\n", used, reserve );
+        failures++;
+    }
+    if( w ) {
+        fprintf( w, "stack %u\n", used );
+        if( fclose( w ) ) return( 1 );
+    }
+
+    printf( "cyclebench: %s\n", failures ? "FAILED" : "ok" );
+    return( failures ? 1 : 0 );
+}
@@ -0,0 +1,617 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                       Random Scenario Explorer                                      //
+//                                                                                                     //
+//                                                                                                     //
+// File              : explore.c                                                                       //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs the whole firmware through thousands of random scenarios looking for input sequences that      //
+// break it.  Each scenario is a plant, knobs at odd values (0, full scale, either side of the drain   //
+// override's threshold) turned at random times, a float that sloshes for a while after every edge,    //
+// pump rates that sag, and now and then a reset or a hang.  Scenario k is made from the seed and k    //
+// alone, so any one of them can be run again on its own, or printed as an lwcsim script with -p.      //
+//                                                                                                     //
+// Every run is watched for:                                                                           //
+//                                                                                                     //
+//   fill full   the fill pump on alone while the float reads full for longer than -f ms               //
+//   stuck       a well's relays unchanged for longer than -k s, outside the drain override            //
+//   overflow    the plant level reaching the well's capacity                                          //
+//   paced       a relay switching again sooner than RELAY_MIN_ON_MS or RELAY_MIN_OFF_MS after it last //
+//               did, other than the fill going off with the float full; a reset frees every relay     //
+//                                                                                                     //
+// The simulator and the firmware are one set of globals, so the scenarios run in forked workers, one  //
+// per core unless -j says otherwise.  Each worker starts with an equal share of the scenario numbers  //
+// and takes them one at a time; one that runs out steals half of what the busiest has left, as        //
+// scenarios with resets or a chattering float take several times as long as quiet ones.  The CPU      //
+// time each worker spent running scenarios shows how even that left them: with -e, fewer than that    //
+// percent of the slowest one's, on average, fails the run.  With -u every scenario starts on the      //
+// first worker, so the rest only get work by stealing it, and a run where none was stolen fails.      //
+//                                                                                                     //
+// The first failure of each kind is then shrunk: the run is cut to just past the failure, and inputs  //
+// are dropped, halves first, for as long as the same check still fails.  What is left is printed as a //
+// script for lwcsim, and exits 1.                                                                     //
+//                                                                                                     //
+// Usage: explore [-j workers] [-n scenarios] [-s seed] [-t hours] [-f ms] [-k s] [-e percent] [-u]    //
+//                [-p scenario]                                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "../lwc.h"
+#include "../debounce.h"
+#include "../pumps.h"
+#include "../relay.h"
+#include "sim.h"
+
+int lwc_main( void );
+
+#define MAX_WORKERS             64
+#define MAX_EVENTS              32              // inputs per scenario, the knobs at power up included
+
+enum { INV_FILL_FULL, INV_STUCK, INV_OVERFLOW, INV_PACED, INVARIANTS };
+
+static const char * const inv_names[ INVARIANTS ] = { "fill full", "stuck", "overflow", "paced" };
+
+typedef struct {
+    unsigned long   at;                         // ms
+    int             kind, ch;                   // SIM_IN_*
+    unsigned int    value;
+} event_t;
+
+typedef struct {
+    sim_plant_t     plant;
+    unsigned long   end;                        // ms
+    int             n;
+    event_t         ev[ MAX_EVENTS ];
+} scenario_t;
+
+// A worker's scenarios still to run, next << 32 | end, taken from the front and stolen from the back
+typedef struct {
+    unsigned long long  range;
+    unsigned long       runs, stolen;
+    double              busy;                   // s of the worker's CPU time running scenarios
+} slot_t;
+
+typedef struct {
+    unsigned char   failed;                     // invariant + 1, 0 if the run held
+    sim_time_t      at;                         // when it first failed
+} result_t;
+
+typedef struct {
+    slot_t          slot[ MAX_WORKERS ];
+    result_t        result[ ];                  // one per scenario
+} shared_t;
+
+// A full float turns the fill off past its hold, but the drain it starts may wait out its off hold first
+static unsigned long fill_full_ms = RELAY_MIN_OFF_MS + 200, stuck_s = 1200;
+static unsigned long long seed = 1;
+static double hours = 2.0;
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Scenarios                                                                                           //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static unsigned long long rnd_state;
+
+static unsigned long rnd( unsigned long n ) {
+
+    rnd_state = rnd_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return( n ? ( unsigned long )( ( rnd_state >> 33 ) % n ) : 0 );
+}
+
+// Ends of the scale and either side of the drain override turn up as often as the rest
+static unsigned int pot_value( void ) {
+
+    switch( rnd( 6 ) ) {
+    case 0:  return( 0 );
+    case 1:  return( 1023 );
+    case 2:  return( 3 + rnd( 6 ) );            // 3 .. 8, the override below 6
+    default: return( rnd( 1024 ) );
+    }
+}
+
+// Kept in time order, as a script lists them; inputs at the same instant stay in the order made
+static void add_event( scenario_t *s, unsigned long at, int kind, int ch, unsigned int value ) {
+
+    int k;
+
+    if( s->n == MAX_EVENTS ) return;
+    for( k = s->n; k > 0 && s->ev[ k - 1 ].at > at; k-- ) s->ev[ k ] = s->ev[ k - 1 ];
+    s->ev[ k ].at = at;
+    s->ev[ k ].kind = kind;
+    s->ev[ k ].ch = ch;
+    s->ev[ k ].value = value;
+    s->n++;
+}
+
+static void make_scenario( unsigned long k, scenario_t *s ) {
+
+    static const int pots[ 3 ] = { SIM_POT_INTERVAL, SIM_POT_DURATION, SIM_POT_DRAIN };
+    unsigned long end, fill;
+    int n, c;
+
+    rnd_state = seed * 0x9E3779B97F4A7C15ULL + k;
+    rnd( 0 );
+    memset( s, 0, sizeof( *s ) );
+    s->end = end = ( unsigned long )( hours * 3600000.0 );
+
+    // The drain pump always outruns the fill pump, as on the boat
+    fill = 200 + rnd( 400 );
+    s->plant.level = ( double )rnd( 35000 );
+    s->plant.capacity = 40000.0;
+    s->plant.fill_rate = ( double )fill;
+    s->plant.drain_rate = ( double )( fill * 3 / 2 + rnd( 600 ) );
+    s->plant.float_at = ( double )( 25000 + rnd( 10000 ) );
+    s->plant.hyst = ( double )( 100 + rnd( 1500 ) );
+
+    for( c = 0; c < 3; c++ ) add_event( s, 0, SIM_IN_POT, pots[ c ], pot_value( ) );
+    for( n = ( int )rnd( 9 ); n > 0; n-- ) add_event( s, rnd( end ), SIM_IN_POT, pots[ rnd( 3 ) ], pot_value( ) );
+    for( n = ( int )rnd( 4 ); n > 0; n-- ) add_event( s, rnd( end ), SIM_IN_SLOSH, 0, ( unsigned int )rnd( 3000 ) );
+    if( !rnd( 4 ) ) {
+        fill = fill * ( 60 + rnd( 40 ) ) / 100;
+        add_event( s, rnd( end ), SIM_IN_RATES, ( int )fill, ( unsigned int )( s->plant.drain_rate * 0.8 ) );
+    }
+    switch( rnd( 8 ) ) {
+    case 0: add_event( s, rnd( end ), SIM_IN_RESET, 0, SIM_RESET_BROWNOUT ); break;
+    case 1: add_event( s, rnd( end ), SIM_IN_RESET, 0, SIM_RESET_POWER ); break;
+    case 2: add_event( s, rnd( end ), SIM_IN_RESET, 0, SIM_RESET_PIN ); break;
+    case 3: add_event( s, rnd( end ), SIM_IN_HANG, 0, 0 ); break;
+    }
+}
+
+static const char *pot_name( int ch ) {
+
+    return( ch == SIM_POT_INTERVAL ? "interval" : ch == SIM_POT_DURATION ? "duration" : "drain" );
+}
+
+// The scenario as an lwcsim script, which runs it the same to the tick
+static void print_scenario( const scenario_t *s, const char *title ) {
+
+    static const char * const resets[ 3 ] = { "brownout", "power", "pin" };
+    const event_t *e;
+    int k;
+
+    printf( "#\n# %s\n#\n", title );
+    printf( "plant %.0f %.0f %.0f %.0f %.0f %.0f\n", s->plant.level, s->plant.capacity, s->plant.fill_rate,
+            s->plant.drain_rate, s->plant.float_at, s->plant.hyst );
+    for( k = 0; k < s->n; k++ ) {
+        e = &s->ev[ k ];
+        printf( "at %lu ", e->at );
+        switch( e->kind ) {
+        case SIM_IN_POT:   printf( "pot %s %u\n", pot_name( e->ch ), e->value ); break;
+        case SIM_IN_SLOSH: printf( "slosh %u\n", e->value ); break;
+        case SIM_IN_RATES: printf( "rates %d %u\n", e->ch, e->value ); break;
+        case SIM_IN_RESET: printf( "reset %s\n", resets[ e->value % 3 ] ); break;
+        case SIM_IN_HANG:  printf( "hang\n" ); break;
+        }
+    }
+    printf( "at %lu end\n", s->end );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Invariants                                                                                          //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+typedef struct {
+    int             fill, drain, full;          // relays and the float pin, as the firmware sees them
+    sim_time_t      since;                      // fill alone with the float full from then, or SIM_NEVER
+    sim_time_t      moved;                      // relays last changed or the override last held them
+    int             held;                       // drain override on at the last look
+    sim_time_t      switched[ 2 ];              // fill and drain relays last switched, SIM_NEVER after a reset
+} watch_t;
+
+static watch_t watch[ SIM_WELLS ];
+static unsigned long resets;                    // the sim's count as the relay holds last saw it
+static result_t verdict;
+
+static void fail( int inv, sim_time_t at ) {
+
+    if( !verdict.failed || at < verdict.at ) {
+        verdict.failed = ( unsigned char )( inv + 1 );
+        verdict.at = at;
+    }
+}
+
+// Brings well w's checks up to time t, before anything it watches changes
+static void check( int w, sim_time_t t ) {
+
+    watch_t *x = &watch[ w ];
+    const sim_time_t stuck = ( sim_time_t )stuck_s * SIM_HZ;
+
+    if( x->since != SIM_NEVER && t - x->since > ( sim_time_t )fill_full_ms * SIM_MS ) {
+        fail( INV_FILL_FULL, x->since + ( sim_time_t )fill_full_ms * SIM_MS );
+    }
+
+    // The override holds the relays on purpose, and so does anything it held them through
+    if( x->held || Draining[ w ] ) x->moved = t;
+    x->held = Draining[ w ];
+    if( t - x->moved > stuck ) fail( INV_STUCK, x->moved + stuck );
+}
+
+static void settle( int w, sim_time_t t ) {
+
+    watch_t *x = &watch[ w ];
+    int alone = x->fill && !x->drain && x->full;
+
+    if( !alone ) x->since = SIM_NEVER;
+    else if( x->since == SIM_NEVER ) x->since = t;
+}
+
+// A relay of well w switched to on at t, with a millisecond's grace for the timebase's ticks; the ones a
+// reset drops, and whatever each drives next, go free
+static void paced( int w, int drain, sim_time_t t, int on ) {
+
+    const sim_stats_t *st = sim_stats( );
+    const sim_time_t hold = ( sim_time_t )( on ? RELAY_MIN_OFF_MS : RELAY_MIN_ON_MS ) * SIM_MS;
+    sim_time_t *last = &watch[ w ].switched[ drain ];
+    int k;
+
+    if( st->resets != resets ) {
+        resets = st->resets;
+        for( k = 0; k < SIM_WELLS; k++ ) watch[ k ].switched[ 0 ] = watch[ k ].switched[ 1 ] = SIM_NEVER;
+    }
+    if( *last != SIM_NEVER && t - *last + SIM_MS < hold && ( drain || on || FloatState[ w ] != INDICATES_FULL ) ) {
+        fail( INV_PACED, t );
+    }
+    *last = st->resets && t == st->last_reset ? SIM_NEVER : t;
+}
+
+static void on_output( sim_time_t t, int sig, int on ) {
+
+    int w;
+
+    for( w = 0; w < SIM_WELLS; w++ ) {
+        if( sig != SIM_SIG_WFILL( w ) && sig != SIM_SIG_WDRAIN( w ) ) continue;
+        check( w, t );
+        paced( w, sig == SIM_SIG_WDRAIN( w ), t, on );
+        if( sig == SIM_SIG_WFILL( w ) ) watch[ w ].fill = on;
+        else watch[ w ].drain = on;
+        watch[ w ].moved = t;
+        settle( w, t );
+    }
+}
+
+static void on_input( sim_time_t t, int well, int kind, int ch, unsigned int value ) {
+
+    int w;
+
+    ( void )ch;
+    for( w = 0; w < SIM_WELLS; w++ ) check( w, t );
+    if( kind != SIM_IN_FLOAT ) return;
+    watch[ well ].full = value != 0;
+    settle( well, t );
+}
+
+static result_t run_scenario( const scenario_t *s ) {
+
+    const sim_time_t end = ( sim_time_t )s->end * SIM_MS;
+    const sim_stats_t *st;
+    const event_t *e;
+    int k, w;
+
+    memset( &verdict, 0, sizeof( verdict ) );
+    resets = 0;
+    for( w = 0; w < SIM_WELLS; w++ ) {
+        memset( &watch[ w ], 0, sizeof( watch[ w ] ) );
+        watch[ w ].since = watch[ w ].switched[ 0 ] = watch[ w ].switched[ 1 ] = SIM_NEVER;
+    }
+
+    sim_reset( );
+    memset( sim_flash( ), 0xFF, SIM_FLASH_SIZE );   // a new board every run
+    sim_set_input_hook( on_input );
+    sim_set_output_hook( on_output );
+    sim_set_plant( &s->plant );
+    for( k = 0; k < s->n; k++ ) {
+        e = &s->ev[ k ];
+        if( e->kind == SIM_IN_POT && e->ch == SIM_POT_DRAIN ) {
+            for( w = 0; w < SIM_WELLS; w++ ) {
+                sim_add_input( ( sim_time_t )e->at * SIM_MS, SIM_IN_POT, SIM_POT_WELL_DRAIN( w ), e->value );
+            }
+        } else {
+            sim_add_input( ( sim_time_t )e->at * SIM_MS, e->kind, e->ch, e->value );
+        }
+    }
+    sim_run( lwc_main, end );
+
+    st = sim_stats( );
+    for( w = 0; w < SIM_WELLS; w++ ) {
+        check( w, end );
+        if( st->level_max[ w ] >= s->plant.capacity ) fail( INV_OVERFLOW, end );
+    }
+    return( verdict );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Workers                                                                                             //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#define RANGE( lo, hi )         ( ( unsigned long long )( lo ) << 32 | ( hi ) )
+#define RANGE_LO( r )           ( ( unsigned long )( ( r ) >> 32 ) )
+#define RANGE_HI( r )           ( ( unsigned long )( ( r ) & 0xFFFFFFFFUL ) )
+
+static shared_t *shared;
+static int workers = 0;
+
+// Next scenario off the front of slot me's range, -1 once it is empty
+static long take( int me ) {
+
+    unsigned long long r = __atomic_load_n( &shared->slot[ me ].range, __ATOMIC_ACQUIRE );
+
+    while( RANGE_LO( r ) < RANGE_HI( r ) ) {
+        if( __atomic_compare_exchange_n( &shared->slot[ me ].range, &r, RANGE( RANGE_LO( r ) + 1, RANGE_HI( r ) ), 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) ) return( ( long )RANGE_LO( r ) );
+    }
+    return( -1 );
+}
+
+// Moves the back half of the fullest other range to slot me, which is empty; 0 when none is left
+static int steal( int me ) {
+
+    unsigned long long r;
+    unsigned long lo, hi, mid, most;
+    int k, victim;
+
+    for( ;; ) {
+        victim = -1;
+        most = 0;
+        for( k = 0; k < workers; k++ ) {
+            r = __atomic_load_n( &shared->slot[ k ].range, __ATOMIC_ACQUIRE );
+            if( k != me && RANGE_HI( r ) > RANGE_LO( r ) && RANGE_HI( r ) - RANGE_LO( r ) > most ) {
+                most = RANGE_HI( r ) - RANGE_LO( r );
+                victim = k;
+            }
+        }
+        if( victim < 0 ) return( 0 );
+
+        r = __atomic_load_n( &shared->slot[ victim ].range, __ATOMIC_ACQUIRE );
+        lo = RANGE_LO( r );
+        hi = RANGE_HI( r );
+        if( lo >= hi ) continue;
+        mid = lo + ( hi - lo ) / 2;             // one left goes to the thief
+        if( !__atomic_compare_exchange_n( &shared->slot[ victim ].range, &r, RANGE( lo, mid ), 0, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE ) ) continue;
+
+        shared->slot[ me ].stolen += hi - mid;
+        __atomic_store_n( &shared->slot[ me ].range, RANGE( mid, hi ), __ATOMIC_RELEASE );
+        return( 1 );
+    }
+}
+
+static double wall( void ) {
+
+    struct timespec t;
+
+    clock_gettime( CLOCK_MONOTONIC, &t );
+    return( t.tv_sec + t.tv_nsec * 1e-9 );
+}
+
+// A worker is a process of its own, so its CPU time is its process's, whatever else shares the cores
+static double cpu( void ) {
+
+    struct timespec t;
+
+    clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &t );
+    return( t.tv_sec + t.tv_nsec * 1e-9 );
+}
+
+static void worker( int me ) {
+
+    scenario_t s;
+    double t0;
+    long k;
+
+    do {
+        while( ( k = take( me ) ) >= 0 ) {
+            t0 = cpu( );
+            make_scenario( ( unsigned long )k, &s );
+            shared->result[ k ] = run_scenario( &s );
+            shared->slot[ me ].runs++;
+            shared->slot[ me ].busy += cpu( ) - t0;
+        }
+    } while( steal( me ) );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Shrinking                                                                                           //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static int runs;
+
+static int still_fails( const scenario_t *s, int inv, result_t *r ) {
+
+    runs++;
+    *r = run_scenario( s );
+    return( r->failed == inv + 1 );
+}
+
+static void shrink( scenario_t *s, int inv, result_t *r ) {
+
+    scenario_t t;
+    result_t tr;
+    int chunk, k, j;
+
+    // Just past the failure, with what came after it gone
+    t = *s;
+    t.end = ( unsigned long )( r->at / SIM_MS ) + 1000;
+    while( t.n && t.ev[ t.n - 1 ].at >= t.end ) t.n--;
+    if( t.end < s->end && still_fails( &t, inv, &tr ) ) {
+        *s = t;
+        *r = tr;
+    }
+
+    // Drops runs of inputs, halves first, then smaller, for as long as any can go
+    for( chunk = s->n / 2 > 0 ? s->n / 2 : 1; chunk > 0 && s->n; chunk /= 2 ) {
+        for( k = 0; k + chunk <= s->n; ) {
+            t = *s;
+            for( j = k; j + chunk < t.n; j++ ) t.ev[ j ] = t.ev[ j + chunk ];
+            t.n -= chunk;
+            if( still_fails( &t, inv, &tr ) ) {
+                *s = t;
+                *r = tr;
+            } else {
+                k += chunk;
+            }
+        }
+    }
+}
+
+static void usage( const char *me ) {
+
+    fprintf( stderr, "usage: %s [-j workers] [-n scenarios] [-s seed] [-t hours] [-f ms] [-k s] [-e percent] [-u]\n"
+             "               [-p scenario]\n", me );
+    exit( 2 );
+}
+
+int main( int argc, char **argv ) {
+
+    unsigned long n = 256, k, first[ INVARIANTS ], count[ INVARIANTS ], runs_total = 0, stolen = 0;
+    long show = -1;
+    double t0, elapsed, busy = 0.0, slowest = 0.0, even = 0.0;
+    scenario_t s;
+    result_t r;
+    char title[ 128 ];
+    int a, w, inv, failures = 0, status, uneven = 0;
+    pid_t pid[ MAX_WORKERS ];
+    size_t size;
+
+    for( a = 1; a < argc && argv[ a ][ 0 ] == '-'; a++ ) {
+        if( !strcmp( argv[ a ], "-u" ) ) {
+            uneven = 1;
+            continue;
+        }
+        if( a + 1 >= argc ) usage( argv[ 0 ] );
+        if( !strcmp( argv[ a ], "-j" ) ) workers = atoi( argv[ ++a ] );
+        else if( !strcmp( argv[ a ], "-n" ) ) n = strtoul( argv[ ++a ], 0, 0 );
+        else if( !strcmp( argv[ a ], "-s" ) ) seed = strtoull( argv[ ++a ], 0, 0 );
+        else if( !strcmp( argv[ a ], "-t" ) ) hours = atof( argv[ ++a ] );
+        else if( !strcmp( argv[ a ], "-f" ) ) fill_full_ms = strtoul( argv[ ++a ], 0, 0 );
+        else if( !strcmp( argv[ a ], "-k" ) ) stuck_s = strtoul( argv[ ++a ], 0, 0 );
+        else if( !strcmp( argv[ a ], "-e" ) ) even = atof( argv[ ++a ] );
+        else if( !strcmp( argv[ a ], "-p" ) ) show = atol( argv[ ++a ] );
+        else usage( argv[ 0 ] );
+    }
+    if( a != argc || !n || n > 0xFFFFFFFFUL || hours <= 0.0 ) usage( argv[ 0 ] );
+
+    if( show >= 0 ) {
+        make_scenario( ( unsigned long )show, &s );
+        snprintf( title, sizeof( title ), "explore scenario %ld, seed %llu", show, seed );
+        print_scenario( &s, title );
+        return( 0 );
+    }
+
+    if( workers <= 0 ) workers = ( int )sysconf( _SC_NPROCESSORS_ONLN );
+    if( workers < 1 ) workers = 1;
+    if( workers > MAX_WORKERS ) workers = MAX_WORKERS;
+    if( ( unsigned long )workers > n ) workers = ( int )n;
+
+    size = sizeof( shared_t ) + n * sizeof( result_t );
+    shared = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if( shared == MAP_FAILED ) {
+        perror( "mmap" );
+        return( 1 );
+    }
+    for( w = 0; w < workers; w++ ) shared->slot[ w ].range = RANGE( n * w / workers, n * ( w + 1 ) / workers );
+    if( uneven ) {
+        for( w = 1; w < workers; w++ ) shared->slot[ w ].range = RANGE( n, n );
+        shared->slot[ 0 ].range = RANGE( 0, n );
+    }
+
+    printf( "explore: %lu scenarios of %.1f h from seed %llu on %d workers, fill full %lu ms, stuck %lu s\n", n,
+            hours, seed, workers, fill_full_ms, stuck_s );
+    fflush( stdout );
+
+    t0 = wall( );
+    for( w = 0; w < workers; w++ ) {
+        if( ( pid[ w ] = fork( ) ) < 0 ) {
+            perror( "fork" );
+            return( 1 );
+        }
+        if( !pid[ w ] ) {
+            worker( w );
+            _exit( 0 );
+        }
+    }
+    for( w = 0; w < workers; w++ ) {
+        if( waitpid( pid[ w ], &status, 0 ) < 0 || !WIFEXITED( status ) || WEXITSTATUS( status ) ) failures++;
+    }
+    elapsed = wall( ) - t0;
+
+    printf( "explore: %-8s %7s %7s %9s\n", "worker", "runs", "stolen", "busy" );
+    for( w = 0; w < workers; w++ ) {
+        printf( "explore: %-8d %7lu %7lu %8.2fs\n", w, shared->slot[ w ].runs, shared->slot[ w ].stolen,
+                shared->slot[ w ].busy );
+        runs_total += shared->slot[ w ].runs;
+        stolen += shared->slot[ w ].stolen;
+        busy += shared->slot[ w ].busy;
+        if( shared->slot[ w ].busy > slowest ) slowest = shared->slot[ w ].busy;
+    }
+    printf( "explore: %.0f h simulated in %.2f s wall, %.1f scenarios/s, %.1f a worker\n", runs_total * hours, elapsed,
+            elapsed > 0.0 ? runs_total / elapsed : 0.0, elapsed > 0.0 ? runs_total / elapsed / workers : 0.0 );
+    if( workers > 1 && slowest > 0.0 ) {
+        printf( "explore: workers ran %.0f%% of the slowest one's %.2f s CPU on average, %lu scenarios stolen\n",
+                100.0 * busy / workers / slowest, slowest, stolen );
+        if( 100.0 * busy / workers / slowest < even ) {
+            printf( "explore: under the %.0f%% asked for\n", even );
+            failures++;
+        }
+        if( uneven && !stolen ) {
+            printf( "explore: every scenario started on worker 0 and none was stolen\n" );
+            failures++;
+        }
+    }
+    if( failures || runs_total != n ) {
+        printf( "explore: %d workers died, %lu of %lu scenarios run\n", failures, runs_total, n );
+        failures++;
+    }
+
+    for( inv = 0; inv < INVARIANTS; inv++ ) count[ inv ] = 0;
+    for( k = 0; k < n; k++ ) {
+        if( !shared->result[ k ].failed ) continue;
+        inv = shared->result[ k ].failed - 1;
+        if( !count[ inv ]++ ) first[ inv ] = k;
+    }
+    for( inv = 0; inv < INVARIANTS; inv++ ) {
+        printf( "explore: %-10s %5lu scenarios", inv_names[ inv ], count[ inv ] );
+        if( count[ inv ] ) {
+            printf( ", the first %lu at %.1f s", first[ inv ],
+                    ( double )shared->result[ first[ inv ] ].at / SIM_HZ );
+        }
+        printf( "\n" );
+    }
+
+    // The firmware is linked into this process too, so the shrinking runs here once the workers are done
+    for( inv = 0; inv < INVARIANTS; inv++ ) {
+        if( !count[ inv ] ) continue;
+        failures++;
+        make_scenario( first[ inv ], &s );
+        r = shared->result[ first[ inv ] ];
+        a = s.n;
+        runs = 0;
+        shrink( &s, inv, &r );
+        printf( "explore: scenario %lu shrunk from %d inputs to %d in %d runs, %s at %.3f s:\n", first[ inv ], a, s.n,
+                runs, inv_names[ inv ], ( double )r.at / SIM_HZ );
+        snprintf( title, sizeof( title ), "explore scenario %lu, seed %llu, shrunk: %s at %.3f s", first[ inv ], seed,
+                  inv_names[ inv ], ( double )r.at / SIM_HZ );
+        print_scenario( &s, title );
+    }
+
+    printf( "explore: %s\n", failures ? "FAILED" : "ok" );
+    return( failures ? 1 : 0 );
+}
@@ -0,0 +1,212 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                      Pot Filter Benchmark                                           //
+//                                                                                                     //
+//                                                                                                     //
+// File              : filtbench.c                                                                     //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs the original AvgAuxAI and the one in filter.c, which divides without a divide, side by side.   //
+// output is compared first, over random and adversarial ADC sequences and a sweep that reaches every  //
+// possible trimmed sum; timings are only reported when the two agree on all of them.                  //
+//                                                                                                     //
+// Usage: filtbench [calls]                                                                            //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#define HAVE_TSC                1
+#endif
+
+#include "../filter.h"
+
+static unsigned int auxsamp[ AUX_CHANNELS ][ 16 ];
+static unsigned int auxindx[ AUX_CHANNELS ];
+
+//
+// The original AvgAuxAI, verbatim
+//
+static unsigned int LegacyAvgAuxAI( unsigned int newval, unsigned char ch ) {
+
+    unsigned long tlwrk;
+    unsigned long tmp, min, max;
+    unsigned char u0;
+
+    auxsamp[ ch ][ auxindx[ ch ]++ & 0x0F ] = newval;
+
+    if( auxindx[ ch ] & 0x10 ) auxindx[ ch ] |= 0x80;
+    auxindx[ ch ] &= 0x8F;
+
+    if( auxindx[ ch ] & 0x80 ){
+        min = 1024;
+        max = 0;
+        for( tlwrk = 0, u0 = 0; u0 < 16; ){
+            tlwrk += tmp = auxsamp[ ch ][ u0++ ];
+            if( tmp < min ) min = tmp;
+            if( tmp > max ) max = tmp;
+        }
+        tlwrk -= min;
+        tlwrk -= max;
+        tlwrk /= 14;
+
+        newval = ( unsigned int )tlwrk;
+    }
+    return( newval );
+}
+
+static void reset( void ) {
+
+    memset( auxsamp, 0, sizeof( auxsamp ) );
+    memset( auxindx, 0, sizeof( auxindx ) );
+    memset( AuxFilter, 0, sizeof( AuxFilter ) );
+}
+
+static unsigned int rng_state = 12345;
+
+static unsigned int rng( void ) {
+
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return( rng_state );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Input Sequences                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+enum { SEQ_RANDOM, SEQ_NOISY_KNOB, SEQ_RAMP_UP, SEQ_RAMP_DOWN, SEQ_CONSTANT, SEQ_RAILS,
+       SEQ_SAW_15, SEQ_SAW_17, SEQ_SPIKES, SEQ_TIES, SEQ_SUM_SWEEP, NSEQ };
+
+static const char * const seq_names[ NSEQ ] = {
+    "random", "noisy knob", "ramp up", "ramp down", "constant", "0/1023 rails",
+    "sawtooth 15", "sawtooth 17", "spikes", "ties", "trimmed-sum sweep"
+};
+
+static unsigned int sample( int seq, unsigned long k ) {
+
+    static int knob = 512;
+    unsigned int v, s, w;
+
+    switch( seq ) {
+    case SEQ_RANDOM:    return( rng( ) & 0x3FF );
+    case SEQ_NOISY_KNOB:
+        if( !( k & 63 ) ) knob += ( int )( rng( ) % 41 ) - 20;
+        if( knob < 0 ) knob = 0;
+        if( knob > 1023 ) knob = 1023;
+        v = knob + ( rng( ) % 7 ) - 3;
+        return( v > 1023 ? ( ( int )v < 0 ? 0 : 1023 ) : v );
+    case SEQ_RAMP_UP:   return( k & 0x3FF );
+    case SEQ_RAMP_DOWN: return( 0x3FF - ( k & 0x3FF ) );
+    case SEQ_CONSTANT:  return( 777 );
+    case SEQ_RAILS:     return( ( k & 1 ) ? 1023 : 0 );
+    case SEQ_SAW_15:    return( ( k % 15 ) * 73 );
+    case SEQ_SAW_17:    return( 1023 - ( k % 17 ) * 60 );
+    case SEQ_SPIKES:    return( ( rng( ) % 23 ) ? 300 + ( rng( ) & 3 ) : ( ( rng( ) & 1 ) ? 1023 : 0 ) );
+    case SEQ_TIES:      return( ( rng( ) % 3 ) * 511 );
+    case SEQ_SUM_SWEEP:
+        // Window k / 16: one 0, one 1023 and 14 samples summing to every value 0 .. 14 * 1023
+        s = ( unsigned int )( k / 16 ) % ( 14 * 1023 + 1 );
+        w = k % 16;
+        if( w == 0 ) return( 0 );
+        if( w == 1 ) return( 1023 );
+        v = s / 14 + ( ( w - 2 ) < s % 14 ? 1 : 0 );
+        return( v );
+    }
+    return( 0 );
+}
+
+static unsigned long check( int seq, unsigned long calls ) {
+
+    unsigned long k, bad = 0;
+    unsigned int v, a, b;
+    unsigned char ch;
+
+    reset( );
+    for( k = 0; k < calls; k++ ) {
+        v = sample( seq, k );
+        ch = ( unsigned char )( k % AUX_CHANNELS );
+        if( seq == SEQ_SUM_SWEEP ) ch = 0;
+        a = LegacyAvgAuxAI( v, ch );
+        b = AvgAuxAI( v, ch );
+        if( a != b && bad++ < 5 ) {
+            fprintf( stderr, "  %s: call %lu ch %u in %u: legacy %u, filter.c %u\n",
+                     seq_names[ seq ], k, ch, v, a, b );
+        }
+    }
+    return( bad );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Timing                                                                                              //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static unsigned int inputs[ 4096 ];
+static volatile unsigned int sink;
+
+static void time_filter( const char *name, unsigned int ( *fn )( unsigned int, unsigned char ), unsigned long calls ) {
+
+    struct timespec t0, t1;
+    unsigned long k;
+    double ns;
+#ifdef HAVE_TSC
+    unsigned long long c0, c1;
+#endif
+
+    reset( );
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+#ifdef HAVE_TSC
+    c0 = __rdtsc( );
+#endif
+    for( k = 0; k < calls; k++ ) sink = fn( inputs[ k & 4095 ], ( unsigned char )( k % AUX_CHANNELS ) );
+#ifdef HAVE_TSC
+    c1 = __rdtsc( );
+#endif
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+
+    ns = ( ( t1.tv_sec - t0.tv_sec ) * 1e9 + ( t1.tv_nsec - t0.tv_nsec ) ) / ( double )calls;
+#ifdef HAVE_TSC
+    printf( "  %-12s %7.2f ns/call %8.1f host cycles/call\n", name, ns, ( double )( c1 - c0 ) / calls );
+#else
+    printf( "  %-12s %7.2f ns/call\n", name, ns );
+#endif
+}
+
+int main( int argc, char **argv ) {
+
+    unsigned long calls = argc > 1 ? strtoul( argv[ 1 ], 0, 0 ) : 2000000;
+    unsigned long bad, total = 0, n;
+    int seq, k;
+
+    printf( "equivalence (original vs filter.c AvgAuxAI):\n" );
+    for( seq = 0; seq < NSEQ; seq++ ) {
+        n = ( seq == SEQ_SUM_SWEEP ) ? 16UL * ( 14 * 1023 + 1 ) : calls;
+        bad = check( seq, n );
+        printf( "  %-18s %9lu samples  %lu mismatches\n", seq_names[ seq ], n, bad );
+        total += bad;
+    }
+    if( total ) {
+        printf( "FAILED: %lu mismatches, no timings reported\n", total );
+        return( 1 );
+    }
+
+    for( k = 0; k < 4096; k++ ) inputs[ k ] = sample( SEQ_NOISY_KNOB, k );
+    printf( "timing over %lu calls, noisy knob input:\n", calls * 5 );
+    time_filter( "original", LegacyAvgAuxAI, calls * 5 );
+    time_filter( "filter.c", AvgAuxAI, calls * 5 );
+    printf( "  (host CPU with a hardware divider; on the G2553 the original's 32-bit sum and /14 are\n"
+            "   library calls, which filter.c replaces with 16-bit adds and shifts)\n" );
+    return( 0 );
+}
@@ -0,0 +1,320 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                      Statistics Log Flash Bench                                     //
+//                                                                                                     //
+//                                                                                                     //
+// File              : flashbench.c                                                                    //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs stats.c against the simulator's flash controller, with the clock and the scheduler stubbed so  //
+// months of commits take a moment.                                                                    //
+//                                                                                                     //
+// Wear: commits a pump workload every STATS_COMMIT_MIN and checks each record against totals kept     //
+// here.  Reports the flash written per commit, the write amplification (bytes programmed and erased   //
+// per byte of counters), erases per segment and the life they give, and the worst time one main loop  //
+// pass and one whole commit hold the CPU.                                                             //
+//                                                                                                     //
+// Power loss: from every point in two turns of the ring, repeats a commit with the power cut during   //
+// each of its flash operations in turn, leaving the cells half programmed or half erased.  After the  //
+// reset the log must hold either the previous record or the new one, exactly, and the next commit     //
+// must follow on from it without programming a word twice.  Exits 1 on any failure.                   //
+//                                                                                                     //
+// Usage: flashbench [commits]                                                                         //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../lwc.h"
+#include "../sched.h"
+#include "../stats.h"
+#include "sim.h"
+#include "statsimg.h"
+
+#define PERIOD                  ( ( unsigned long long )STATS_COMMIT_MIN * 60 * TB_HZ )
+#define PHASES                  ( 2 * STATS_SLOTS + 1 )
+#define SEEDS                   8
+#define ENDURANCE_MIN           10000.0         // G2553 datasheet minimum erase cycles
+#define ENDURANCE_TYP           100000.0
+
+volatile unsigned char WakeEvents;              // main.c is not linked
+
+static unsigned long long Clock;               // TimeTicks is its low 32 bits, so it wraps as on the part
+
+TBTICKS TimeTicks( void ) { return( ( TBTICKS )Clock ); }
+unsigned long TimeSeconds( void ) { return( ( unsigned long )( Clock >> 15 ) ); }
+void SchedArm( unsigned char id, TBTICKS at, SCHEDFN fn ) { ( void )id; ( void )at; ( void )fn; }
+
+// What the log should say, kept independently of stats.c
+typedef struct {
+    unsigned long long  on[ 2 ];            // ticks each relay has been on
+    unsigned long       starts[ 2 ];
+    unsigned long       boots;
+    unsigned long       minutes;            // powered minutes committed before this boot
+    unsigned long long  since[ 2 ];
+    unsigned char       relays;
+} expect_t;
+
+static expect_t Exp;
+static unsigned long Rand = 1;
+static int Cut;                                 // flash operation to cut the power in, -1 never
+static int Ops;                                 // flash operations so far
+static sim_time_t PassMax, CommitMax;
+static unsigned long Failures;
+
+static unsigned long next_rand( void ) {
+
+    Rand = Rand * 1103515245UL + 12345UL;
+    return( ( Rand >> 8 ) & 0xFFFFFF );
+}
+
+static void relays( unsigned char r ) {
+
+    int p;
+
+    for( p = 0; p < 2; p++ ) {
+        if( ( r & ~Exp.relays ) & ( 1 << p ) ) {
+            Exp.starts[ p ]++;
+            Exp.since[ p ] = Clock;
+        }
+        if( ( Exp.relays & ~r ) & ( 1 << p ) ) Exp.on[ p ] += Clock - Exp.since[ p ];
+    }
+    Exp.relays = r;
+    StatsRelays( 0, r );
+}
+
+// Fill and drain cycles with random lengths, roughly the day.txt mix, up to the clock 'until'
+static void workload( unsigned long long until ) {
+
+    while( Clock + 40 * TB_HZ < until ) {
+        switch( next_rand( ) % 8 ) {
+        case 0:     relays( 1 ); break;                     // topping up
+        case 1:     relays( 0 ); break;
+        default:    relays( 3 ); break;                     // aerating
+        }
+        Clock += next_rand( ) % ( 30 * TB_HZ );
+    }
+    if( next_rand( ) & 1 ) relays( 0 );                     // else left running across the commit
+    Clock = until;
+}
+
+static void commit( void ) {
+
+    sim_time_t t0 = sim_now( ), t;
+
+    do {
+        WakeEvents = 0;
+        t = sim_now( );
+        StatsCommit( );
+        if( sim_now( ) - t > PassMax ) PassMax = sim_now( ) - t;
+    } while( WakeEvents & WAKE_STATS );
+    if( sim_now( ) - t0 > CommitMax ) CommitMax = sim_now( ) - t0;
+}
+
+static void boot( void ) {
+
+    Clock = 0;
+    Exp.relays = 0;
+    Exp.boots++;
+    StatsInit( );
+}
+
+static unsigned long secs( int p ) {
+
+    return( ( unsigned long )( ( Exp.on[ p ] + ( ( Exp.relays & ( 1 << p ) ) ? Clock - Exp.since[ p ] : 0 ) ) >> 15 ) );
+}
+
+static int matches( const stats_rec_t *r ) {
+
+    return( r->fill_s == secs( 0 ) && r->drain_s == secs( 1 ) && r->fill_starts == Exp.starts[ 0 ]
+         && r->drain_starts == Exp.starts[ 1 ] && r->boots == Exp.boots
+         && r->powered_min == Exp.minutes + ( unsigned long )( ( Clock >> 15 ) / 60 ) );
+}
+
+static int same( const stats_rec_t *a, const stats_rec_t *b ) {
+
+    return( a->seq == b->seq && a->fill_s == b->fill_s && a->drain_s == b->drain_s
+         && a->fill_starts == b->fill_starts && a->drain_starts == b->drain_starts
+         && a->boots == b->boots && a->powered_min == b->powered_min );
+}
+
+static void fail( const char *what, int phase, int op, int seed ) {
+
+    if( ++Failures <= 10 ) printf( "  phase %d, operation %d, seed %d: %s\n", phase, op, seed, what );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Wear                                                                                                //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static unsigned long Commits;
+
+static int wear( void ) {
+
+    stats_rec_t r;
+    unsigned long k;
+
+    boot( );
+    for( k = 0; k < Commits; k++ ) {
+        workload( Clock + PERIOD );
+        commit( );
+        stats_latest( sim_flash( ) + STATS_BASE - 0x1000, &r );
+        if( !matches( &r ) || r.seq != k % 0xFFFF ) {
+            printf( "  commit %lu: record %u does not match the workload\n", k, r.seq );
+            Failures++;
+            break;
+        }
+    }
+    return( 0 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Power Loss                                                                                          //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static int cut_here( unsigned int addr, int erase ) {
+
+    ( void )addr;
+    ( void )erase;
+    return( Ops++ == Cut );
+}
+
+// One boot, some pumping and a commit; the power may go during the commit
+static int session( void ) {
+
+    boot( );
+    workload( PERIOD );
+    commit( );
+    return( 0 );
+}
+
+static unsigned char Image[ SIM_FLASH_SIZE ];
+static expect_t ImageExp;
+static unsigned long ImageRand;
+
+// Restores the flash and the expected totals to the start of a phase
+static void restore( void ) {
+
+    sim_reset( );
+    memcpy( sim_flash( ), Image, SIM_FLASH_SIZE );
+    Exp = ImageExp;
+    Rand = ImageRand;
+    Ops = 0;
+}
+
+static int power_loss( void ) {
+
+    stats_rec_t before, after, got, next;
+    expect_t at_boot;
+    unsigned long trials = 0, kept_old = 0, kept_new = 0;
+    int phase, op, ops, seed;
+    const unsigned char *img = sim_flash( ) + STATS_BASE - 0x1000;
+
+    memset( sim_flash( ), 0xFF, SIM_FLASH_SIZE );
+    memset( &Exp, 0, sizeof( Exp ) );
+    Rand = 7;
+
+    for( phase = 0; phase < PHASES; phase++ ) {
+        memcpy( Image, sim_flash( ), SIM_FLASH_SIZE );
+        ImageExp = Exp;
+        ImageRand = Rand;
+        stats_latest( img, &before );
+
+        // The uncut commit gives the new record and the number of flash operations
+        restore( );
+        Cut = -1;
+        sim_set_flash_hook( cut_here );
+        sim_run( session, SIM_NEVER - 1 );
+        ops = Ops;
+        stats_latest( img, &after );
+
+        for( op = 0; op < ops; op++ ) {
+            for( seed = 0; seed < SEEDS; seed++ ) {
+                restore( );
+                srand( seed * 7919 + op );
+                Cut = op;
+                sim_set_flash_hook( cut_here );
+                sim_run( session, SIM_NEVER - 1 );
+                trials++;
+
+                // The totals of the session that was cut are lost along with RAM
+                at_boot = Exp;
+                stats_latest( img, &got );
+                if( same( &got, &after ) ) kept_new++;
+                else if( same( &got, &before ) ) kept_old++;
+                else {
+                    fail( "log holds neither the old nor the new record", phase, op, seed );
+                    continue;
+                }
+
+                // Reboot on what survived and commit again; it must follow on, touching only blank words
+                memset( &Exp, 0, sizeof( Exp ) );
+                Exp.on[ 0 ] = ( unsigned long long )got.fill_s << 15;
+                Exp.on[ 1 ] = ( unsigned long long )got.drain_s << 15;
+                Exp.starts[ 0 ] = got.fill_starts;
+                Exp.starts[ 1 ] = got.drain_starts;
+                Exp.boots = got.boots;
+                Exp.minutes = got.powered_min;
+                Rand = at_boot.boots;
+                sim_reset( );
+                Cut = -1;
+                sim_run( session, SIM_NEVER - 1 );
+                stats_latest( img, &next );
+                if( sim_stats( )->flash_errors ) fail( "a word was programmed twice after the reset", phase, op, seed );
+                if( next.seq != ( got.slot < 0 ? 0 : ( got.seq + 1 ) & 0xFFFF ) || !matches( &next ) ) {
+                    fail( "the next commit does not follow on", phase, op, seed );
+                }
+            }
+        }
+
+        // Move on to the next phase with the uncut commit
+        restore( );
+        Cut = -1;
+        sim_run( session, SIM_NEVER - 1 );
+    }
+
+    printf( "power loss: %lu cuts over %d commits, %lu kept the old record, %lu the new one\n",
+            trials, PHASES, kept_old, kept_new );
+    return( 0 );
+}
+
+int main( int argc, char **argv ) {
+
+    const sim_stats_t *s;
+    double words, erases, days, life;
+
+    Commits = argc > 1 ? strtoul( argv[ 1 ], 0, 0 ) : 24UL * 365;
+
+    sim_reset( );
+    memset( sim_flash( ), 0xFF, SIM_FLASH_SIZE );
+    sim_run( wear, SIM_NEVER - 1 );
+    s = sim_stats( );
+
+    words = ( double )s->flash_words / Commits;
+    erases = ( double )s->flash_erases / Commits;
+    days = Commits * STATS_COMMIT_MIN / 1440.0;
+    life = ENDURANCE_MIN * STATS_SLOTS / ( 1440.0 / STATS_COMMIT_MIN ) / 365.0;
+    printf( "wear: %lu commits, one per %d min (%.0f days)\n", Commits, STATS_COMMIT_MIN, days );
+    printf( "  %.1f bytes programmed and %.2f segment erases per commit\n", words * 2, erases );
+    printf( "  write amplification %.2f (flash bytes programmed or erased per %d bytes of counters)\n",
+            ( words * 2 + erases * STATS_SEG_SIZE ) / ( STATS_COUNTERS * 4 ), STATS_COUNTERS * 4 );
+    printf( "  %lu erases per segment, endurance lasts %.0f years at %.0f cycles (%.0f typical)\n",
+            s->flash_erases / STATS_SEGS, life, ENDURANCE_MIN, life * ENDURANCE_TYP / ENDURANCE_MIN );
+    printf( "  CPU held %.2f ms at most per main loop pass, %.2f ms per commit, %lu flash errors\n",
+            ( double )PassMax * 1000.0 / SIM_HZ, ( double )CommitMax * 1000.0 / SIM_HZ, s->flash_errors );
+    if( s->flash_errors ) Failures++;
+
+    power_loss( );
+
+    printf( "flashbench: %s\n", Failures ? "FAILED" : "ok" );
+    return( Failures ? 1 : 0 );
+}
@@ -0,0 +1,144 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                    Pump Transition Table Check                                      //
+//                                                                                                     //
+//                                                                                                     //
+// File              : fsmcheck.c                                                                      //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Walks every ( state, event ) cell of PumpTable.  A cell must either ignore its event or name a      //
+// valid next state and an action.  Each action is run on the emulated ports from every relay          //
+// combination, and the relays and LEDs the output stage then drives must be a combination             //
+// PumpRelaysAllowed permits for the next state; every relay starts free of its minimum time.  Exits   //
+// 1 on the first table that fails, so `make bench` stops there.                                       //
+//                                                                                                     //
+// Built for more than one well (fsmcheck-w4) every action is run for every well, with the other       //
+// wells' relays set to each combination as well, and must leave those alone.                          //
+//                                                                                                     //
+// Usage: fsmcheck                                                                                     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+
+#include "../lwc.h"
+#include "../pumps.h"
+#include "../relay.h"
+#include "sim.h"
+
+volatile unsigned char WakeEvents;              // main.c is not linked
+
+static const char * const state_names[ PUMP_STATES ] = {
+    "ALL_STOP", "RAISE_LEVEL", "AERATE", "RAISE_LEVEL_IN_DURATION", "LOWER_LEVEL", "RAISE_LEVEL_B4_ALL_STOP"
+};
+
+static const char * const event_names[ PUMP_EVENTS ] = {
+    "EV_FULL", "EV_EMPTY", "EV_INTERVAL", "EV_DURATION", "EV_DRAINED"
+};
+
+static const char * const relay_names[ 4 ] = { "off", "fill", "drain", "both" };
+
+// Drives well w's relays (active low) and LEDs to combination c, bit 0 fill, bit 1 drain
+static void set_relays( unsigned char w, int c ) {
+
+    if( c & 1 ) { SPRAY_FILL_RELAY_ON( w ); SPRAY_FILL_LED_ON( w ); }
+    else { SPRAY_FILL_RELAY_OFF( w ); SPRAY_FILL_LED_OFF( w ); }
+    if( c & 2 ) { DRAIN_RELAY_ON( w ); DRAIN_LED_ON( w ); }
+    else { DRAIN_RELAY_OFF( w ); DRAIN_LED_OFF( w ); }
+}
+
+// Combination well w's relays are in, or -1 when an LED disagrees with its relay
+static int get_relays( unsigned char w ) {
+
+    int fill = !( RELAY_OUT & FILL_BIT( w ) ), drain = !( RELAY_OUT & DRAIN_BIT( w ) );
+
+#if LWC_WELLS == 1
+    if( fill != !!( P1OUT & BIT0 ) || drain != !!( P1OUT & BIT6 ) ) return( -1 );
+#endif
+    return( fill | ( drain << 1 ) );
+}
+
+// The other wells' relays, which an action for well w must not touch
+static unsigned char others( unsigned char w ) {
+
+    return( RELAY_OUT & RELAY_BITS & ~( FILL_BIT( w ) | DRAIN_BIT( w ) ) );
+}
+
+int main( void ) {
+
+    const PUMPTRANS *t;
+    int s, e, from, c, bad = 0, moves = 0;
+    unsigned char w, o, rest;
+
+    sim_reset();
+    P1DIR |= BIT0 | BIT6;
+    RELAY_DIR |= RELAY_BITS;
+
+    // Two 16-bit code pointers and the next state, padded, on the target
+    printf( "pump transition table, %d cells, %d bytes of flash on the G2553:\n",
+            PUMP_STATES * PUMP_EVENTS, PUMP_STATES * PUMP_EVENTS * 6 );
+
+    for( s = 0; s < PUMP_STATES; s++ ) {
+        for( e = 0; e < PUMP_EVENTS; e++ ) {
+            t = &PumpTable[ s ][ e ];
+
+            if( t->next == PUMP_STAY ) {
+                if( t->action || t->guard ) {
+                    printf( "  %s / %s: ignored event has an action or guard\n", state_names[ s ], event_names[ e ] );
+                    bad++;
+                }
+                continue;
+            }
+
+            if( t->next >= PUMP_STATES || !t->action ) {
+                printf( "  %s / %s: cell not filled in (next %u, %s action)\n", state_names[ s ], event_names[ e ],
+                        t->next, t->action ? "with" : "no" );
+                bad++;
+                continue;
+            }
+
+            moves++;
+            for( w = 0; w < LWC_WELLS; w++ ) {
+                for( from = 0; from < 4; from++ ) {
+                    for( o = 0; o < ( LWC_WELLS > 1 ? 4 : 1 ); o++ ) {
+                        for( c = 0; c < LWC_WELLS; c++ ) set_relays( c, o );
+                        set_relays( w, from );
+                        RelayInit();
+                        rest = others( w );
+                        t->action( w );
+                        RelayCommit();
+                        c = get_relays( w );
+                        if( c < 0 ) {
+                            printf( "  %s / %s: LEDs do not follow the relays\n", state_names[ s ], event_names[ e ] );
+                            bad++;
+                        } else if( !( PumpRelaysAllowed[ t->next ] & ( 1 << c ) ) ) {
+                            printf( "  %s / %s -> %s: well %u relays %s from %s\n", state_names[ s ],
+                                    event_names[ e ], state_names[ t->next ], w, relay_names[ c ], relay_names[ from ] );
+                            bad++;
+                        }
+                        if( others( w ) != rest ) {
+                            printf( "  %s / %s: well %u action moved another well's relays\n", state_names[ s ],
+                                    event_names[ e ], w );
+                            bad++;
+                        }
+                    }
+                }
+            }
+            printf( "  %-24s %-12s -> %-24s relays %s%s\n", state_names[ s ], event_names[ e ],
+                    state_names[ t->next ], relay_names[ get_relays( LWC_WELLS - 1 ) & 3 ], t->guard ? ", guarded" : "" );
+        }
+    }
+
+    printf( "  %d transitions, %d ignored events, run for %d well%s\n", moves, PUMP_STATES * PUMP_EVENTS - moves,
+            LWC_WELLS, LWC_WELLS > 1 ? "s" : "" );
+    if( bad ) {
+        printf( "FAILED: %d problems in PumpTable\n", bad );
+        return( 1 );
+    }
+    return( 0 );
+}
@@ -0,0 +1,181 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                         Timer Interrupt Bench                                       //
+//                                                                                                     //
+//                                                                                                     //
+// File              : isrbench.c                                                                      //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs each scenario through lwcsim and holds its timer interrupts an hour and its CPU time against   //
+// a baseline written by -w: the one TA1 compare that runs every deadline should take no more of       //
+// either than it did, and a fraction of the two 1 ms ticks the firmware once took, which lwcsim       //
+// counts beside it.                                                                                   //
+//                                                                                                     //
+// Exits 1 if a scenario fails to run, if its timer interrupts or CPU grew by more than -t percent     //
+// over the baseline, if the baseline has no numbers for it, or if its timer interrupts are not under  //
+// the ticks'.  The simulator is the same every run, so a change in the numbers is a change in the     //
+// firmware.                                                                                           //
+//                                                                                                     //
+// Usage: isrbench [-b baseline] [-w baseline] [-t percent] [scenario ...], scenarios/day.txt,         //
+//        tournament.txt and sag.txt by default                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BASE                16
+
+static const char * const defaults[ ] = {
+    "scenarios/day.txt", "scenarios/tournament.txt", "scenarios/sag.txt"
+};
+
+typedef struct {
+    double          timer_h, ticks_h;           // timer interrupts an hour, and the two ticks'
+    double          timer_cpu, cpu;             // percent: the timer interrupts', and all active time
+} result_t;
+
+typedef struct {
+    char            scenario[ 64 ];
+    double          timer_h, cpu;
+} base_t;
+
+static base_t base[ MAX_BASE ];
+static int nbase;
+
+// Runs lwcsim on a scenario and picks its summary lines apart
+static int run( const char *scenario, result_t *r ) {
+
+    char cmd[ 512 ], line[ 256 ];
+    FILE *p;
+    int found = 0;
+
+    memset( r, 0, sizeof( *r ) );
+    snprintf( cmd, sizeof( cmd ), "./lwcsim -q -f %s", scenario );
+    if( !( p = popen( cmd, "r" ) ) ) {
+        perror( "lwcsim" );
+        return( -1 );
+    }
+    while( fgets( line, sizeof( line ), p ) ) {
+        if( sscanf( line, "# timer isrs %lf an hour, %lf%% cpu; two 1 ms ticks: %lf", &r->timer_h, &r->timer_cpu,
+                    &r->ticks_h ) == 3 ) found |= 1;
+        if( sscanf( line, "# cpu %lf%% active", &r->cpu ) == 1 ) found |= 2;
+    }
+    if( pclose( p ) || found != 3 ) {
+        fprintf( stderr, "isrbench: lwcsim did not run %s\n", scenario );
+        return( -1 );
+    }
+    return( 0 );
+}
+
+// Baseline lines are "<scenario> <timer interrupts an hour> <cpu percent>"
+static int load_base( const char *path ) {
+
+    char line[ 128 ];
+    FILE *f = fopen( path, "r" );
+
+    if( !f ) {
+        perror( path );
+        return( -1 );
+    }
+    while( fgets( line, sizeof( line ), f ) && nbase < MAX_BASE ) {
+        if( line[ 0 ] == '#' || sscanf( line, "%63s %lf %lf", base[ nbase ].scenario, &base[ nbase ].timer_h,
+                                        &base[ nbase ].cpu ) != 3 ) continue;
+        nbase++;
+    }
+    fclose( f );
+    return( 0 );
+}
+
+static const base_t *find_base( const char *scenario ) {
+
+    int k;
+
+    for( k = 0; k < nbase; k++ ) {
+        if( !strcmp( base[ k ].scenario, scenario ) ) return( &base[ k ] );
+    }
+    return( 0 );
+}
+
+static void usage( const char *me ) {
+
+    fprintf( stderr, "usage: %s [-b baseline] [-w baseline] [-t percent] [scenario ...]\n", me );
+    exit( 2 );
+}
+
+int main( int argc, char **argv ) {
+
+    const char *bpath = 0, *wpath = 0;
+    const char * const *scenarios = defaults;
+    const base_t *was;
+    int n = ( int )( sizeof( defaults ) / sizeof( defaults[ 0 ] ) );
+    int a, k, tol = 2, failures = 0;
+    result_t r;
+    FILE *w = 0;
+
+    for( a = 1; a < argc && argv[ a ][ 0 ] == '-'; a++ ) {
+        if( a + 1 >= argc ) usage( argv[ 0 ] );
+        if( !strcmp( argv[ a ], "-b" ) ) bpath = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-w" ) ) wpath = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-t" ) ) tol = atoi( argv[ ++a ] );
+        else usage( argv[ 0 ] );
+    }
+    if( a < argc ) {
+        scenarios = ( const char * const * )argv + a;
+        n = argc - a;
+    }
+    if( bpath && load_base( bpath ) ) return( 1 );
+    if( wpath && !( w = fopen( wpath, "w" ) ) ) {
+        perror( wpath );
+        return( 1 );
+    }
+    if( w ) fprintf( w, "# timer interrupts an hour and cpu percent active, lwcsim; isrbench -w rewrites it\n" );
+
+    printf( "isrbench: %-26s %19s %9s %17s\n", "", "timer isrs an hour", "timer", "cpu, %" );
+    printf( "isrbench: %-26s %9s %9s %9s %8s %8s\n", "scenario", "now", "baseline", "cpu, %", "now", "baseline" );
+
+    for( k = 0; k < n; k++ ) {
+        if( run( scenarios[ k ], &r ) ) {
+            failures++;
+            continue;
+        }
+        was = bpath ? find_base( scenarios[ k ] ) : 0;
+        printf( "isrbench: %-26s %9.0f", scenarios[ k ], r.timer_h );
+        if( was ) printf( " %9.0f", was->timer_h );
+        else printf( " %9s", bpath ? "new" : "" );
+        printf( " %9.3f %8.3f", r.timer_cpu, r.cpu );
+        if( was ) printf( " %8.3f", was->cpu );
+        printf( "\n" );
+        if( w ) fprintf( w, "%s %.0f %.3f\n", scenarios[ k ], r.timer_h, r.cpu );
+
+        if( r.timer_h >= r.ticks_h ) {
+            printf( "  %s: %.0f timer interrupts an hour, no fewer than the two ticks' %.0f\n", scenarios[ k ],
+                    r.timer_h, r.ticks_h );
+            failures++;
+        }
+        if( !bpath ) continue;
+        if( !was ) {
+            printf( "  %s: not in the baseline\n", scenarios[ k ] );
+            failures++;
+            continue;
+        }
+        if( r.timer_h * 100.0 > was->timer_h * ( 100 + tol ) ) {
+            printf( "  %s: %.0f more timer interrupts an hour\n", scenarios[ k ], r.timer_h - was->timer_h );
+            failures++;
+        }
+        if( r.cpu * 100.0 > was->cpu * ( 100 + tol ) ) {
+            printf( "  %s: %.3f%% more cpu\n", scenarios[ k ], r.cpu - was->cpu );
+            failures++;
+        }
+    }
+    if( w && fclose( w ) ) return( 1 );
+
+    printf( "isrbench: %s\n", failures ? "FAILED" : "ok" );
+    return( failures ? 1 : 0 );
+}
@@ -0,0 +1,1086 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                  MSP430 Instruction Set Simulator                                   //
+//                                                                                                     //
+//                                                                                                     //
+// File              : iss430.c                                                                        //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs the real firmware image, lwc.elf from msp430-elf-gcc, one instruction at a time and counts     //
+// MCLK cycles the way the MSP430x2xx family guide's tables do (section 3.4.4): format I by source and //
+// destination addressing mode, format II by mode, 2 for a jump, 5 for RETI and 6 to accept an         //
+// interrupt.  The CPU is the G2553's, the original MSP430 without the X extensions, at 1 MHz.         //
+//                                                                                                     //
+// Only what the firmware touches is modelled, enough to run it as it runs on the board: TA1 counting  //
+// ACLK with its CCR0 compare, the ADC10 and its two-block DTC, the port 2 edge flags, the USCI_A0     //
+// transmitter at 9600 baud, and flash programming with its timing.  Anything else reads back what was //
+// last written.  In LPM the clock jumps to the next thing that can raise a flag, so a sleeping part   //
+// costs nothing to simulate.                                                                          //
+//                                                                                                     //
+// The profiler follows the functions named to iss_watch from the symbol table.  A function is entered //
+// when a CALL, a branch or an interrupt lands on its first instruction, and left when the stack       //
+// pointer comes back above the return address, which covers RET, RETI and tail calls.  Time in        //
+// interrupts and in LPM is left out of a function's cycles, so a call costs what it costs.  Every     //
+// function in the image is followed the same way to find the heaviest chain of calls under the        //
+// longest call of each watched one.                                                                   //
+//                                                                                                     //
+// The stack is measured the same way, after every instruction: how far the main loop has taken it     //
+// below the top of RAM, how far it had with GIE set, and how far any interrupt has taken it below     //
+// where it came in.  An interrupt can only arrive where GIE is set, so the worst case the part can    //
+// see is the deepest of those plus the deepest interrupt, whether or not the run happened to line     //
+// them up; the main loop's own deepest, often with GIE clear, can be more.                            //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iss430.h"
+
+#define MAX_SYMS                2048
+#define MAX_FRAMES              64
+#define PATH_LEN                160
+
+// Status register
+#define SR_C                    0x0001
+#define SR_Z                    0x0002
+#define SR_N                    0x0004
+#define SR_GIE                  0x0008
+#define SR_CPUOFF               0x0010
+#define SR_SCG0                 0x0040
+#define SR_V                    0x0100
+
+// G2553 registers, msp430g2553.h
+#define IE2                     0x0001
+#define IFG1                    0x0002
+#define IFG2                    0x0003
+#define P2IN                    0x0028
+#define P2IFG                   0x002B
+#define P2IES                   0x002C
+#define P2IE                    0x002D
+#define ADC10DTC0               0x0048
+#define ADC10DTC1               0x0049
+#define UCA0TXBUF               0x0067
+#define WDTCTL                  0x0120
+#define FCTL1                   0x0128
+#define FCTL2                   0x012A
+#define FCTL3                   0x012C
+#define TA1CTL                  0x0180
+#define TA1CCTL0                0x0182
+#define TA1R                    0x0190
+#define TA1CCR0                 0x0192
+#define ADC10CTL0               0x01B0
+#define ADC10CTL1               0x01B2
+#define ADC10MEM                0x01B4
+#define ADC10SA                 0x01BC
+
+#define INFO_BASE               0x1000
+#define INFO_END                0x1100
+#define FLASH_BASE              0xC000          // 16 kB main flash
+#define RAM_BASE                0x0200
+#define RAM_END                 0x0400
+
+// Vectors, highest priority first
+#define VEC_TIMER1_A0           0xFFFA
+#define VEC_USCIAB0TX           0xFFEC
+#define VEC_ADC10               0xFFEA
+#define VEC_PORT2               0xFFE6
+#define VEC_RESET               0xFFFE
+
+#define PORIFG                  0x04
+#define UCA0TXIFG               0x02
+#define CCIFG                   0x0001
+#define CCIE                    0x0010
+#define TACLR                   0x0004
+#define MC_BITS                 0x0030
+#define ADC10SC                 0x0001
+#define ENC                     0x0002
+#define ADC10IFG                0x0004
+#define ADC10IE                 0x0008
+#define ADC10ON                 0x0010
+#define ADC10BUSY               0x0001
+#define CONSEQ_BITS             0x0006
+#define ADC10B1                 0x02
+#define ADC10CT                 0x04
+#define ADC10TB                 0x08
+#define FL_ERASE                0x0002
+#define FL_MERAS                0x0004
+#define FL_WRT                  0x0040
+
+#define ADC_CONV_CYC            16              // 64 + 13 ADC10OSC (~5 MHz) clocks per channel
+#define UART_BYTE_CYC           1042            // 10 bits at 9600 baud
+#define FLASH_WORD_TFTG         30              // program time of one word, flash timing generator clocks
+#define FLASH_ERASE_TFTG        4819            // segment erase
+#define NEVER                   ( ~( uint64_t )0 )
+
+typedef struct {
+    char                name[ 48 ];
+    uint16_t            addr;
+    int                 func;
+} sym_t;
+
+// Where an operand lives: a register, or memory at addr
+typedef struct {
+    int                 reg;                    // -1 for memory
+    uint16_t            addr;
+} opnd_t;
+
+// One function being run, from its first instruction until SP comes back above sp
+typedef struct {
+    int                 sym;
+    int                 prof;                   // iss_watch slot, -1 if not watched
+    int                 isr;                    // entered by an interrupt, or inside one
+    uint16_t            sp;
+    uint64_t            start, away;            // away: interrupt and LPM time when it started
+    uint64_t            heavy;                  // heaviest callee so far, and the chain under it
+    char                path[ PATH_LEN ];
+} frame_t;
+
+static uint8_t mem[ 0x10000 ];
+static uint16_t R[ 16 ];
+static uint64_t cyc, busy, away;                // away: cycles in interrupts and LPM
+static const char *fault;
+
+static sym_t syms[ MAX_SYMS ];
+static int nsyms;
+static int16_t sym_at[ 0x10000 ];               // function starting at an address, -1 for none
+static char built_by[ 128 ];                    // the image's .comment, the toolchain that built it
+
+static iss_prof_t prof[ ISS_PROFILES ];
+static int nprof;
+static char prof_path[ ISS_PROFILES ][ PATH_LEN ];
+static frame_t frames[ MAX_FRAMES ];
+static int nframes;
+static int entering;                            // last instruction was a CALL, a branch or an interrupt
+static int in_isr;
+static uint64_t isr_start;
+static uint16_t isr_sp;                         // stack pointer the interrupt came in on
+static iss_stack_t stack;
+
+static iss_latency_t t1_lat;
+static uint64_t t1_raised;                      // CCIFG set by the compare, NEVER if by software
+static uint64_t gie_off_at = NEVER, gie_off_max;
+static uint16_t gie_off_pc, gie_off_max_pc;
+
+// Peripheral state
+static uint64_t ta1_base;                       // ACLK tick TA1R last read zero at
+static uint64_t ta1_compare = NEVER;            // cycle CCR0 next matches
+static uint64_t adc_done = NEVER;
+static unsigned int analog[ 16 ];
+static unsigned int dtc_pos, dtc_block;
+static uint64_t uart_done = NEVER;
+static int uart_pending;                        // a byte waits in UCA0TXBUF behind the shifter
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Image                                                                                               //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static uint32_t le32( const uint8_t *p ) {
+
+    return( p[ 0 ] | p[ 1 ] << 8 | p[ 2 ] << 16 | ( uint32_t )p[ 3 ] << 24 );
+}
+
+static uint16_t le16( const uint8_t *p ) {
+
+    return( ( uint16_t )( p[ 0 ] | p[ 1 ] << 8 ) );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Erases the part, as before it is programmed.                                           //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Flash and the vectors read 0xFF and RAM 0, with no symbols.  iss_load       //
+//                         starts here; a program assembled by hand goes in with iss_program.          //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void iss_erase( void ) {
+
+    memset( mem, 0xFF, sizeof( mem ) );
+    memset( mem, 0, RAM_END );
+    mem[ 0x10FE ] = 0xB5;                       // CALDCO_1MHZ and CALBC1_1MHZ, any values do
+    mem[ 0x10FF ] = 0x86;
+    memset( sym_at, 0xFF, sizeof( sym_at ) );
+    nsyms = 0;
+    built_by[ 0 ] = 0;
+}
+
+// A word put straight into memory, flash or not, as the programmer would
+void iss_program( uint16_t addr, uint16_t v ) {
+
+    mem[ addr & 0xFFFE ] = ( uint8_t )v;
+    mem[ addr | 1 ] = ( uint8_t )( v >> 8 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Loads an ELF image: its PT_LOAD segments at their load addresses, its symbols and the  //
+//              toolchain its .comment names.                                                          //
+// Arguments:   path - the firmware linked for the G2553                                               //
+// Returns:     0, or -1 with the reason on stderr                                                     //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Loads as the programmer would, so .data is in flash until crt0 copies it.   //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int iss_load( const char *path ) {
+
+    FILE *f = fopen( path, "rb" );
+    uint8_t *elf;
+    const uint8_t *ph, *sh, *sym, *str, *names;
+    long size;
+    uint32_t k, n, off, len, addr, phoff, shoff, link;
+
+    if( !f ) {
+        perror( path );
+        return( -1 );
+    }
+    fseek( f, 0, SEEK_END );
+    size = ftell( f );
+    rewind( f );
+    if( size < 52 || !( elf = malloc( ( size_t )size ) ) || fread( elf, 1, ( size_t )size, f ) != ( size_t )size ) {
+        fprintf( stderr, "iss430: cannot read %s\n", path );
+        fclose( f );
+        return( -1 );
+    }
+    fclose( f );
+    if( memcmp( elf, "\177ELF\001\001", 6 ) || le16( elf + 18 ) != 105 ) {
+        fprintf( stderr, "iss430: %s is not a 32-bit MSP430 ELF\n", path );
+        free( elf );
+        return( -1 );
+    }
+
+    iss_erase( );
+    phoff = le32( elf + 28 );
+    for( k = 0; k < le16( elf + 44 ); k++ ) {
+        ph = elf + phoff + k * le16( elf + 42 );
+        if( ph + 32 > elf + size || le32( ph ) != 1 ) continue;
+        off = le32( ph + 4 );
+        addr = le32( ph + 12 );                 // p_paddr, where it is programmed
+        len = le32( ph + 16 );
+        if( off + len > ( uint32_t )size || addr + len > 0x10000 ) continue;
+        memcpy( mem + addr, elf + off, len );
+    }
+
+    shoff = le32( elf + 32 );
+    names = elf + le32( elf + shoff + le16( elf + 50 ) * le16( elf + 46 ) + 16 );
+    for( k = 0; k < le16( elf + 48 ); k++ ) {
+        sh = elf + shoff + k * le16( elf + 46 );
+        if( sh + 40 > elf + size ) continue;
+        if( !strcmp( ( const char * )names + le32( sh ), ".comment" ) && le32( sh + 16 ) + le32( sh + 20 ) <= ( uint32_t )size ) {
+            snprintf( built_by, sizeof( built_by ), "%.*s", ( int )le32( sh + 20 ), ( const char * )elf + le32( sh + 16 ) );
+        }
+        if( le32( sh + 4 ) != 2 ) continue;                                 // SHT_SYMTAB
+        link = le32( sh + 24 );
+        str = elf + le32( elf + shoff + link * le16( elf + 46 ) + 16 );
+        for( n = 1; n < le32( sh + 20 ) / 16 && nsyms < MAX_SYMS; n++ ) {
+            sym = elf + le32( sh + 16 ) + n * 16;
+            if( !le32( sym ) || ( sym[ 12 ] & 0xF ) > 2 ) continue;       // unnamed, or not object or func
+            snprintf( syms[ nsyms ].name, sizeof( syms[ nsyms ].name ), "%s", ( const char * )str + le32( sym ) );
+            syms[ nsyms ].addr = ( uint16_t )le32( sym + 4 );
+            syms[ nsyms ].func = ( sym[ 12 ] & 0xF ) == 2;
+            if( syms[ nsyms ].func ) sym_at[ syms[ nsyms ].addr ] = ( int16_t )nsyms;
+            nsyms++;
+        }
+    }
+    free( elf );
+    return( 0 );
+}
+
+uint16_t iss_symbol( const char *name ) {
+
+    int k;
+
+    for( k = 0; k < nsyms; k++ ) {
+        if( !strcmp( syms[ k ].name, name ) ) return( syms[ k ].addr );
+    }
+    return( 0 );
+}
+
+// Name of the function an address is in: the nearest function symbol at or below it
+const char *iss_symbol_at( uint16_t addr ) {
+
+    int k, best = -1;
+
+    for( k = 0; k < nsyms; k++ ) {
+        if( syms[ k ].func && syms[ k ].addr <= addr && ( best < 0 || syms[ k ].addr > syms[ best ].addr ) ) best = k;
+    }
+    return( best < 0 ? "?" : syms[ best ].name );
+}
+
+// The first string in the image's .comment, as "GCC: (...) 9.3.1", or "" if it has none
+const char *iss_built_by( void ) {
+
+    return( built_by );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Peripherals                                                                                         //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static uint16_t reg16( uint16_t a ) {
+
+    return( le16( mem + a ) );
+}
+
+static void set16( uint16_t a, uint16_t v ) {
+
+    mem[ a ] = ( uint8_t )v;
+    mem[ a + 1 ] = ( uint8_t )( v >> 8 );
+}
+
+static uint64_t aclk_at( uint64_t c ) {
+
+    return( c * ISS_ACLK_HZ / ISS_MCLK_HZ );
+}
+
+// First cycle an ACLK tick is seen on
+static uint64_t cycle_of( uint64_t tick ) {
+
+    return( ( tick * ISS_MCLK_HZ + ISS_ACLK_HZ - 1 ) / ISS_ACLK_HZ );
+}
+
+static uint16_t ta1r( void ) {
+
+    if( !( reg16( TA1CTL ) & MC_BITS ) ) return( reg16( TA1R ) );
+    return( ( uint16_t )( aclk_at( cyc ) - ta1_base ) );
+}
+
+// Continuous mode only, as the firmware runs it: CCR0 matches when TA1R next counts to it
+static void ta1_schedule( void ) {
+
+    uint64_t now = aclk_at( cyc );
+    uint16_t ahead = ( uint16_t )( reg16( TA1CCR0 ) - ( uint16_t )( now - ta1_base ) );
+
+    if( !( reg16( TA1CTL ) & MC_BITS ) ) {
+        ta1_compare = NEVER;
+        return;
+    }
+    ta1_compare = cycle_of( now + ( ahead ? ahead : 0x10000 ) );
+}
+
+static unsigned int adc_channels( void ) {
+
+    if( ( reg16( ADC10CTL1 ) & CONSEQ_BITS ) != 0x0002 && ( reg16( ADC10CTL1 ) & CONSEQ_BITS ) != 0x0006 ) return( 1 );
+    return( ( reg16( ADC10CTL1 ) >> 12 ) + 1u );
+}
+
+// The sequence's results go out all at once at its end; the firmware only looks at the blocks
+static void adc_complete( void ) {
+
+    unsigned int n = mem[ ADC10DTC1 ], k, ch = reg16( ADC10CTL1 ) >> 12;
+
+    for( k = adc_channels( ); k; k--, ch-- ) {
+        set16( ADC10MEM, ( uint16_t )analog[ ch & 15 ] );
+        if( !n ) continue;
+        set16( ( uint16_t )( reg16( ADC10SA ) + 2 * ( dtc_block * n + dtc_pos ) ), ( uint16_t )analog[ ch & 15 ] );
+        if( ++dtc_pos < n ) continue;
+        dtc_pos = 0;
+        set16( ADC10CTL0, reg16( ADC10CTL0 ) | ADC10IFG );
+        if( !( mem[ ADC10DTC0 ] & ADC10TB ) ) continue;
+        mem[ ADC10DTC0 ] = ( uint8_t )( dtc_block ? mem[ ADC10DTC0 ] & ~ADC10B1 : mem[ ADC10DTC0 ] | ADC10B1 );
+        dtc_block ^= 1;
+    }
+    if( !n ) set16( ADC10CTL0, reg16( ADC10CTL0 ) | ADC10IFG );
+    set16( ADC10CTL1, reg16( ADC10CTL1 ) & ~ADC10BUSY );
+    adc_done = NEVER;
+}
+
+static void uart_complete( void ) {
+
+    if( uart_pending ) {                        // the waiting byte moves into the shifter
+        uart_pending = 0;
+        mem[ IFG2 ] |= UCA0TXIFG;
+        uart_done += UART_BYTE_CYC;
+    } else uart_done = NEVER;
+}
+
+// Raises whatever flags are due by now
+static void peripherals( void ) {
+
+    while( cyc >= ta1_compare ) {
+        if( !( reg16( TA1CCTL0 ) & CCIFG ) ) t1_raised = ta1_compare;
+        set16( TA1CCTL0, reg16( TA1CCTL0 ) | CCIFG );
+        ta1_compare = cycle_of( aclk_at( ta1_compare ) + 0x10000 );
+    }
+    if( cyc >= adc_done ) adc_complete( );
+    while( cyc >= uart_done ) uart_complete( );
+}
+
+static uint64_t next_event( void ) {
+
+    uint64_t t = ta1_compare;
+
+    if( adc_done < t ) t = adc_done;
+    if( uart_done < t ) t = uart_done;
+    return( t );
+}
+
+// Flash programming and erase, the CPU held for as long as the flash timing generator takes
+static void flash_write( uint16_t a, uint16_t v, int word ) {
+
+    unsigned int fn = ( reg16( FCTL2 ) & 0x3F ) + 1u, seg;
+    unsigned int f1 = reg16( FCTL1 );
+
+    if( f1 & ( FL_ERASE | FL_MERAS ) ) {
+        seg = a < INFO_END ? 64 : 512;
+        memset( mem + ( a & ~( seg - 1 ) ), 0xFF, seg );
+        cyc += ( uint64_t )FLASH_ERASE_TFTG * fn;
+        set16( FCTL1, ( uint16_t )( f1 & ~( FL_ERASE | FL_MERAS ) ) );
+        return;
+    }
+    if( !( f1 & FL_WRT ) ) return;              // locked: a real part would flag ACCVIFG
+    mem[ a ] &= ( uint8_t )v;
+    if( word ) mem[ a + 1 ] &= ( uint8_t )( v >> 8 );
+    cyc += ( uint64_t )FLASH_WORD_TFTG * fn;
+}
+
+static uint16_t io_read( uint16_t a ) {
+
+    switch( a ) {
+    case TA1R:      return( ta1r( ) );
+    case WDTCTL:    return( ( uint16_t )( 0x6900 | mem[ a ] ) );
+    case FCTL1:
+    case FCTL2:     return( ( uint16_t )( 0x9600 | mem[ a ] ) );
+    case FCTL3:     return( ( uint16_t )( 0x9608 | ( mem[ a ] & ~0x09 ) ) );   // WAIT, never BUSY
+    }
+    return( reg16( a ) );
+}
+
+static void io_write( uint16_t a, uint16_t v, int word ) {
+
+    uint8_t was;
+
+    switch( a ) {
+    case WDTCTL:                                // held or not, the watchdog never bites here
+    case FCTL1:
+    case FCTL2:
+    case FCTL3:
+        if( ( v >> 8 ) == 0xA5 ) mem[ a ] = ( uint8_t )v;
+        return;
+    case TA1CTL:
+        if( v & TACLR ) ta1_base = aclk_at( cyc );
+        set16( a, ( uint16_t )( v & ~TACLR ) );
+        ta1_schedule( );
+        return;
+    case TA1R:
+        ta1_base = aclk_at( cyc ) - v;
+        ta1_schedule( );
+        return;
+    case TA1CCR0:
+        set16( a, v );
+        ta1_schedule( );
+        return;
+    case TA1CCTL0:
+        if( ( v & CCIFG ) && !( reg16( a ) & CCIFG ) ) t1_raised = NEVER;    // forced, not a compare
+        set16( a, v );
+        return;
+    case ADC10CTL0:
+        set16( a, ( uint16_t )( v & ~ADC10SC ) );
+        if( adc_done == NEVER && ( v & ( ADC10ON | ENC | ADC10SC ) ) == ( ADC10ON | ENC | ADC10SC ) ) {
+            set16( ADC10CTL1, reg16( ADC10CTL1 ) | ADC10BUSY );
+            adc_done = cyc + adc_channels( ) * ADC_CONV_CYC;
+        }
+        return;
+    case ADC10SA:                               // starts the DTC again from the first block
+        set16( a, v );
+        dtc_pos = dtc_block = 0;
+        mem[ ADC10DTC0 ] &= ( uint8_t )~ADC10B1;
+        return;
+    case UCA0TXBUF:
+        mem[ a ] = ( uint8_t )v;
+        if( uart_done == NEVER ) uart_done = cyc + UART_BYTE_CYC;
+        else {
+            uart_pending = 1;
+            mem[ IFG2 ] &= ( uint8_t )~UCA0TXIFG;
+        }
+        return;
+    case P2IN:
+        return;
+    }
+    was = mem[ a ];
+    if( word ) set16( a, v );
+    else mem[ a ] = ( uint8_t )v;
+    if( a == ADC10DTC0 ) mem[ a ] = ( uint8_t )( ( v & ~ADC10B1 ) | ( was & ADC10B1 ) );
+}
+
+static uint8_t rd8( uint16_t a ) {
+
+    if( a < RAM_BASE ) return( ( uint8_t )( io_read( ( uint16_t )( a & ~1 ) ) >> ( a & 1 ? 8 : 0 ) ) );
+    return( mem[ a ] );
+}
+
+static uint16_t rd16( uint16_t a ) {
+
+    a &= 0xFFFE;
+    if( a < RAM_BASE ) return( io_read( a ) );
+    return( le16( mem + a ) );
+}
+
+static void wr8( uint16_t a, uint8_t v ) {
+
+    if( a < RAM_BASE ) io_write( a, v, 0 );
+    else if( a < RAM_END ) mem[ a ] = v;
+    else if( ( a >= INFO_BASE && a < INFO_END ) || a >= FLASH_BASE ) flash_write( a, v, 0 );
+}
+
+static void wr16( uint16_t a, uint16_t v ) {
+
+    a &= 0xFFFE;
+    if( a < RAM_BASE ) io_write( a, v, 1 );
+    else if( a < RAM_END ) set16( a, v );
+    else if( ( a >= INFO_BASE && a < INFO_END ) || a >= FLASH_BASE ) flash_write( a, v, 1 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Profiler                                                                                            //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static void enter( int s ) {
+
+    frame_t *f;
+    int k;
+
+    if( nframes == MAX_FRAMES ) return;
+    f = &frames[ nframes++ ];
+    f->sym = s;
+    f->prof = -1;
+    for( k = 0; k < nprof; k++ ) {
+        if( prof[ k ].addr == syms[ s ].addr ) f->prof = k;
+    }
+    f->isr = in_isr;
+    f->sp = R[ 1 ];
+    f->start = cyc;
+    f->away = away;
+    f->heavy = 0;
+    f->path[ 0 ] = 0;
+}
+
+static void leave( void ) {
+
+    frame_t *f = &frames[ --nframes ], *up = nframes ? &frames[ nframes - 1 ] : 0;
+    uint64_t took = cyc - f->start - ( f->isr ? 0 : away - f->away );
+    iss_prof_t *p;
+    char path[ PATH_LEN ];
+
+    if( f->path[ 0 ] ) snprintf( path, sizeof( path ), "%s > %s", syms[ f->sym ].name, f->path );
+    else snprintf( path, sizeof( path ), "%s", syms[ f->sym ].name );
+
+    if( f->prof >= 0 ) {
+        p = &prof[ f->prof ];
+        if( !p->calls || took < p->min ) p->min = took;
+        if( !p->calls || took > p->max ) {
+            p->max = took;
+            p->max_at = f->start;
+            snprintf( prof_path[ f->prof ], PATH_LEN, "%s", path );
+        }
+        p->calls++;
+        p->total += took;
+    }
+    if( up && up->isr == f->isr && took > up->heavy ) {
+        up->heavy = took;
+        snprintf( up->path, sizeof( up->path ), "%s", path );
+    }
+}
+
+int iss_watch( const char *name ) {
+
+    uint16_t a = iss_symbol( name );
+
+    if( !a || sym_at[ a ] < 0 || nprof == ISS_PROFILES ) return( -1 );
+    memset( &prof[ nprof ], 0, sizeof( prof[ nprof ] ) );
+    prof[ nprof ].name = syms[ sym_at[ a ] ].name;
+    prof[ nprof ].addr = a;
+    return( nprof++ );
+}
+
+const iss_prof_t *iss_profile( int k ) {
+
+    return( k >= 0 && k < nprof ? &prof[ k ] : 0 );
+}
+
+// Heaviest chain of calls under the longest call of a watched function
+const char *iss_worst_path( int k ) {
+
+    return( k >= 0 && k < nprof ? prof_path[ k ] : "" );
+}
+
+const iss_latency_t *iss_timer1_latency( void ) {
+
+    return( &t1_lat );
+}
+
+// Longest time with GIE clear outside interrupts, and where it was cleared
+uint64_t iss_gie_off_max( uint16_t *pc ) {
+
+    if( pc ) *pc = gie_off_max_pc;
+    return( gie_off_max );
+}
+
+const iss_stack_t *iss_stack( void ) {
+
+    return( &stack );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CPU                                                                                                 //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static uint16_t fetch( void ) {
+
+    uint16_t w = rd16( R[ 0 ] );
+
+    R[ 0 ] += 2;
+    return( w );
+}
+
+static void wreg( int r, uint16_t v ) {
+
+    if( r == 0 ) {
+        R[ 0 ] = v & 0xFFFE;
+        entering = 1;
+    } else if( r == 1 ) R[ 1 ] = v & 0xFFFE;
+    else if( r != 3 ) R[ r ] = v;
+}
+
+// Source operand: its value, and its addressing class for the cycle tables: 0 register or constant,
+// 1 @Rn, 2 @Rn+ or #N, 3 indexed, symbolic or absolute
+static uint16_t source( int r, int as, int bw, int *cls, opnd_t *o ) {
+
+    uint16_t a, v;
+
+    o->reg = -1;
+    if( r == 3 ) {
+        *cls = 0;
+        v = ( uint16_t )( as == 0 ? 0 : as == 1 ? 1 : as == 2 ? 2 : 0xFFFF );
+        return( bw ? v & 0xFF : v );
+    }
+    if( r == 2 && as >= 2 ) {
+        *cls = 0;
+        return( as == 2 ? 4 : 8 );
+    }
+    switch( as ) {
+    case 0:
+        *cls = 0;
+        o->reg = r;
+        return( bw ? R[ r ] & 0xFF : R[ r ] );
+    case 1:
+        *cls = 3;
+        a = r == 2 ? 0 : R[ r ];
+        a = ( uint16_t )( a + rd16( R[ 0 ] ) );
+        R[ 0 ] += 2;
+        break;
+    case 2:
+        *cls = 1;
+        a = R[ r ];
+        break;
+    default:
+        *cls = 2;
+        if( r == 0 ) {
+            v = fetch( );
+            return( bw ? v & 0xFF : v );
+        }
+        a = R[ r ];
+        R[ r ] = ( uint16_t )( R[ r ] + ( bw && r != 1 ? 1 : 2 ) );
+        break;
+    }
+    o->addr = a;
+    return( bw ? rd8( a ) : rd16( a ) );
+}
+
+static uint16_t get( const opnd_t *o, int bw ) {
+
+    if( o->reg >= 0 ) return( bw ? R[ o->reg ] & 0xFF : R[ o->reg ] );
+    return( bw ? rd8( o->addr ) : rd16( o->addr ) );
+}
+
+static void put( const opnd_t *o, int bw, uint16_t v ) {
+
+    if( o->reg >= 0 ) wreg( o->reg, bw ? v & 0xFF : v );
+    else if( bw ) wr8( o->addr, ( uint8_t )v );
+    else wr16( o->addr, v );
+}
+
+static void flags( uint32_t r, int bw, int c, int v ) {
+
+    uint32_t msb = bw ? 0x80 : 0x8000, mask = bw ? 0xFF : 0xFFFF;
+
+    R[ 2 ] &= ( uint16_t )~( SR_C | SR_Z | SR_N | SR_V );
+    if( !( r & mask ) ) R[ 2 ] |= SR_Z;
+    if( r & msb ) R[ 2 ] |= SR_N;
+    if( c ) R[ 2 ] |= SR_C;
+    if( v ) R[ 2 ] |= SR_V;
+}
+
+static uint16_t add( uint16_t d, uint16_t s, int carry, int bw ) {
+
+    uint32_t msb = bw ? 0x80 : 0x8000, mask = bw ? 0xFF : 0xFFFF;
+    uint32_t r = ( uint32_t )d + s + ( uint32_t )carry;
+
+    flags( r, bw, ( r & ( mask + 1 ) ) != 0, ( ~( d ^ s ) & ( d ^ r ) & msb ) != 0 );
+    return( ( uint16_t )( r & mask ) );
+}
+
+static uint16_t dadd( uint16_t d, uint16_t s, int bw ) {
+
+    int k, n = bw ? 2 : 4, c = R[ 2 ] & SR_C, x;
+    uint16_t r = 0;
+
+    for( k = 0; k < n; k++ ) {
+        x = ( d >> 4 * k & 15 ) + ( s >> 4 * k & 15 ) + c;
+        c = x > 9;
+        if( c ) x -= 10;
+        r |= ( uint16_t )( x << 4 * k );
+    }
+    flags( r, bw, c, 0 );
+    return( r );
+}
+
+static void push( uint16_t v ) {
+
+    R[ 1 ] -= 2;
+    wr16( R[ 1 ], v );
+}
+
+static uint16_t pop( void ) {
+
+    uint16_t v = rd16( R[ 1 ] );
+
+    R[ 1 ] += 2;
+    return( v );
+}
+
+// Format I: two operands
+static unsigned int double_op( uint16_t ins ) {
+
+    static const unsigned char cycles[ 4 ][ 3 ] = { { 1, 2, 4 }, { 2, 2, 5 }, { 2, 3, 5 }, { 3, 3, 6 } };
+    int op = ins >> 12, sr = ins >> 8 & 15, ad = ins >> 7 & 1, bw = ins >> 6 & 1, as = ins >> 4 & 3, dr = ins & 15;
+    int cls, c = R[ 2 ] & SR_C;
+    uint16_t s, d = 0, r = 0;
+    opnd_t so, o;
+
+    s = source( sr, as, bw, &cls, &so );
+    if( ad ) {
+        o.reg = -1;
+        o.addr = ( uint16_t )( ( dr == 2 ? 0 : R[ dr ] ) + rd16( R[ 0 ] ) );
+        R[ 0 ] += 2;
+    } else o.reg = dr;
+    if( op != 4 ) d = get( &o, bw );
+
+    switch( op ) {
+    case 4:  r = s; break;                                              // MOV
+    case 5:  r = add( d, s, 0, bw ); break;                             // ADD
+    case 6:  r = add( d, s, c, bw ); break;                             // ADDC
+    case 7:  r = add( d, ( uint16_t )~s & ( bw ? 0xFF : 0xFFFF ), c, bw ); break;      // SUBC
+    case 8:                                                             // SUB
+    case 9:  r = add( d, ( uint16_t )~s & ( bw ? 0xFF : 0xFFFF ), 1, bw ); break;      // CMP
+    case 10: r = dadd( d, s, bw ); break;                               // DADD
+    case 11:                                                            // BIT
+    case 15: r = d & s; flags( r, bw, r != 0, 0 ); break;               // AND
+    case 12: r = d & ( uint16_t )~s; break;                             // BIC
+    case 13: r = d | s; break;                                          // BIS
+    case 14:                                                            // XOR
+        r = d ^ s;
+        flags( r, bw, ( r & ( bw ? 0xFF : 0xFFFF ) ) != 0, ( s & d & ( bw ? 0x80 : 0x8000 ) ) != 0 );
+        break;
+    }
+    if( op != 9 && op != 11 ) put( &o, bw, r );
+
+    return( cycles[ cls ][ ad ? 2 : dr == 0 ? 1 : 0 ] );
+}
+
+// Format II: one operand; 0 for an opcode the G2553 does not have
+static unsigned int single_op( uint16_t ins ) {
+
+    int op = ins >> 7 & 7, bw = ins >> 6 & 1, as = ins >> 4 & 3, r = ins & 15, cls;
+    uint16_t v, res, msb = bw ? 0x80 : 0x8000;
+    opnd_t o;
+
+    if( op == 6 ) {                                                     // RETI
+        R[ 2 ] = pop( );
+        R[ 0 ] = pop( );
+        entering = 0;
+        return( 5 );
+    }
+    if( op == 7 ) return( 0 );
+
+    v = source( r, as, bw, &cls, &o );
+    switch( op ) {
+    case 0:                                                             // RRC
+        res = ( uint16_t )( v >> 1 | ( R[ 2 ] & SR_C ? msb : 0 ) );
+        flags( res, bw, v & 1, 0 );
+        put( &o, bw, res );
+        break;
+    case 1:                                                             // SWPB
+        put( &o, 0, ( uint16_t )( v << 8 | v >> 8 ) );
+        break;
+    case 2:                                                             // RRA
+        flags( ( uint32_t )( v >> 1 | ( v & msb ) ), bw, v & 1, 0 );
+        put( &o, bw, ( uint16_t )( v >> 1 | ( v & msb ) ) );
+        break;
+    case 3:                                                             // SXT
+        v = ( uint16_t )( int16_t )( int8_t )( v & 0xFF );
+        flags( v, 0, v != 0, 0 );
+        put( &o, 0, v );
+        break;
+    case 4:                                                             // PUSH
+        push( v );
+        return( cls == 0 ? 3 : cls == 3 ? 5 : 4 );
+    case 5:                                                             // CALL
+        push( R[ 0 ] );
+        R[ 0 ] = v & 0xFFFE;
+        entering = 1;
+        return( cls == 0 || cls == 1 ? 4 : 5 );
+    }
+    return( cls == 0 ? 1 : cls == 3 ? 4 : 3 );
+}
+
+static unsigned int jump( uint16_t ins ) {
+
+    uint16_t sr = R[ 2 ];
+    int take = 0, n = !!( sr & SR_N ), v = !!( sr & SR_V );
+
+    switch( ins >> 10 & 7 ) {
+    case 0: take = !( sr & SR_Z ); break;                               // JNE
+    case 1: take = !!( sr & SR_Z ); break;                              // JEQ
+    case 2: take = !( sr & SR_C ); break;                               // JNC
+    case 3: take = !!( sr & SR_C ); break;                              // JC
+    case 4: take = n; break;                                            // JN
+    case 5: take = n == v; break;                                       // JGE
+    case 6: take = n != v; break;                                       // JL
+    case 7: take = 1; break;                                            // JMP
+    }
+    if( take ) R[ 0 ] = ( uint16_t )( R[ 0 ] + 2 * ( ( int16_t )( ins << 6 ) >> 6 ) );
+    return( 2 );
+}
+
+// Highest priority interrupt that is asking, 0 for none
+static uint16_t pending( void ) {
+
+    if( ( reg16( TA1CCTL0 ) & ( CCIE | CCIFG ) ) == ( CCIE | CCIFG ) ) return( VEC_TIMER1_A0 );
+    if( mem[ IE2 ] & mem[ IFG2 ] & UCA0TXIFG ) return( VEC_USCIAB0TX );
+    if( ( reg16( ADC10CTL0 ) & ( ADC10IE | ADC10IFG ) ) == ( ADC10IE | ADC10IFG ) ) return( VEC_ADC10 );
+    if( mem[ P2IE ] & mem[ P2IFG ] ) return( VEC_PORT2 );
+    return( 0 );
+}
+
+static void accept( uint16_t vec ) {
+
+    isr_sp = R[ 1 ];
+    push( R[ 0 ] );
+    push( R[ 2 ] );
+    R[ 2 ] &= SR_SCG0;
+    R[ 0 ] = rd16( vec );
+    cyc += 6;
+    busy += 6;
+    entering = 1;
+    in_isr = 1;
+    isr_start = cyc - 6;
+
+    if( vec == VEC_TIMER1_A0 ) {                // single source: the flag goes as it is taken
+        set16( TA1CCTL0, reg16( TA1CCTL0 ) & ~CCIFG );
+        if( t1_raised != NEVER ) {
+            if( !t1_lat.n || cyc - t1_raised < t1_lat.min ) t1_lat.min = cyc - t1_raised;
+            if( cyc - t1_raised > t1_lat.max ) t1_lat.max = cyc - t1_raised;
+            t1_lat.total += cyc - t1_raised;
+            t1_lat.n++;
+        }
+    }
+    if( vec == VEC_ADC10 ) set16( ADC10CTL0, reg16( ADC10CTL0 ) & ~ADC10IFG );
+}
+
+// One instruction, or one interrupt accepted; 0 on a fault
+static int step( void ) {
+
+    uint16_t ins, pc = R[ 0 ], sr = R[ 2 ], vec;
+    unsigned int n;
+    int s;
+
+    peripherals( );
+    if( ( R[ 2 ] & SR_GIE ) && ( vec = pending( ) ) ) {
+        accept( vec );
+        pc = R[ 0 ];
+        sr = R[ 2 ];
+    } else if( R[ 2 ] & SR_CPUOFF ) return( 1 );
+
+    if( entering && ( s = sym_at[ pc ] ) >= 0 ) enter( s );
+    entering = 0;
+
+    if( pc & 1 || pc < RAM_BASE || ( pc >= RAM_END && pc < FLASH_BASE ) ) {
+        fault = "PC outside RAM and flash";
+        return( 0 );
+    }
+    ins = fetch( );
+    if( ins >= 0x4000 ) n = double_op( ins );
+    else if( ins >= 0x2000 ) n = jump( ins );
+    else if( ins >= 0x1000 ) n = single_op( ins );
+    else n = 0;
+    if( !n ) {
+        fault = "not an MSP430 instruction";
+        R[ 0 ] = pc;
+        return( 0 );
+    }
+    cyc += n;
+    busy += n;
+
+    if( ( ins & 0xFF80 ) == 0x1300 ) {          // RETI
+        in_isr = 0;
+        away += cyc - isr_start;
+    }
+    while( nframes && R[ 1 ] > frames[ nframes - 1 ].sp ) leave( );
+
+    if( in_isr ) {
+        if( R[ 1 ] < isr_sp && ( unsigned int )( isr_sp - R[ 1 ] ) > stack.isr ) {
+            stack.isr = ( unsigned int )( isr_sp - R[ 1 ] );
+            stack.isr_pc = pc;
+        }
+        return( 1 );
+    }
+    if( R[ 1 ] >= RAM_BASE && R[ 1 ] < RAM_END ) {
+        if( ( unsigned int )( RAM_END - R[ 1 ] ) > stack.main ) stack.main = ( unsigned int )( RAM_END - R[ 1 ] );
+        if( ( R[ 2 ] & SR_GIE ) && ( unsigned int )( RAM_END - R[ 1 ] ) > stack.open ) {
+            stack.open = ( unsigned int )( RAM_END - R[ 1 ] );
+            stack.open_pc = pc;
+        }
+    }
+    if( ( ins & 0xFF80 ) == 0x1300 ) return( 1 );
+    if( ( sr & SR_GIE ) && !( R[ 2 ] & SR_GIE ) ) {
+        gie_off_at = cyc - n;
+        gie_off_pc = pc;
+    }
+    if( !( sr & SR_GIE ) && ( R[ 2 ] & SR_GIE ) && gie_off_at != NEVER ) {
+        if( cyc - gie_off_at > gie_off_max ) {
+            gie_off_max = cyc - gie_off_at;
+            gie_off_max_pc = gie_off_pc;
+        }
+        gie_off_at = NEVER;
+    }
+    return( 1 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Puts the part through a power-on reset.                                                //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Memory keeps the image; RAM is cleared as after power-up.  Profiles,        //
+//                         latencies and stack depths keep counting across resets.                     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void iss_reset( void ) {
+
+    memset( mem, 0, RAM_END );
+    memset( R, 0, sizeof( R ) );
+    mem[ IFG1 ] = PORIFG;
+    mem[ IFG2 ] = UCA0TXIFG;
+    R[ 0 ] = le16( mem + VEC_RESET );
+    entering = 1;
+    in_isr = 0;
+    nframes = 0;
+    fault = 0;
+    ta1_base = aclk_at( cyc );
+    ta1_compare = adc_done = uart_done = NEVER;
+    uart_pending = 0;
+    dtc_pos = dtc_block = 0;
+    gie_off_at = NEVER;
+    cyc += 4;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Runs the part until a cycle count.                                                     //
+// Arguments:   until - iss_now( ) to stop at                                                          //
+// Returns:     0, or -1 on a fault, with iss_fault( ) saying what                                     //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Asleep, the clock goes straight to the next peripheral event, or to until.  //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int iss_run( uint64_t until ) {
+
+    uint64_t t;
+
+    while( cyc < until ) {
+        if( !step( ) ) return( -1 );
+        if( !( R[ 2 ] & SR_CPUOFF ) || ( ( R[ 2 ] & SR_GIE ) && pending( ) ) ) continue;
+        t = next_event( );
+        if( t > until ) t = until;
+        if( t > cyc ) {
+            away += t - cyc;
+            cyc = t;
+        }
+    }
+    return( 0 );
+}
+
+uint64_t iss_now( void ) {
+
+    return( cyc );
+}
+
+// Cycles the CPU was running, not in LPM
+uint64_t iss_active( void ) {
+
+    return( busy );
+}
+
+uint16_t iss_pc( void ) {
+
+    return( R[ 0 ] );
+}
+
+const char *iss_fault( void ) {
+
+    return( fault );
+}
+
+uint16_t iss_read16( uint16_t addr ) {
+
+    return( rd16( addr ) );
+}
+
+void iss_write16( uint16_t addr, uint16_t v ) {
+
+    wr16( addr, v );
+}
+
+// What the ADC10 reads on a channel from now on
+void iss_set_analog( int ch, unsigned int counts ) {
+
+    analog[ ch & 15 ] = counts & 0x3FF;
+}
+
+// Port 2 input levels; edges set P2IFG as P2IES selects
+void iss_set_p2( uint8_t in ) {
+
+    uint8_t was = mem[ P2IN ], rise = ( uint8_t )( in & ~was ), fall = ( uint8_t )( was & ~in );
+
+    mem[ P2IN ] = in;
+    mem[ P2IFG ] |= ( uint8_t )( ( rise & ~mem[ P2IES ] ) | ( fall & mem[ P2IES ] ) );
+}
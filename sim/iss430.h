@@ -0,0 +1,76 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                  MSP430 Instruction Set Simulator                                   //
+//                                                                                                     //
+//                                                                                                     //
+// File              : iss430.h                                                                        //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef ISS430_H
+#define ISS430_H
+
+#include <stdint.h>
+
+#define ISS_MCLK_HZ             1000000UL       // CALBC1_1MHZ, one iss_now( ) unit
+#define ISS_ACLK_HZ             32768UL
+
+#define ISS_PROFILES            16              // functions iss_watch can follow
+
+// One function or interrupt handler followed by iss_watch; cycles exclude interrupts that came in
+typedef struct {
+    const char          *name;
+    uint16_t            addr;
+    unsigned long       calls;
+    uint64_t            total, min, max;
+    uint64_t            max_at;                 // iss_now( ) at the start of the longest call
+} iss_prof_t;
+
+// Interrupt latency: cycles from the flag being raised to the first instruction of the handler
+typedef struct {
+    unsigned long       n;
+    uint64_t            total, min, max;
+} iss_latency_t;
+
+// Stack depth in bytes: the main loop's below the top of RAM, the same only where GIE was set and an
+// interrupt could come in, and the most any interrupt took below the stack pointer it came in on.
+// open + isr is the worst nesting whatever the interleaving; main alone can be deeper with GIE clear.
+typedef struct {
+    unsigned int        main;
+    unsigned int        open;                   // deepest with GIE set
+    unsigned int        isr;
+    uint16_t            open_pc, isr_pc;        // where each was deepest
+} iss_stack_t;
+
+void iss_erase( void );
+void iss_program( uint16_t addr, uint16_t v );
+int iss_load( const char *path );
+uint16_t iss_symbol( const char *name );
+const char *iss_symbol_at( uint16_t addr );
+const char *iss_built_by( void );
+
+void iss_reset( void );
+int iss_run( uint64_t until );
+uint64_t iss_now( void );
+uint64_t iss_active( void );
+uint16_t iss_pc( void );
+const char *iss_fault( void );
+
+uint16_t iss_read16( uint16_t addr );
+void iss_write16( uint16_t addr, uint16_t v );
+
+void iss_set_analog( int ch, unsigned int counts );
+void iss_set_p2( uint8_t in );
+
+int iss_watch( const char *name );
+const iss_prof_t *iss_profile( int k );
+const char *iss_worst_path( int k );
+const iss_latency_t *iss_timer1_latency( void );
+uint64_t iss_gie_off_max( uint16_t *pc );
+const iss_stack_t *iss_stack( void );
+
+#endif
@@ -0,0 +1,475 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                          Command Line Driver                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : lwcsim.c                                                                        //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Usage: lwcsim [-f scenario] [-t hours] [-v] [-q] [-T tracefile] [-U uartfile] [-F flashfile]        //
+//               [-R recording] [-m ms]                                                                //
+//                                                                                                     //
+//   -f scenario    input script (see scenarios/day.txt); default is mid-scale pots and the plant      //
+//   -t hours       simulated run length, default 12 or the script's end                               //
+//   -v             log every output, not just the relays                                              //
+//   -q             summary only                                                                       //
+//   -T tracefile   write the firmware's TraceLog there at the end, for tracedump (lwcsim-original:    //
+//                  the telemetry board is built without the trace)                                    //
+//   -U uartfile    write the bytes sent on UCA0TXD there, for telemdump                               //
+//   -F flashfile   information memory image, loaded first if it exists and saved at the end, so       //
+//                  the pump statistics carry over between runs; statsdump decodes it                  //
+//   -R recording   write every change at the firmware's inputs there, float pins as the plant and the //
+//                  slosh moved them, pots and scripted resets, as a script that runs without the      //
+//                  plant; the firmware sees the same inputs at the same ticks, so it gives the same   //
+//                  relay timeline (see replay.c)                                                      //
+//   -m ms          wake the simulator at least every ms as well as at its events; slower, and the     //
+//                  relays must not move (replay -m)                                                   //
+//                                                                                                     //
+// The relay timeline goes to stdout as "<ms> <signal> <0|1>", followed by a '#' prefixed summary.     //
+// Built for more than one well (lwcsim-w2 .. lwcsim-w4), the other wells' relays are FILL1, DRAIN1    //
+// and so on, and the summary has a pump and level line for each.                                      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+#include "../lwc.h"
+#include "../debounce.h"
+#include "../relay.h"
+#include "../trace.h"
+
+int lwc_main( void );
+
+//
+// Supply model for the power report.  Currents are the G2553 datasheet typicals at 3 V.  The ISR      //
+//  costs are the mean cycles per call cyclebench measured on the default board's lwc.elf under        //
+//  iss430 over 65 minutes (see cyclebase.txt for the toolchain); a main loop pass after a wake and    //
+//  the old 1 ms tick, which is no longer in the firmware, are still estimates.  ADC10_ISR runs one    //
+//  pass of the pot filter per pot, two shared and one per well; it was measured with one well, and    //
+//  each well more is taken to add a third of it.  The MCU hangs off the 12 V battery through a linear //
+//  regulator, so battery current equals MCU current.                                                  //
+//
+#define I_ACTIVE_UA             330.0           // AM, 1 MHz DCO
+#define I_LPM3_UA               0.9             // LPM3, 32 kHz crystal
+#define WAKE_CYCLES             4000.0          // estimate
+#define OLD_TICK_CYCLES         60.0            // estimate, for the comparison with the two 1 ms ticks
+#define CPU_HZ                  1000000.0
+
+// The ticks the firmware used to take, for comparison: TA0 every 1000 SMCLK and TA1 every 33 ACLK counts
+#define OLD_TICKS_HZ            ( 1000.0 + 32768.0 / 33.0 )
+
+// A pump motor draws several times its running current for about this long from a hard start
+#define INRUSH_MS               150.0
+
+static const double isr_cycles[ SIM_NVEC ] = {
+    0.0,            // Timer0_A0, no handler
+    975.0,          // Timer1_A0, 48-bit clock update and SchedDispatch; 969 on the original board
+    3274.0 / 3.0 * ( 2 + SIM_WELLS ),           // ADC10, 3274 for one well's three pots
+    0.0,            // Port_1, no handler
+    649.0,          // Port_2, float edge and its debounce armed; 853 on the original board
+    42.0            // USCI_A0 TX, one byte from the telemetry ring
+};
+
+static int verbose;
+static int quiet;
+static FILE *uart_out;
+static FILE *rec_out;
+static sim_time_t script_end;                   // "end" directive, 0 for none
+static sim_time_t switched[ SIM_NSIG ];         // relays last switched, 0 for free
+static unsigned long resets_seen;
+static unsigned long unpaced;                   // relay switches inside their RELAY_MIN_* hold
+
+static const sim_plant_t default_plant = {
+    0.0,            // level
+    40000.0,        // capacity
+    450.0,          // fill, 1/2" spray line
+    900.0,          // drain, 3/4" pump out
+    30000.0,        // float
+    500.0           // hysteresis
+};
+
+static int is_relay( int sig ) {
+
+    int w;
+
+    for( w = 0; w < SIM_WELLS; w++ ) {
+        if( sig == SIM_SIG_WFILL( w ) || sig == SIM_SIG_WDRAIN( w ) ) return( 1 );
+    }
+    return( 0 );
+}
+
+// A relay switching sooner than its hold after it last did, other than the fill going off with the float
+// full, with a millisecond's grace for the timebase's ticks.  A reset frees every relay, and the ones it
+// drops are free to switch again at once.
+static void pace_output( sim_time_t t, int sig, int on ) {
+
+    const sim_stats_t *s = sim_stats( );
+    const sim_time_t hold = ( sim_time_t )( on ? RELAY_MIN_OFF_MS : RELAY_MIN_ON_MS ) * SIM_MS;
+    int w;
+
+    if( s->resets != resets_seen ) {
+        resets_seen = s->resets;
+        memset( switched, 0, sizeof( switched ) );
+    }
+    for( w = 0; w < SIM_WELLS; w++ ) {
+        if( sig == SIM_SIG_WFILL( w ) && !on && FloatState[ w ] == INDICATES_FULL ) break;
+    }
+    if( switched[ sig ] && t - switched[ sig ] + SIM_MS < hold && w == SIM_WELLS ) unpaced++;
+    switched[ sig ] = s->resets && t == s->last_reset ? 0 : t;
+}
+
+static void print_output( sim_time_t t, int sig, int on ) {
+
+    if( is_relay( sig ) ) pace_output( t, sig, on );
+    if( quiet ) return;
+    if( !verbose && !is_relay( sig ) ) return;
+
+    printf( "%llu.%03llu %s %d\n", t / SIM_MS, ( t % SIM_MS ) * 1000 / SIM_MS, sim_signal_name( sig ), on );
+}
+
+static void save_uart( sim_time_t t, unsigned char c ) {
+
+    ( void )t;
+    fputc( c, uart_out );
+}
+
+static int pot_channel( const char *name ) {
+
+    if( !strcmp( name, "interval" ) ) return( SIM_POT_INTERVAL );
+    if( !strcmp( name, "duration" ) ) return( SIM_POT_DURATION );
+    if( !strcmp( name, "drain" ) ) return( SIM_POT_DRAIN );
+    return( -1 );
+}
+
+// Exact: a tick is 1/512000 ms, which always ends within 12 decimals
+static const char *ms_text( sim_time_t t, char *buf, size_t len ) {
+
+    char *p;
+
+    snprintf( buf, len, "%llu.%012llu", t / SIM_MS, ( t % SIM_MS ) * ( 1000000000000ULL / SIM_MS ) );
+    for( p = buf + strlen( buf ) - 1; *p == '0'; p-- ) *p = 0;
+    if( *p == '.' ) *p = 0;
+    return( buf );
+}
+
+static void record_input( sim_time_t t, int well, int kind, int ch, unsigned int value ) {
+
+    static const char * const resets[ ] = { "brownout", "power", "pin" };
+    char at[ 32 ];
+    int w;
+
+    // A drain pot is a well's; without the prefix a float or drain line would go to every well
+    for( w = 0; kind == SIM_IN_POT && w < SIM_WELLS && ch != SIM_POT_WELL_DRAIN( w ); w++ );
+    if( kind == SIM_IN_POT && w < SIM_WELLS ) well = w;
+    else if( kind != SIM_IN_FLOAT ) well = -1;
+
+    fprintf( rec_out, "at %s ", ms_text( t, at, sizeof( at ) ) );
+    if( well > 0 || ( well == 0 && SIM_WELLS > 1 ) ) fprintf( rec_out, "well %d ", well );
+    if( kind == SIM_IN_POT ) {
+        fprintf( rec_out, "pot %s %u\n", ch == SIM_POT_INTERVAL ? "interval" : ch == SIM_POT_DURATION ? "duration" :
+                 "drain", value );
+    } else if( kind == SIM_IN_FLOAT ) {
+        fprintf( rec_out, "float %s\n", value ? "full" : "empty" );
+    } else if( kind == SIM_IN_RESET ) {
+        fprintf( rec_out, "reset %s\n", resets[ value % 3 ] );
+    } else {
+        fprintf( rec_out, "hang\n" );
+    }
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Description: Loads a scenario script.  One directive per line, '#' starts a comment:                //
+//                                                                                                     //
+//   [well <n>] plant <level> <capacity> <fill mL/s> <drain mL/s> <float> <hyst>                       //
+//   noplant                                                                                           //
+//   [at <ms>] [well <n>] pot <interval|duration|drain> <counts>                                       //
+//   [at <ms>] [well <n>] float <full|empty>                                                           //
+//   [at <ms>] reset <brownout|power|pin>                                                              //
+//   [at <ms>] hang                      CPU stuck with interrupts off until the watchdog bites        //
+//   [at <ms>] [well <n>] rates <fill> <drain>   plant pump rates from now on, mL/s                    //
+//   [at <ms>] [well <n>] slosh <ms>     float chatters for about that long after each plant edge      //
+//   at <ms> end                         the run's length, unless -t gives one                         //
+//                                                                                                     //
+// Times may have a fraction; the nearest simulator tick is taken, so lwcsim -R recordings are exact.  //
+// "well <n>" picks well 0 to 3 for the plant, the drain pot, the float and the rates; without it they //
+// go to every well.  Directives for a well the build does not have are skipped, so one script runs on //
+// every build.                                                                                        //
+//                                                                                                     //
+// Returns: 0 on success, -1 with a message on stderr otherwise                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static int load_scenario( const char *path ) {
+
+    FILE *f = fopen( path, "r" );
+    char line[ 256 ], *tok, *arg;
+    int n = 0, ch, well, w, lo, hi;
+    unsigned int rate;
+    sim_time_t at;
+    sim_plant_t p;
+
+    if( !f ) {
+        perror( path );
+        return( -1 );
+    }
+
+    while( fgets( line, sizeof( line ), f ) ) {
+        n++;
+        if( ( tok = strchr( line, '#' ) ) ) *tok = 0;
+        if( !( tok = strtok( line, " \t\r\n" ) ) ) continue;
+
+        at = 0;
+        if( !strcmp( tok, "at" ) ) {
+            if( !( arg = strtok( 0, " \t\r\n" ) ) ) goto bad;
+            at = ( sim_time_t )( strtod( arg, 0 ) * SIM_MS + 0.5 );
+            if( !( tok = strtok( 0, " \t\r\n" ) ) ) goto bad;
+        }
+
+        well = -1;
+        if( !strcmp( tok, "well" ) ) {
+            if( !( arg = strtok( 0, " \t\r\n" ) ) || ( well = atoi( arg ) ) < 0 || well > 3 ) goto bad;
+            if( !( tok = strtok( 0, " \t\r\n" ) ) ) goto bad;
+            if( well >= SIM_WELLS ) continue;
+        }
+        lo = well < 0 ? 0 : well;               // wells a directive for one well goes to
+        hi = well < 0 ? SIM_WELLS : well + 1;
+
+        if( !strcmp( tok, "plant" ) ) {
+            if( !( arg = strtok( 0, "" ) ) || sscanf( arg, "%lf %lf %lf %lf %lf %lf", &p.level, &p.capacity,
+                        &p.fill_rate, &p.drain_rate, &p.float_at, &p.hyst ) != 6 ) goto bad;
+            if( well < 0 ) sim_set_plant( &p );
+            else sim_set_well_plant( well, &p );
+        } else if( !strcmp( tok, "noplant" ) ) {
+            sim_set_plant( 0 );
+        } else if( !strcmp( tok, "pot" ) ) {
+            if( !( arg = strtok( 0, " \t\r\n" ) ) || ( ch = pot_channel( arg ) ) < 0 ) goto bad;
+            if( well >= 0 && ch != SIM_POT_DRAIN ) goto bad;
+            if( !( arg = strtok( 0, " \t\r\n" ) ) ) goto bad;
+            if( ch != SIM_POT_DRAIN ) sim_add_input( at, SIM_IN_POT, ch, ( unsigned int )strtoul( arg, 0, 0 ) );
+            for( w = lo; ch == SIM_POT_DRAIN && w < hi; w++ ) {
+                sim_add_input( at, SIM_IN_POT, SIM_POT_WELL_DRAIN( w ), ( unsigned int )strtoul( arg, 0, 0 ) );
+            }
+        } else if( !strcmp( tok, "float" ) ) {
+            if( !( arg = strtok( 0, " \t\r\n" ) ) ) goto bad;
+            for( w = lo; w < hi; w++ ) sim_add_well_input( at, w, SIM_IN_FLOAT, 0, !strcmp( arg, "full" ) );
+        } else if( !strcmp( tok, "reset" ) ) {
+            if( !( arg = strtok( 0, " \t\r\n" ) ) ) goto bad;
+            if( !strcmp( arg, "brownout" ) ) sim_add_input( at, SIM_IN_RESET, 0, SIM_RESET_BROWNOUT );
+            else if( !strcmp( arg, "power" ) ) sim_add_input( at, SIM_IN_RESET, 0, SIM_RESET_POWER );
+            else if( !strcmp( arg, "pin" ) ) sim_add_input( at, SIM_IN_RESET, 0, SIM_RESET_PIN );
+            else goto bad;
+        } else if( !strcmp( tok, "hang" ) ) {
+            sim_add_input( at, SIM_IN_HANG, 0, 0 );
+        } else if( !strcmp( tok, "rates" ) ) {
+            if( !( arg = strtok( 0, "" ) ) || sscanf( arg, "%d %u", &ch, &rate ) != 2 || ch < 0 ) goto bad;
+            for( w = lo; w < hi; w++ ) sim_add_well_input( at, w, SIM_IN_RATES, ch, rate );
+        } else if( !strcmp( tok, "slosh" ) ) {
+            if( !( arg = strtok( 0, " \t\r\n" ) ) ) goto bad;
+            for( w = lo; w < hi; w++ ) sim_add_well_input( at, w, SIM_IN_SLOSH, 0, ( unsigned int )atoi( arg ) );
+        } else if( !strcmp( tok, "end" ) ) {
+            if( !at || well >= 0 ) goto bad;
+            script_end = at;
+        } else {
+            goto bad;
+        }
+    }
+    fclose( f );
+    return( 0 );
+
+bad:
+    fprintf( stderr, "%s:%d: bad directive\n", path, n );
+    fclose( f );
+    return( -1 );
+}
+
+static void print_summary( double hours, double wall ) {
+
+    const sim_stats_t *s = sim_stats( );
+    double run = ( double )s->run_time / SIM_HZ;
+    double active, cycles = 0.0, ua, timer, timer_s;
+    unsigned long data, bss, noinit, fill = 0, drain = 0, hard;
+    int v, w;
+
+    for( v = 0; v < SIM_NVEC; v++ ) cycles += ( double )s->isr[ v ] * isr_cycles[ v ];
+    active = ( double )s->active_time / SIM_HZ + ( cycles + s->sleeps * WAKE_CYCLES ) / CPU_HZ;
+    if( active > run ) active = run;
+    ua = run > 0.0 ? ( active * I_ACTIVE_UA + ( run - active ) * I_LPM3_UA ) / run : 0.0;
+
+    printf( "# simulated      %.3f h in %.3f s wall (%.0fx real time)\n",
+            hours, wall, wall > 0.0 ? hours * 3600.0 / wall : 0.0 );
+    printf( "# main loop      %llu LPM wakes, %llu idle waits, %llu events\n", s->sleeps, s->idles, s->events );
+    printf( "# interrupts     Timer0_A0 %llu, Timer1_A0 %llu, ADC10 %llu, Port_2 %llu\n",
+            s->isr[ SIM_VEC_TIMER0_A0 ], s->isr[ SIM_VEC_TIMER1_A0 ], s->isr[ SIM_VEC_ADC10 ], s->isr[ SIM_VEC_PORT2 ] );
+    if( run > 0.0 ) {
+        timer = ( double )( s->isr[ SIM_VEC_TIMER0_A0 ] + s->isr[ SIM_VEC_TIMER1_A0 ] );
+        timer_s = ( s->isr[ SIM_VEC_TIMER0_A0 ] * isr_cycles[ SIM_VEC_TIMER0_A0 ]
+                  + s->isr[ SIM_VEC_TIMER1_A0 ] * isr_cycles[ SIM_VEC_TIMER1_A0 ] ) / CPU_HZ;
+        printf( "# timer isrs     %.0f an hour, %.3f%% cpu; two 1 ms ticks: %.0f, %.3f%% at %.0f cycles each\n",
+                timer * 3600.0 / run, 100.0 * timer_s / run, OLD_TICKS_HZ * 3600.0,
+                100.0 * OLD_TICKS_HZ * OLD_TICK_CYCLES / CPU_HZ, OLD_TICK_CYCLES );
+    }
+    if( s->flash_words || s->flash_erases ) {
+        printf( "# flash          %lu words programmed, %lu segment erases, %.1f ms held, longest %.2f ms%s\n",
+                s->flash_words, s->flash_erases, ( double )s->flash_busy * 1000.0 / SIM_HZ,
+                ( double )s->flash_longest * 1000.0 / SIM_HZ, s->flash_errors ? ", FLASH ERRORS" : "" );
+    }
+    if( s->uart_bytes ) printf( "# uart           %llu bytes, %llu USCI_A0 TX interrupts\n", s->uart_bytes, s->isr[ SIM_VEC_USCI_TX ] );
+    if( s->resets || s->hangs ) {
+        printf( "# resets         %lu (%lu by the watchdog), %lu hangs, last at %.3f s\n",
+                s->resets, s->watchdog_resets, s->hangs, ( double )s->last_reset / SIM_HZ );
+    }
+    printf( "# cpu            %.3f%% active (%.1f s), %.3f%% in LPM\n",
+            run > 0.0 ? 100.0 * active / run : 0.0, active, run > 0.0 ? 100.0 * ( run - active ) / run : 0.0 );
+    printf( "# mcu supply     %.1f uA average, %.3f mAh/day (always active: %.3f mAh/day, saves %.3f)\n",
+            ua, ua * 24.0 / 1000.0, I_ACTIVE_UA * 24.0 / 1000.0, ( I_ACTIVE_UA - ua ) * 24.0 / 1000.0 );
+    printf( "# fill pump      %lu starts, %.1f s on\n", s->starts[ SIM_SIG_FILL ], ( double )s->on_time[ SIM_SIG_FILL ] / SIM_HZ );
+    printf( "# drain pump     %lu starts, %.1f s on\n", s->starts[ SIM_SIG_DRAIN ], ( double )s->on_time[ SIM_SIG_DRAIN ] / SIM_HZ );
+    if( s->level_max[ 0 ] > 0.0 ) {
+        printf( "# plant level    %.0f to %.0f mL since the float first read full\n", s->level_min[ 0 ], s->level_max[ 0 ] );
+    }
+
+    // Well 0 keeps the lines above as they always were, adaptbench reads them
+    for( w = 1; w < SIM_WELLS; w++ ) {
+        printf( "# well %d pumps   fill %lu starts, %.1f s on, drain %lu starts, %.1f s on\n", w,
+                s->starts[ SIM_SIG_WFILL( w ) ], ( double )s->on_time[ SIM_SIG_WFILL( w ) ] / SIM_HZ,
+                s->starts[ SIM_SIG_WDRAIN( w ) ], ( double )s->on_time[ SIM_SIG_WDRAIN( w ) ] / SIM_HZ );
+        if( s->level_max[ w ] > 0.0 ) {
+            printf( "# well %d level   %.0f to %.0f mL since the float first read full\n", w, s->level_min[ w ],
+                    s->level_max[ w ] );
+        }
+    }
+
+    // The relay stage's asks against the relays the sim saw switch, every well; counts since the last reset
+    for( w = 0; w < SIM_WELLS; w++ ) {
+        fill += s->starts[ SIM_SIG_WFILL( w ) ];
+        drain += s->starts[ SIM_SIG_WDRAIN( w ) ];
+    }
+    hard = fill + drain > RelaySoftStarts ? fill + drain - RelaySoftStarts : 0;
+    printf( "# relay stage    fill %lu starts of %lu asked, drain %lu of %lu, %lu asks coalesced, %lu soft starts\n",
+            fill, RelayAsked[ 0 ], drain, RelayAsked[ 1 ], RelayCoalesced, RelaySoftStarts );
+    printf( "# relay holds    %lu switches inside the %d ms on and %d ms off\n", unpaced, RELAY_MIN_ON_MS,
+            RELAY_MIN_OFF_MS );
+    printf( "# inrush         %.1f s at start current, %.1f s unpaced (%.0f ms a hard start)\n", hard * INRUSH_MS / 1000.0,
+            ( RelayAsked[ 0 ] + RelayAsked[ 1 ] ) * INRUSH_MS / 1000.0, INRUSH_MS );
+
+    sim_fw_ram( &data, &bss, &noinit );
+    printf( "# firmware ram   %d well%s, %lu bytes data, %lu bss, %lu noinit (host build)\n", SIM_WELLS,
+            SIM_WELLS > 1 ? "s" : "", data, bss, noinit );
+}
+
+int main( int argc, char **argv ) {
+
+    const char *scenario = 0, *tracefile = 0, *uartfile = 0, *flashfile = 0, *recfile = 0;
+    FILE *f;
+    double hours = 0.0, step = 0.0;
+    sim_time_t end;
+    struct timespec t0, t1;
+    int k;
+
+    for( k = 1; k < argc; k++ ) {
+        if( !strcmp( argv[ k ], "-f" ) && k + 1 < argc ) scenario = argv[ ++k ];
+        else if( !strcmp( argv[ k ], "-t" ) && k + 1 < argc ) hours = atof( argv[ ++k ] );
+        else if( !strcmp( argv[ k ], "-v" ) ) verbose = 1;
+        else if( !strcmp( argv[ k ], "-q" ) ) quiet = 1;
+        else if( !strcmp( argv[ k ], "-T" ) && k + 1 < argc ) tracefile = argv[ ++k ];
+        else if( !strcmp( argv[ k ], "-U" ) && k + 1 < argc ) uartfile = argv[ ++k ];
+        else if( !strcmp( argv[ k ], "-F" ) && k + 1 < argc ) flashfile = argv[ ++k ];
+        else if( !strcmp( argv[ k ], "-R" ) && k + 1 < argc ) recfile = argv[ ++k ];
+        else if( !strcmp( argv[ k ], "-m" ) && k + 1 < argc ) step = atof( argv[ ++k ] );
+        else {
+            fprintf( stderr, "usage: %s [-f scenario] [-t hours] [-v] [-q] [-T tracefile] [-U uartfile]"
+                     " [-F flashfile] [-R recording] [-m ms]\n",
+                     argv[ 0 ] );
+            return( 2 );
+        }
+    }
+
+    sim_reset( );
+    if( flashfile && ( f = fopen( flashfile, "rb" ) ) ) {
+        if( fread( sim_flash( ), 1, SIM_FLASH_SIZE, f ) != SIM_FLASH_SIZE ) {
+            fprintf( stderr, "%s: short flash image\n", flashfile );
+            return( 1 );
+        }
+        fclose( f );
+    }
+
+    // Before the script, so its inputs at time zero are recorded too
+    if( recfile ) {
+        if( !( rec_out = fopen( recfile, "w" ) ) ) {
+            perror( recfile );
+            return( 1 );
+        }
+        fprintf( rec_out, "#\n# Recorded by lwcsim -R from %s, the firmware's inputs only.\n#\nnoplant\n",
+                 scenario ? scenario : "the default plant" );
+        sim_set_input_hook( record_input );
+    }
+
+    if( scenario ) {
+        if( load_scenario( scenario ) ) return( 1 );
+    } else {
+        sim_set_plant( &default_plant );
+        sim_add_input( 0, SIM_IN_POT, SIM_POT_INTERVAL, 512 );
+        sim_add_input( 0, SIM_IN_POT, SIM_POT_DURATION, 512 );
+        sim_add_input( 0, SIM_IN_POT, SIM_POT_DRAIN, 512 );
+    }
+    sim_set_output_hook( print_output );
+    sim_set_max_step( ( sim_time_t )( step * SIM_MS ) );
+    if( uartfile ) {
+        if( !( uart_out = fopen( uartfile, "wb" ) ) ) {
+            perror( uartfile );
+            return( 1 );
+        }
+        sim_set_uart_hook( save_uart );
+    }
+
+    if( hours > 0.0 ) end = ( sim_time_t )( hours * 3600.0 * SIM_HZ );
+    else end = script_end ? script_end : 12ULL * 3600 * SIM_HZ;
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    sim_run( lwc_main, end );
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+
+    print_summary( ( double )end / ( 3600.0 * SIM_HZ ), ( t1.tv_sec - t0.tv_sec ) + ( t1.tv_nsec - t0.tv_nsec ) * 1e-9 );
+    if( uart_out ) fclose( uart_out );
+    if( rec_out ) {
+        char at[ 32 ];
+
+        fprintf( rec_out, "at %s end\n", ms_text( end, at, sizeof( at ) ) );
+        if( fclose( rec_out ) ) {
+            perror( recfile );
+            return( 1 );
+        }
+    }
+
+    if( flashfile ) {
+        if( !( f = fopen( flashfile, "wb" ) ) || fwrite( sim_flash( ), 1, SIM_FLASH_SIZE, f ) != SIM_FLASH_SIZE ) {
+            perror( flashfile );
+            return( 1 );
+        }
+        fclose( f );
+    }
+    if( tracefile ) {
+#ifdef LWC_NO_TRACE
+        fprintf( stderr, "%s: built without the trace (see wells.h), no %s\n", argv[ 0 ], tracefile );
+        return( 1 );
+#else
+        if( !( f = fopen( tracefile, "wb" ) ) || fwrite( &TraceLog, sizeof( TraceLog ), 1, f ) != 1 ) {
+            perror( tracefile );
+            return( 1 );
+        }
+        fclose( f );
+#endif
+    }
+    return( 0 );
+}
@@ -0,0 +1,472 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                         RAM and Flash Report                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : memreport.c                                                                     //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Lists what every firmware symbol takes, from "nm -f sysv" on the objects or the linked image:       //
+// RAM for .data, .bss and .noinit (fw_data, fw_bss and fw_noinit in the simulator's objects), flash   //
+// for code, constants and the .data initializers.  RAM symbols are listed largest first, then the     //
+// largest code, then the totals.                                                                      //
+//                                                                                                     //
+// With -b it compares the RAM symbols against a baseline written by -w, and fails if the total has    //
+// grown by more than -t bytes; every symbol that changed is shown either way.  -r and -f fail the     //
+// report outright above a RAM or flash size, and -s unless that many bytes of -r are left: on the     //
+// G2553 whatever RAM is left is the stack's, which StackMax (stack.c) measures at run time.           //
+//                                                                                                     //
+// The simulator's objects are host code, where ints, longs and pointers are wider than the G2553's.   //
+// -T sizes their RAM symbols for the G2553 instead, from the objects' debug info (readelf, or         //
+// $READELF): int, enum and pointer 2 bytes, long 4, nothing aligned past a word, and the host's       //
+// int32_t and the like taken at their own width.  That is what the G2553's compiler lays out for the  //
+// same declarations, so the baseline and -r/-s can be in target bytes without the MSP430 toolchain.   //
+// The flash figures stay the host's.  For the real image run it on the ELF with NM=msp430-elf-nm.     //
+//                                                                                                     //
+// Usage: memreport [-T] [-b baseline] [-w baseline] [-t bytes] [-r bytes] [-s bytes] [-f bytes]       //
+//                  object ...                                                                         //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SYMS                1024
+#define TOP_CODE                12              // code symbols listed
+#define MAX_DEPTH               32              // DIE nesting in the debug info
+
+enum { K_CODE, K_CONST, K_DATA, K_BSS, K_NOINIT };
+
+static const char * const kind_names[ ] = { "code", "const", "data", "bss", "noinit" };
+
+typedef struct {
+    char            name[ 64 ];
+    int             kind;
+    unsigned long   size;
+    long            base;                       // baseline size, -1 if not in it
+} sym_t;
+
+static sym_t syms[ MAX_SYMS ];
+static int nsyms;
+
+// -T: the debug info entries of one object, as much of them as sizing a variable for the G2553 needs
+enum { T_OTHER, T_BASE, T_POINTER, T_TYPEDEF, T_QUALIFIER, T_ENUM, T_ARRAY, T_SUBRANGE, T_STRUCT, T_UNION,
+       T_MEMBER, T_VARIABLE };
+
+typedef struct {
+    unsigned long   off, type, spec;            // this entry, DW_AT_type, DW_AT_specification
+    int             tag, parent;                // T_*, index of the enclosing entry or -1
+    long            size, count;                // DW_AT_byte_size, a subrange's elements; -1 if not given
+    int             static_addr;                // a variable at a fixed address, not a local
+    char            name[ 64 ];
+    long            tsize;                      // target size once worked out, -1 before
+    int             talign;
+} die_t;
+
+static die_t *dies;
+static int ndies, dies_max;
+static char dies_obj[ 256 ];                    // object they were read from
+static int target;                              // -T
+
+// Sorts on kind, RAM first, then size, largest first
+static int by_size( const void *a, const void *b ) {
+
+    const sym_t *x = a, *y = b;
+    int rx = x->kind >= K_DATA, ry = y->kind >= K_DATA;
+
+    if( rx != ry ) return( ry - rx );
+    if( x->size != y->size ) return( x->size < y->size ? 1 : -1 );
+    return( strcmp( x->name, y->name ) );
+}
+
+// Section a symbol is in to what it costs; -1 for anything that takes no memory
+static int kind_of( const char *sec ) {
+
+    if( strstr( sec, "noinit" ) ) return( K_NOINIT );
+    if( strstr( sec, "bss" ) || !strcmp( sec, "COMMON" ) ) return( K_BSS );
+    if( strstr( sec, "rodata" ) || strstr( sec, "const" ) || strstr( sec, "rel.ro" ) ) return( K_CONST );
+    if( strstr( sec, "data" ) ) return( K_DATA );
+    if( strstr( sec, "text" ) ) return( K_CODE );
+    return( -1 );
+}
+
+static sym_t *find( const char *name, int ram ) {
+
+    int k;
+
+    for( k = 0; k < nsyms; k++ ) {
+        if( ( syms[ k ].kind >= K_DATA ) == ram && !strcmp( syms[ k ].name, name ) ) return( &syms[ k ] );
+    }
+    return( 0 );
+}
+
+// Trims the blanks nm pads its columns with
+static char *field( char *s ) {
+
+    char *e;
+
+    while( *s == ' ' ) s++;
+    e = s + strlen( s );
+    while( e > s && ( e[ -1 ] == ' ' || e[ -1 ] == '\n' || e[ -1 ] == '\r' ) ) *--e = 0;
+    return( s );
+}
+
+// A DW_TAG_ name to the kinds -T tells apart
+static int tag_of( const char *s ) {
+
+    static const struct { const char *name; int tag; } tags[ ] = {
+        { "base_type", T_BASE }, { "pointer_type", T_POINTER }, { "typedef", T_TYPEDEF },
+        { "const_type", T_QUALIFIER }, { "volatile_type", T_QUALIFIER }, { "enumeration_type", T_ENUM },
+        { "array_type", T_ARRAY }, { "subrange_type", T_SUBRANGE }, { "structure_type", T_STRUCT },
+        { "union_type", T_UNION }, { "member", T_MEMBER }, { "variable", T_VARIABLE }
+    };
+    size_t k;
+
+    for( k = 0; k < sizeof( tags ) / sizeof( tags[ 0 ] ); k++ ) {
+        if( !strncmp( s, tags[ k ].name, strlen( tags[ k ].name ) ) && s[ strlen( tags[ k ].name ) ] == ')' ) {
+            return( tags[ k ].tag );
+        }
+    }
+    return( T_OTHER );
+}
+
+// Reads an object's debug info with readelf --debug-dump=info, unless it is the one already read
+static int load_dies( const char *obj ) {
+
+    const char *readelf = getenv( "READELF" ) ? getenv( "READELF" ) : "readelf";
+    char cmd[ 512 ], line[ 512 ], attr[ 64 ], *v;
+    int stack[ MAX_DEPTH ], level;
+    unsigned long off;
+    FILE *f;
+    die_t *d = 0;
+
+    if( !strcmp( dies_obj, obj ) ) return( 0 );
+    snprintf( dies_obj, sizeof( dies_obj ), "%s", obj );
+    ndies = 0;
+
+    snprintf( cmd, sizeof( cmd ), "%s --debug-dump=info %s", readelf, obj );
+    if( !( f = popen( cmd, "r" ) ) ) {
+        fprintf( stderr, "memreport: cannot run %s\n", readelf );
+        return( -1 );
+    }
+    while( fgets( line, sizeof( line ), f ) ) {
+        if( sscanf( line, " <%d><%lx>:", &level, &off ) == 2 ) {
+            d = 0;
+            if( level < 0 || level >= MAX_DEPTH || !( v = strstr( line, "(DW_TAG_" ) ) ) continue;
+            if( ndies == dies_max ) {
+                dies_max = dies_max ? 2 * dies_max : 1024;
+                if( !( dies = realloc( dies, ( size_t )dies_max * sizeof( dies[ 0 ] ) ) ) ) break;
+            }
+            d = &dies[ ndies ];
+            memset( d, 0, sizeof( *d ) );
+            d->off = off;
+            d->tag = tag_of( v + 8 );
+            d->parent = level ? stack[ level - 1 ] : -1;
+            d->size = d->count = d->tsize = -1;
+            stack[ level ] = ndies++;
+            continue;
+        }
+        if( !d || sscanf( line, " <%*x> DW_AT_%63s", attr ) != 1 || !( v = strstr( line, ": " ) ) ) continue;
+        v = field( v + 2 );
+        attr[ strcspn( attr, ":" ) ] = 0;       // a long name runs into the colon
+
+        if( !strcmp( attr, "name" ) ) {
+            if( strstr( v, "(indirect" ) && strstr( v, "): " ) ) v = strstr( v, "): " ) + 3;
+            snprintf( d->name, sizeof( d->name ), "%s", v );
+        }
+        else if( !strcmp( attr, "type" ) ) d->type = strtoul( v + 1, 0, 16 );
+        else if( !strcmp( attr, "specification" ) ) d->spec = strtoul( v + 1, 0, 16 );
+        else if( !strcmp( attr, "byte_size" ) ) d->size = strtol( v, 0, 0 );
+        else if( !strcmp( attr, "count" ) && *v != '<' ) d->count = strtol( v, 0, 0 );
+        else if( !strcmp( attr, "upper_bound" ) && *v != '<' ) d->count = strtol( v, 0, 0 ) + 1;
+        else if( !strcmp( attr, "location" ) ) d->static_addr = strstr( v, "DW_OP_addr:" ) != 0;
+    }
+    if( pclose( f ) || !ndies ) {
+        fprintf( stderr, "memreport: %s found no debug info in %s\n", readelf, obj );
+        return( -1 );
+    }
+    return( 0 );
+}
+
+static int die_at( unsigned long off ) {
+
+    int k;
+
+    for( k = 0; k < ndies; k++ ) if( dies[ k ].off == off ) return( k );
+    return( -1 );
+}
+
+// A base type's size on the G2553 from its C name: int is 16 bits, long 32, double 64
+static long base_size( const char *name ) {
+
+    if( strstr( name, "char" ) || strstr( name, "_Bool" ) ) return( 1 );
+    if( strstr( name, "long long" ) || strstr( name, "double" ) ) return( 8 );
+    if( strstr( name, "long" ) || strstr( name, "float" ) ) return( 4 );
+    return( 2 );
+}
+
+// Size and alignment of entry k laid out for the G2553: pointers are 16 bits, nothing aligns past a word
+static long die_size( int k ) {
+
+    die_t *d;
+    long size = -1, n, m;
+    int t, j, align = 1;
+    unsigned bits;
+
+    if( k < 0 ) return( -1 );
+    d = &dies[ k ];
+    if( d->tsize >= 0 ) return( d->tsize );
+    t = die_at( d->type );
+
+    switch( d->tag ) {
+    case T_BASE:
+        size = base_size( d->name );
+        align = size > 1 ? 2 : 1;
+        break;
+    case T_POINTER:
+    case T_ENUM:
+        size = align = 2;
+        break;
+    case T_TYPEDEF:
+    case T_QUALIFIER:                           // the host's int32_t is an int, the G2553's a long
+        if( d->tag == T_TYPEDEF && ( sscanf( d->name, "%*[_]int%u_t", &bits ) == 1 ||
+                                     sscanf( d->name, "%*[_]uint%u_t", &bits ) == 1 ||
+                                     sscanf( d->name, "int%u_t", &bits ) == 1 ||
+                                     sscanf( d->name, "uint%u_t", &bits ) == 1 ) ) {
+            size = bits / 8;
+            align = size > 1 ? 2 : 1;
+        }
+        else if( ( size = die_size( t ) ) >= 0 ) align = dies[ t ].talign;
+        break;
+    case T_ARRAY:
+        if( ( size = die_size( t ) ) < 0 ) break;
+        align = dies[ t ].talign;
+        for( j = k + 1; j < ndies && dies[ j ].parent == k; j++ ) {
+            if( dies[ j ].tag == T_SUBRANGE ) size = dies[ j ].count < 0 ? -1 : size * dies[ j ].count;
+        }
+        break;
+    case T_STRUCT:
+    case T_UNION:
+        for( size = 0, j = k + 1; j < ndies && dies[ j ].parent >= k; j++ ) {
+            if( dies[ j ].parent != k || dies[ j ].tag != T_MEMBER ) continue;
+            t = die_at( dies[ j ].type );
+            if( ( n = die_size( t ) ) < 0 ) return( -1 );
+            m = dies[ t ].talign;
+            if( m > align ) align = ( int )m;
+            if( d->tag == T_UNION ) size = n > size ? n : size;
+            else size = ( size + m - 1 ) / m * m + n;
+        }
+        size = ( size + align - 1 ) / align * align;
+        break;
+    }
+
+    d->tsize = size;
+    d->talign = align;
+    return( size );
+}
+
+// A RAM symbol's size on the G2553, -1 if obj has no fixed-address variable of that name
+static long target_size( const char *obj, const char *sym ) {
+
+    char name[ 64 ];
+    const char *own;
+    int k, s;
+
+    if( load_dies( obj ) ) return( -1 );
+    snprintf( name, sizeof( name ), "%s", sym );
+    name[ strcspn( name, "." ) ] = 0;           // a function's static, Name.0
+
+    for( k = 0; k < ndies; k++ ) {
+        if( dies[ k ].tag != T_VARIABLE || !dies[ k ].static_addr ) continue;
+        s = dies[ k ].spec ? die_at( dies[ k ].spec ) : k;
+        own = s < 0 ? "" : dies[ s ].name;
+        if( strcmp( own, name ) ) continue;
+        return( die_size( die_at( dies[ k ].type ? dies[ k ].type : dies[ s ].type ) ) );
+    }
+    return( -1 );
+}
+
+// Runs nm on the objects; statics of one name in several files are added together
+static int load( int n, char **objs ) {
+
+    const char *nm = getenv( "NM" ) ? getenv( "NM" ) : "nm";
+    char cmd[ 4096 ], line[ 512 ], obj[ 256 ] = "", *col[ 7 ], *p;
+    unsigned long size;
+    size_t len;
+    int k, c, kind;
+    long t;
+    FILE *f;
+    sym_t *s;
+
+    len = ( size_t )snprintf( cmd, sizeof( cmd ), "%s -f sysv", nm );
+    for( k = 0; k < n && len < sizeof( cmd ); k++ ) {
+        len += ( size_t )snprintf( cmd + len, sizeof( cmd ) - len, " %s", objs[ k ] );
+    }
+    if( len >= sizeof( cmd ) || !( f = popen( cmd, "r" ) ) ) {
+        fprintf( stderr, "memreport: cannot run %s\n", nm );
+        return( -1 );
+    }
+
+    while( fgets( line, sizeof( line ), f ) ) {
+        if( sscanf( line, "Symbols from %255[^:]:", obj ) == 1 ) continue;
+        for( c = 0, p = line; c < 7 && p; c++ ) {
+            col[ c ] = p;
+            if( ( p = strchr( p, '|' ) ) ) *p++ = 0;
+        }
+        if( c < 7 ) continue;                   // headers and blank lines
+        if( ( kind = kind_of( field( col[ 6 ] ) ) ) < 0 || !*field( col[ 4 ] ) ) continue;
+
+        size = strtoul( col[ 4 ], 0, 16 );
+        if( target && kind >= K_DATA ) {
+            if( ( t = target_size( n > 1 ? obj : objs[ 0 ], field( col[ 0 ] ) ) ) < 0 ) {
+                fprintf( stderr, "memreport: no debug info for %s in %s\n", col[ 0 ], n > 1 ? obj : objs[ 0 ] );
+                pclose( f );
+                return( -1 );
+            }
+            size = ( unsigned long )t;
+        }
+
+        s = find( field( col[ 0 ] ), kind >= K_DATA );
+        if( !s ) {
+            if( nsyms == MAX_SYMS ) break;
+            s = &syms[ nsyms++ ];
+            snprintf( s->name, sizeof( s->name ), "%s", col[ 0 ] );
+            s->kind = kind;
+            s->base = -1;
+        }
+        s->size += size;
+    }
+    if( pclose( f ) || !nsyms ) {
+        fprintf( stderr, "memreport: %s found no symbols\n", nm );
+        return( -1 );
+    }
+    return( 0 );
+}
+
+// Baseline lines are "<symbol> <bytes>", RAM symbols only; returns the total, -1 if unreadable
+static long load_base( const char *path ) {
+
+    char line[ 256 ], name[ 64 ];
+    unsigned long size;
+    long total = 0;
+    FILE *f = fopen( path, "r" );
+    sym_t *s;
+
+    if( !f ) {
+        perror( path );
+        return( -1 );
+    }
+    while( fgets( line, sizeof( line ), f ) ) {
+        if( line[ 0 ] == '#' && ( strstr( line, "G2553" ) != 0 ) != target ) {
+            fprintf( stderr, "memreport: %s is in %s bytes, run %s -T\n", path, target ? "host" : "G2553",
+                     target ? "without" : "with" );
+            fclose( f );
+            return( -1 );
+        }
+        if( line[ 0 ] == '#' || sscanf( line, "%63s %lu", name, &size ) != 2 ) continue;
+        total += ( long )size;
+        if( ( s = find( name, 1 ) ) ) s->base = ( long )size;
+        else printf( "memreport: %-24s %6lu bytes in the baseline, gone\n", name, size );
+    }
+    fclose( f );
+    return( total );
+}
+
+static int save_base( const char *path ) {
+
+    FILE *f = fopen( path, "w" );
+    int k;
+
+    if( !f ) {
+        perror( path );
+        return( -1 );
+    }
+    fprintf( f, "# RAM by symbol, %s; memreport -w rewrites it\n",
+             target ? "sized for the G2553 from the host build of the firmware" : "host build of the firmware" );
+    for( k = 0; k < nsyms; k++ ) {
+        if( syms[ k ].kind >= K_DATA ) fprintf( f, "%s %lu\n", syms[ k ].name, syms[ k ].size );
+    }
+    return( fclose( f ) );
+}
+
+static void usage( const char *me ) {
+
+    fprintf( stderr, "usage: %s [-T] [-b baseline] [-w baseline] [-t bytes] [-r bytes] [-s bytes] [-f bytes] "
+             "object ...\n", me );
+    exit( 2 );
+}
+
+int main( int argc, char **argv ) {
+
+    const char *base = 0, *write = 0;
+    unsigned long by_kind[ 5 ] = { 0, 0, 0, 0, 0 }, ram, flash, ram_max = 0, flash_max = 0, stack = 0;
+    long slack = 0, base_total = -1;
+    int a, k, shown = 0, failures = 0;
+    sym_t *s;
+
+    for( a = 1; a < argc && argv[ a ][ 0 ] == '-'; a++ ) {
+        if( !strcmp( argv[ a ], "-T" ) ) {
+            target = 1;
+            continue;
+        }
+        if( a + 1 >= argc ) usage( argv[ 0 ] );
+        if( !strcmp( argv[ a ], "-b" ) ) base = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-w" ) ) write = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-t" ) ) slack = strtol( argv[ ++a ], 0, 0 );
+        else if( !strcmp( argv[ a ], "-r" ) ) ram_max = strtoul( argv[ ++a ], 0, 0 );
+        else if( !strcmp( argv[ a ], "-s" ) ) stack = strtoul( argv[ ++a ], 0, 0 );
+        else if( !strcmp( argv[ a ], "-f" ) ) flash_max = strtoul( argv[ ++a ], 0, 0 );
+        else usage( argv[ 0 ] );
+    }
+    if( a == argc ) usage( argv[ 0 ] );
+
+    if( load( argc - a, argv + a ) ) return( 1 );
+    qsort( syms, ( size_t )nsyms, sizeof( syms[ 0 ] ), by_size );
+    if( base && ( base_total = load_base( base ) ) < 0 ) return( 1 );
+
+    printf( "memreport: %-24s %-7s %6s %9s%s\n", "symbol", "section", "bytes", base ? "baseline" : "",
+            target ? "  RAM sized for the G2553" : "" );
+    for( k = 0; k < nsyms; k++ ) {
+        s = &syms[ k ];
+        by_kind[ s->kind ] += s->size;
+        if( s->kind < K_DATA && shown++ >= TOP_CODE ) continue;
+
+        printf( "memreport: %-24s %-7s %6lu", s->name, kind_names[ s->kind ], s->size );
+        if( s->kind >= K_DATA && base ) {
+            if( s->base < 0 ) printf( "       new" );
+            else if( ( unsigned long )s->base != s->size ) printf( " %+9ld", ( long )s->size - s->base );
+        }
+        printf( "\n" );
+    }
+
+    ram = by_kind[ K_DATA ] + by_kind[ K_BSS ] + by_kind[ K_NOINIT ];
+    flash = by_kind[ K_CODE ] + by_kind[ K_CONST ] + by_kind[ K_DATA ];
+    printf( "memreport: ram   %6lu bytes: %lu data, %lu bss, %lu noinit\n", ram, by_kind[ K_DATA ],
+            by_kind[ K_BSS ], by_kind[ K_NOINIT ] );
+    printf( "memreport: flash %6lu bytes: %lu code, %lu const, %lu data initializers\n", flash,
+            by_kind[ K_CODE ], by_kind[ K_CONST ], by_kind[ K_DATA ] );
+
+    if( base ) {
+        printf( "memreport: ram   %+6ld bytes over the baseline, %ld allowed\n", ( long )ram - base_total, slack );
+        if( ( long )ram > base_total + slack ) failures++;
+    }
+    if( ram_max ) {
+        printf( "memreport: ram   %6ld bytes free of %lu for the stack, %lu needed\n", ( long )ram_max - ( long )ram,
+                ram_max, stack );
+        if( ram + stack > ram_max ) failures++;
+    }
+    if( flash_max ) {
+        printf( "memreport: flash %6ld bytes free of %lu\n", ( long )flash_max - ( long )flash, flash_max );
+        if( flash > flash_max ) failures++;
+    }
+    if( write && save_base( write ) ) return( 1 );
+
+    printf( "memreport: %s\n", failures ? "FAILED" : "ok" );
+    return( failures ? 1 : 0 );
+}
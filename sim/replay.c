@@ -0,0 +1,178 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                         Input Replay Check                                          //
+//                                                                                                     //
+//                                                                                                     //
+// File              : replay.c                                                                        //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Feeds a recording of the firmware's inputs (lwcsim -R, or tracedump -r from a board's TraceLog)     //
+// through the simulator and diffs the relay timeline against a golden one, so hours of float edges    //
+// and knob moves run as a regression test in well under a second.  -w takes the golden timeline from  //
+// this run instead, after a change that means to move the relays, and says so in its commit.          //
+//                                                                                                     //
+// With -c it checks the recorder instead: the scenario runs with its plant and is recorded, then the  //
+// recording runs without it, and both must give the same timeline to the tick.                        //
+//                                                                                                     //
+// -m runs the replay with the simulator woken every ms as well as at its events.  Its jumps go to the //
+// earliest timer compare or input, so stepping must give the same timeline; a jump that passed a      //
+// firmware deadline would hold a relay until the next input instead.                                  //
+//                                                                                                     //
+// Exits 1 on any difference; the first one is shown with the line it is on.                           //
+//                                                                                                     //
+// Usage: replay [-s sim] [-m ms] [-g golden | -w golden] recording                                    //
+//        replay [-s sim] [-m ms] -c scenario                                                          //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    char            **line;                     // relay changes, "<ms> <signal> <0|1>"
+    int             n, size;
+    double          hours, wall;
+} timeline_t;
+
+static int add_line( timeline_t *t, const char *s ) {
+
+    char **grown;
+
+    if( t->n == t->size ) {
+        t->size = t->size ? 2 * t->size : 1024;
+        if( !( grown = realloc( t->line, ( size_t )t->size * sizeof( *grown ) ) ) ) return( -1 );
+        t->line = grown;
+    }
+    if( !( t->line[ t->n ] = strdup( s ) ) ) return( -1 );
+    t->n++;
+    return( 0 );
+}
+
+// Lines of a golden file or a simulator run; '#' lines are the summary, only the timing is kept
+static int read_lines( FILE *f, timeline_t *t ) {
+
+    char line[ 256 ];
+
+    while( fgets( line, sizeof( line ), f ) ) {
+        line[ strcspn( line, "\r\n" ) ] = 0;
+        if( line[ 0 ] == '#' ) {
+            sscanf( line, "# simulated %lf h in %lf s wall", &t->hours, &t->wall );
+            continue;
+        }
+        if( line[ 0 ] && add_line( t, line ) ) return( -1 );
+    }
+    return( 0 );
+}
+
+static int run( const char *sim, const char *script, const char *record, const char *step, timeline_t *t ) {
+
+    char cmd[ 1024 ];
+    FILE *p;
+
+    memset( t, 0, sizeof( *t ) );
+    snprintf( cmd, sizeof( cmd ), "./%s -f %s%s%s%s%s", sim, script, record ? " -R " : "", record ? record : "",
+              step ? " -m " : "", step ? step : "" );
+    if( !( p = popen( cmd, "r" ) ) || read_lines( p, t ) || pclose( p ) || !t->hours ) {
+        fprintf( stderr, "replay: %s did not run %s\n", sim, script );
+        return( -1 );
+    }
+    return( 0 );
+}
+
+// Prints the first difference and how many lines differ; 0 if none do
+static int compare( const timeline_t *a, const char *an, const timeline_t *b, const char *bn ) {
+
+    int k, first = -1, diffs = 0, n = a->n > b->n ? a->n : b->n;
+
+    for( k = 0; k < n; k++ ) {
+        if( k < a->n && k < b->n && !strcmp( a->line[ k ], b->line[ k ] ) ) continue;
+        if( first < 0 ) first = k;
+        diffs++;
+    }
+    if( !diffs ) return( 0 );
+
+    printf( "replay: %d of %d lines differ, the first at line %d\n", diffs, n, first + 1 );
+    printf( "replay:   %-10s %s\n", an, first < a->n ? a->line[ first ] : "(ends)" );
+    printf( "replay:   %-10s %s\n", bn, first < b->n ? b->line[ first ] : "(ends)" );
+    return( 1 );
+}
+
+static void usage( const char *me ) {
+
+    fprintf( stderr, "usage: %s [-s sim] [-m ms] [-g golden | -w golden] recording\n"
+                     "       %s [-s sim] [-m ms] -c scenario\n", me, me );
+    exit( 2 );
+}
+
+int main( int argc, char **argv ) {
+
+    const char *sim = "lwcsim", *golden = 0, *write = 0, *scenario = 0, *step = 0;
+    char tmp[ ] = "/tmp/replayXXXXXX";
+    timeline_t live, rerun, gold;
+    int a, k, fd, failures = 0;
+    FILE *f;
+
+    for( a = 1; a < argc && argv[ a ][ 0 ] == '-'; a++ ) {
+        if( a + 1 >= argc ) usage( argv[ 0 ] );
+        if( !strcmp( argv[ a ], "-s" ) ) sim = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-g" ) ) golden = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-w" ) ) write = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-c" ) ) scenario = argv[ ++a ];
+        else if( !strcmp( argv[ a ], "-m" ) ) step = argv[ ++a ];
+        else usage( argv[ 0 ] );
+    }
+
+    if( scenario ) {
+        if( a != argc || golden || write ) usage( argv[ 0 ] );
+        if( ( fd = mkstemp( tmp ) ) < 0 ) {
+            perror( tmp );
+            return( 1 );
+        }
+        close( fd );
+        if( run( sim, scenario, tmp, 0, &live ) || run( sim, tmp, 0, step, &rerun ) ) failures++;
+        else {
+            printf( "replay: %s, %.3f h, %d relay changes with the plant\n", scenario, live.hours, live.n );
+            printf( "replay: recorded and replayed in %.3f s, %d relay changes%s%s%s\n", rerun.wall, rerun.n,
+                    step ? ", stepping every " : "", step ? step : "", step ? " ms" : "" );
+            failures += compare( &live, "plant", &rerun, "replayed" );
+        }
+        unlink( tmp );
+        printf( "replay: %s\n", failures ? "FAILED" : "ok" );
+        return( failures ? 1 : 0 );
+    }
+
+    if( a + 1 != argc || ( golden && write ) ) usage( argv[ 0 ] );
+    if( run( sim, argv[ a ], 0, step, &rerun ) ) return( 1 );
+    printf( "replay: %s, %.3f h of inputs in %.3f s (%.0fx real time), %d relay changes\n", argv[ a ], rerun.hours,
+            rerun.wall, rerun.wall > 0.0 ? rerun.hours * 3600.0 / rerun.wall : 0.0, rerun.n );
+
+    if( golden ) {
+        memset( &gold, 0, sizeof( gold ) );
+        if( !( f = fopen( golden, "r" ) ) ) {
+            perror( golden );
+            return( 1 );
+        }
+        if( read_lines( f, &gold ) ) failures++;
+        fclose( f );
+        if( !failures ) failures += compare( &gold, "golden", &rerun, "replayed" );
+    }
+    if( write ) {
+        if( !( f = fopen( write, "w" ) ) ) {
+            perror( write );
+            return( 1 );
+        }
+        fprintf( f, "# relay timeline of %s on %s; replay -w rewrites it\n", argv[ a ], sim );
+        for( k = 0; k < rerun.n; k++ ) fprintf( f, "%s\n", rerun.line[ k ] );
+        if( fclose( f ) ) return( 1 );
+    }
+
+    printf( "replay: %s\n", failures ? "FAILED" : "ok" );
+    return( failures ? 1 : 0 );
+}
@@ -0,0 +1,228 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                         Warm Restart Bench                                          //
+//                                                                                                     //
+//                                                                                                     //
+// File              : resumebench.c                                                                   //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs the whole firmware on the default plant with short knob times, once without faults for the     //
+// reference relay timeline, then once per fault time and kind:                                        //
+//                                                                                                     //
+//   hang       the main loop locks up with interrupts off and the watchdog resets the part            //
+//   brownout   POR with RAM intact                                                                    //
+//   power      POR with RAM lost, the cold start for comparison                                       //
+//                                                                                                     //
+// Each faulted run goes on for WINDOW_S after the fault.  A hang holds the relays until the watchdog  //
+// bites, and a warm restart resumes from a clock up to WDT_KICK_MS old, so what follows may run late, //
+// and the aerate cycle, the float and the pumps chasing each other, keeps such a delay for good and   //
+// lets it wander.  So rather than the relays at each instant the bench compares the switchings: each  //
+// one after the fault must have the same in the reference, in the same order, with a lag within       //
+// MAX_STEP_MS of the one before.  A run is in step from the last switching that has no match.         //
+// Reports per kind how many runs kept the relays as they were across the reset, the time from the     //
+// reset until in step, the switchings without a match, and the worst lag of those matched.            //
+//                                                                                                     //
+// Exits 1 if a hang or a brownout changes the relays across the reset, or leaves a single switching   //
+// without a match.  The power cycles are the cold start for comparison.                               //
+//                                                                                                     //
+// Usage: resumebench [faults]                                                                         //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+int lwc_main( void );
+
+#define FIRST_S                 900.0           // first fault, after the knobs and the float settle
+#define STEP_S                  733.0           // between fault times, prime to the pump cycles
+#define WINDOW_S                600.0           // compared after each fault
+#define MAX_STEP_MS             1500            // a watchdog period and a kick
+#define MAX_EDGES               65536
+
+enum { KIND_HANG, KIND_BROWNOUT, KIND_POWER, KINDS };
+
+static const char * const kind_names[ KINDS ] = { "hang", "brownout", "power" };
+
+static const sim_plant_t plant = { 0.0, 40000.0, 450.0, 900.0, 30000.0, 500.0 };
+
+// Relay timeline: bit 0 fill, bit 1 drain, from t[ k ] until t[ k + 1 ]
+typedef struct {
+    sim_time_t      t[ MAX_EDGES ];
+    unsigned char   bits[ MAX_EDGES ];
+    unsigned int    n;
+} timeline_t;
+
+static timeline_t ref, run;
+static timeline_t *rec;
+
+static void on_output( sim_time_t t, int sig, int on ) {
+
+    unsigned char b, bit;
+
+    if( sig != SIM_SIG_FILL && sig != SIM_SIG_DRAIN ) return;
+
+    bit = sig == SIM_SIG_FILL ? 1 : 2;
+    b = rec->n ? rec->bits[ rec->n - 1 ] : 0;
+    b = on ? b | bit : b & ~bit;
+
+    // Several changes at one instant count as one
+    if( rec->n && rec->t[ rec->n - 1 ] == t ) rec->n--;
+    if( rec->n && rec->bits[ rec->n - 1 ] == b ) return;
+    if( rec->n < MAX_EDGES ) {
+        rec->t[ rec->n ] = t;
+        rec->bits[ rec->n++ ] = b;
+    }
+}
+
+// Relays at time t, and the time of the next change after it
+static unsigned char relays_at( const timeline_t *l, sim_time_t t, sim_time_t *next ) {
+
+    unsigned int lo = 0, hi = l->n;
+
+    while( lo < hi ) {
+        unsigned int mid = ( lo + hi ) / 2;
+        if( l->t[ mid ] <= t ) lo = mid + 1;
+        else hi = mid;
+    }
+    *next = lo < l->n ? l->t[ lo ] : SIM_NEVER;
+    return( lo ? l->bits[ lo - 1 ] : 0 );
+}
+
+static void simulate( timeline_t *l, sim_time_t end, int kind, sim_time_t fault ) {
+
+    rec = l;
+    l->n = 0;
+
+    sim_reset( );
+    memset( sim_flash( ), 0xFF, SIM_FLASH_SIZE );   // same stats log for every run
+    sim_set_plant( &plant );
+    sim_add_input( 0, SIM_IN_POT, SIM_POT_INTERVAL, 200 );
+    sim_add_input( 0, SIM_IN_POT, SIM_POT_DURATION, 300 );
+    sim_add_input( 0, SIM_IN_POT, SIM_POT_DRAIN, 512 );
+    if( kind == KIND_HANG ) sim_add_input( fault, SIM_IN_HANG, 0, 0 );
+    if( kind == KIND_BROWNOUT ) sim_add_input( fault, SIM_IN_RESET, 0, SIM_RESET_BROWNOUT );
+    if( kind == KIND_POWER ) sim_add_input( fault, SIM_IN_RESET, 0, SIM_RESET_POWER );
+    sim_set_output_hook( on_output );
+
+    sim_run( lwc_main, end );
+}
+
+//
+// Matches the switchings of run against ref from `from` to `to`.  Returns those without a match, and  //
+//  sets *last to the latest of them and *lag to the worst lag matched.                                //
+//
+static unsigned int compare( sim_time_t from, sim_time_t to, sim_time_t *last, sim_time_t *lag ) {
+
+    const long long step = ( long long )MAX_STEP_MS * SIM_MS;
+    const sim_time_t max_lag = 4 * step;       // edges this close to `to` may match past it
+    unsigned int i = 0, j = 0, missed = 0;
+    long long d, cur = 0;
+
+    *last = 0;
+    *lag = 0;
+    while( i < run.n && run.t[ i ] < from ) i++;
+    while( j < ref.n && ref.t[ j ] < from ) j++;
+
+    // A switching close to the end may have its match past it, so only earlier ones count
+
+    while( i < run.n && run.t[ i ] < to && j < ref.n && ref.t[ j ] < to ) {
+        d = ( long long )( run.t[ i ] - ref.t[ j ] );
+        if( run.bits[ i ] == ref.bits[ j ] && llabs( d - cur ) <= step ) {
+            cur = d;
+            if( ( sim_time_t )llabs( d ) > *lag ) *lag = llabs( d );
+            i++;
+            j++;
+        } else if( run.t[ i ] < ref.t[ j ] ) {
+            if( run.t[ i ] + max_lag < to ) {
+                missed++;
+                *last = run.t[ i ];
+            }
+            i++;
+        } else {
+            if( ref.t[ j ] + max_lag < to ) {
+                missed++;
+                *last = ref.t[ j ];
+            }
+            j++;
+        }
+    }
+    return( missed );
+}
+
+static int cmp_double( const void *a, const void *b ) {
+
+    double x = *( const double * )a, y = *( const double * )b;
+
+    return( x < y ? -1 : x > y );
+}
+
+int main( int argc, char **argv ) {
+
+    int faults = argc > 1 ? atoi( argv[ 1 ] ) : 12;
+    double *resume_s, *missed;
+    sim_time_t fault, reset, end, last, lag, worst_lag, nf;
+    const sim_stats_t *s;
+    int kind, k, held, failures = 0;
+    unsigned int n;
+
+    if( faults < 1 ) faults = 1;
+    resume_s = malloc( faults * sizeof( double ) );
+    missed = malloc( faults * sizeof( double ) );
+    if( !resume_s || !missed ) return( 1 );
+
+    end = ( sim_time_t )( ( FIRST_S + ( faults - 1 ) * STEP_S + WINDOW_S ) * SIM_HZ );
+    simulate( &ref, end, -1, 0 );
+    printf( "resumebench: %d faults per kind from %.0f s every %.0f s, %u relay changes in the %.1f h reference\n",
+            faults, FIRST_S, STEP_S, ref.n, ( double )end / SIM_HZ / 3600.0 );
+    printf( "  %-9s %5s %5s %19s %19s %9s\n", "", "", "", "in step after reset", "unmatched", "" );
+    printf( "  %-9s %5s %5s %9s %9s %9s %9s %9s\n", "kind", "runs", "held", "median", "worst", "median", "worst",
+            "worst lag" );
+
+    for( kind = 0; kind < KINDS; kind++ ) {
+        held = 0;
+        worst_lag = 0;
+        for( k = 0; k < faults; k++ ) {
+            fault = ( sim_time_t )( ( FIRST_S + k * STEP_S ) * SIM_HZ );
+            end = fault + ( sim_time_t )( WINDOW_S * SIM_HZ );
+            simulate( &run, end, kind, fault );
+            s = sim_stats( );
+            reset = s->resets ? s->last_reset : end;
+
+            // Changes at the reset instant are already folded, so a warm restart shows none
+            if( relays_at( &run, reset, &nf ) == relays_at( &run, reset - 1, &nf ) ) held++;
+            else if( kind != KIND_POWER ) failures++;
+
+            n = compare( fault, end, &last, &lag );
+            missed[ k ] = n;
+            resume_s[ k ] = last > reset ? ( double )( last - reset ) / SIM_HZ : 0.0;
+            if( lag > worst_lag ) worst_lag = lag;
+
+            if( kind != KIND_POWER && n ) {
+                if( ++failures <= 10 ) {
+                    printf( "  %s at %.0f s: %u switchings without a match, the last %.3f s after the reset\n",
+                            kind_names[ kind ], ( double )fault / SIM_HZ, n, resume_s[ k ] );
+                }
+            }
+        }
+
+        qsort( resume_s, faults, sizeof( double ), cmp_double );
+        qsort( missed, faults, sizeof( double ), cmp_double );
+        printf( "  %-9s %5d %5d %8.1fs %8.1fs %9.0f %9.0f %7.0fms\n", kind_names[ kind ], faults, held,
+                resume_s[ faults / 2 ], resume_s[ faults - 1 ], missed[ faults / 2 ], missed[ faults - 1 ],
+                ( double )worst_lag * 1000.0 / SIM_HZ );
+    }
+
+    printf( "resumebench: %s\n", failures ? "FAILED" : "ok" );
+    free( resume_s );
+    free( missed );
+    return( failures ? 1 : 0 );
+}
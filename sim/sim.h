@@ -0,0 +1,155 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                          Simulator Core API                                         //
+//                                                                                                     //
+//                                                                                                     //
+// File              : sim.h                                                                           //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// The simulator is a discrete-event model of the board: the two Timer_A blocks, the ADC10 with its    //
+// DTC, the USCI_A0 UART transmitter, the flash controller with information memory, port pins, the     //
+// relays and an optional live well plant for each well (water level and float).  Simulated time only  //
+// moves when the firmware waits (HAL_IDLE or an LPM entry) or the flash controller holds the CPU, and //
+// then it jumps straight to the next event instead of stepping through the idle clocks.  The next     //
+// event is the earliest of every timer compare (the firmware's own deadlines), the peripherals, the   //
+// plant and the next scripted input, so a jump never passes a deadline; sim_set_max_step makes it     //
+// step as well, and replay -m checks the two give the same relays.                                    //
+//                                                                                                     //
+// The firmware's own instructions take no simulated time, so active_time only covers waits with the   //
+// CPU running and flash operations.  lwcsim adds an estimated cycle cost per interrupt and per wake   //
+// when it reports power.                                                                              //
+//                                                                                                     //
+// Time is kept in ticks of 512 MHz, the smallest rate both SMCLK (1 MHz) and ACLK (32.768 kHz)        //
+// divide evenly, so neither clock accumulates rounding error.                                         //
+//                                                                                                     //
+// A watchdog expiry or a scripted reset restarts the firmware from its entry point with the           //
+// peripherals at their PUC values and RAM as the C startup leaves it, except no-init RAM (HAL_NOINIT) //
+// which keeps its contents unless the power was cut.  Time, the plant and the inputs carry on.        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef SIM_H
+#define SIM_H
+
+#include "wells.h"
+
+typedef unsigned long long sim_time_t;
+
+#define SIM_HZ                  512000000ULL
+#define SIM_MS                  ( SIM_HZ / 1000 )
+#define SIM_SMCLK_TICKS         512             // 1 MHz DCO
+#define SIM_ACLK_TICKS          15625           // 32.768 kHz crystal
+#define SIM_NEVER               ( ~( sim_time_t )0 )
+#define SIM_FLASH_SIZE          256             // information memory, segments D C B A
+#define SIM_WELLS               LWC_WELLS       // wells on the board, as the firmware is built
+
+// Potentiometer ADC channels
+#define SIM_POT_INTERVAL        1               // A1, P1.1
+#ifdef LWC_TELEMETRY
+#define SIM_POT_DURATION        4               // A4, P1.4, P1.2 is UCA0TXD
+#else
+#define SIM_POT_DURATION        2               // A2, P1.2
+#endif
+#define SIM_POT_DRAIN           3               // A3, P1.3
+#define SIM_POT_WELL_DRAIN( w ) ( ( w ) ? 4 + ( w ) : SIM_POT_DRAIN )     // wells 1-3: A5, A6, A7
+
+// Scripted inputs; the float and the rates are the well's given to sim_add_well_input, well 0's otherwise
+#define SIM_IN_FLOAT            0               // value: 1 = full, 0 = empty
+#define SIM_IN_POT              1               // ch: ADC channel, value: counts
+#define SIM_IN_RESET            2               // value: SIM_RESET_*
+#define SIM_IN_HANG             3               // the CPU spins with interrupts off until a reset
+#define SIM_IN_RATES            4               // ch: fill pump mL/s, value: drain pump mL/s
+#define SIM_IN_SLOSH            5               // value: ms the float chatters after each plant edge, 0 none
+
+#define SIM_RESET_BROWNOUT      0               // supply dip: POR, but RAM holds
+#define SIM_RESET_POWER         1               // power cycled: POR, RAM lost
+#define SIM_RESET_PIN           2               // RST/NMI pulled low: PUC with RSTIFG
+
+// Observed outputs; FILL and DRAIN are well 0's relays, the other wells' come last
+enum {
+    SIM_SIG_FILL,
+    SIM_SIG_DRAIN,
+    SIM_SIG_FLOAT_LED,
+    SIM_SIG_STATUS_LED,
+    SIM_SIG_FILL_LED,
+    SIM_SIG_DRAIN_LED,
+    SIM_SIG_FILL1,
+    SIM_SIG_DRAIN1,
+    SIM_SIG_FILL2,
+    SIM_SIG_DRAIN2,
+    SIM_SIG_FILL3,
+    SIM_SIG_DRAIN3,
+    SIM_NSIG
+};
+
+#define SIM_SIG_WFILL( w )      ( ( w ) ? SIM_SIG_FILL1 + 2 * ( ( w ) - 1 ) : SIM_SIG_FILL )
+#define SIM_SIG_WDRAIN( w )     ( ( w ) ? SIM_SIG_DRAIN1 + 2 * ( ( w ) - 1 ) : SIM_SIG_DRAIN )
+
+// Interrupt vectors the simulator knows how to raise
+enum {
+    SIM_VEC_TIMER0_A0,
+    SIM_VEC_TIMER1_A0,
+    SIM_VEC_ADC10,
+    SIM_VEC_PORT1,
+    SIM_VEC_PORT2,
+    SIM_VEC_USCI_TX,
+    SIM_NVEC
+};
+
+typedef struct {
+    double          level;          // mL in the well at start
+    double          capacity;       // mL at which the well overflows
+    double          fill_rate;      // mL/s while the spray fill pump runs
+    double          drain_rate;     // mL/s while the drain pump runs
+    double          float_at;       // level at which the float reads full
+    double          hyst;           // float reads empty again below float_at - hyst
+} sim_plant_t;
+
+typedef struct {
+    unsigned long long  isr[ SIM_NVEC ];    // ISR entries per vector
+    unsigned long long  sleeps;             // LPM entries
+    unsigned long long  idles;              // busy-wait iterations (HAL_IDLE)
+    unsigned long long  events;             // simulator events processed
+    sim_time_t          run_time;           // simulated time covered by the run
+    sim_time_t          active_time;        // CPU on: busy-waits and free-running loops
+    sim_time_t          sleep_time;         // CPU off in a low power mode
+    sim_time_t          on_time[ SIM_NSIG ];
+    unsigned long       starts[ SIM_NSIG ];
+    unsigned long long  uart_bytes;         // characters shifted out of UCA0TXD
+    unsigned long       flash_words;        // words programmed
+    unsigned long       flash_erases;       // segments erased
+    unsigned long       flash_errors;       // locked, wrong key, bad clock or programmed twice
+    sim_time_t          flash_busy;         // CPU held by the flash controller
+    sim_time_t          flash_longest;      // longest single flash operation
+    unsigned long       resets;             // every reset after the first power up
+    unsigned long       watchdog_resets;    // of those, the watchdog's
+    unsigned long       hangs;              // SIM_IN_HANG inputs applied
+    sim_time_t          last_reset;         // time of the latest reset
+    double              level_min[ SIM_WELLS ];     // plant level in mL since the well's float first
+    double              level_max[ SIM_WELLS ];     //  read full, both 0 until then
+} sim_stats_t;
+
+void sim_reset( void );
+void sim_set_plant( const sim_plant_t *plant );     // every well alike
+void sim_set_well_plant( int well, const sim_plant_t *plant );
+void sim_add_input( sim_time_t at, int kind, int ch, unsigned int value );
+void sim_add_well_input( sim_time_t at, int well, int kind, int ch, unsigned int value );
+void sim_set_output_hook( void ( *hook )( sim_time_t t, int sig, int on ) );
+void sim_set_uart_hook( void ( *hook )( sim_time_t t, unsigned char c ) );
+void sim_set_input_hook( void ( *hook )( sim_time_t t, int well, int kind, int ch, unsigned int value ) );
+void sim_set_flash_hook( int ( *hook )( unsigned int addr, int erase ) );
+void sim_set_max_step( sim_time_t step );      // 0, the default, to jump
+unsigned char *sim_flash( void );          // SIM_FLASH_SIZE bytes of information memory from 0x1000
+int sim_run( int ( *entry )( void ), sim_time_t end );
+
+sim_time_t sim_now( void );
+const sim_stats_t *sim_stats( void );
+const char *sim_signal_name( int sig );
+void sim_fw_ram( unsigned long *data, unsigned long *bss, unsigned long *noinit );
+
+#endif
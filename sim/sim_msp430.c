@@ -0,0 +1,1182 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                  MSP430G2553 Peripheral Models                                      //
+//                                                                                                     //
+//                                                                                                     //
+// File              : sim_msp430.c                                                                    //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_msp430.h"
+#include "sim.h"
+
+#define SIM_MAX_INPUTS          65536           // hours of recorded float edges, see lwcsim -R
+
+#define SIM_INFO_BASE           0x1000          // information memory, segments D C B A
+#define SIM_INFO_SIZE           SIM_FLASH_SIZE
+#define SIM_INFO_SEG            64
+#define SIM_FLASH_WORD_TFTG     30              // program time of one word, flash timing generator clocks
+#define SIM_FLASH_ERASE_TFTG    4819            // segment erase
+#define SIM_ADC_CONV_TICKS      7885            // 64 + 13 ADC10OSC (~5 MHz) clocks per channel
+
+#define SR_LPM_BITS             ( CPUOFF | OSCOFF | SCG0 | SCG1 )
+
+#define SIM_JMP_END             1               // run_env: the run is over
+#define SIM_JMP_RESET           2               // run_env: restart the firmware
+
+// Board pins by well, as lwc.h maps them: relays active low, floats on port 2
+#if SIM_WELLS == 1
+#define SIM_RELAY_OUT           SIM_P2OUT
+#define SIM_RELAY_DIR           SIM_P2DIR
+#else
+#define SIM_RELAY_OUT           SIM_P3OUT
+#define SIM_RELAY_DIR           SIM_P3DIR
+#endif
+#define SIM_FILL_BIT( w )       ( BIT0 << 2 * ( w ) )
+#define SIM_DRAIN_BIT( w )      ( BIT1 << 2 * ( w ) )
+#define SIM_FLOAT_BIT( w )      ( ( w ) ? BIT0 << ( ( w ) - 1 ) : BIT4 )
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Firmware Interrupt Service Routines (weak, so a firmware build may omit any of them)                //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void Timer0_A0( void ) __attribute__(( weak ));
+void Timer1_A0( void ) __attribute__(( weak ));
+void ADC10_ISR( void ) __attribute__(( weak ));
+void Port_1( void ) __attribute__(( weak ));
+void Port_2( void ) __attribute__(( weak ));
+void USCI0TX_ISR( void ) __attribute__(( weak ));
+
+//
+// The firmware objects' .data and .bss are renamed fw_data and fw_bss (see Makefile) and HAL_NOINIT
+//  puts variables in fw_noinit, so the linker brackets each with __start_ and __stop_ symbols.  Weak,
+//  so a harness linked without firmware objects still links.
+//
+extern char __start_fw_data[] __attribute__(( weak )), __stop_fw_data[] __attribute__(( weak ));
+extern char __start_fw_bss[] __attribute__(( weak )), __stop_fw_bss[] __attribute__(( weak ));
+extern char __start_fw_noinit[] __attribute__(( weak )), __stop_fw_noinit[] __attribute__(( weak ));
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Simulator State                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+typedef struct {
+    int                 base;           // first register of the block
+    int                 vec;            // CCR0 vector
+    uint16_t            ctl;            // CTL as last configured
+    sim_time_t          period;         // sim ticks per count, 0 when stopped
+    sim_time_t          time_base;      // sim time of the last rebase
+    unsigned long long  count_base;     // unwrapped count at time_base
+    unsigned long long  matched;        // unwrapped count of the last CCR0 match
+    uint16_t            cctl0;          // CCTL0 and CCR0 that 'next' was computed for
+    uint16_t            ccr0;
+    sim_time_t          next;           // cached CCR0 event, SIM_NEVER when unknown
+} sim_timer_t;
+
+typedef struct {
+    sim_time_t          at;
+    int                 well;
+    int                 kind;
+    int                 ch;
+    unsigned int        value;
+} sim_input_t;
+
+typedef struct {
+    sim_plant_t         p;
+    sim_time_t          time;           // level brought up to date at
+    double              rate;           // mL per sim tick
+    sim_time_t          edge;           // next float edge, SIM_NEVER for none
+    int                 topped;         // the float has read full, level_min/max are kept
+    int                 full;           // the float as the level has it; the pin differs while it sloshes
+    sim_time_t          slosh;          // SIM_IN_SLOSH: chatter after each edge, 0 for none
+    sim_time_t          chatter_at;     // next chatter toggle, SIM_NEVER for none
+    int                 chatter;        // toggles left, an even number so the pin ends up at full
+} sim_well_t;
+
+enum { SRC_NONE, SRC_TIMER0, SRC_TIMER1, SRC_ADC, SRC_PORT1, SRC_PORT2, SRC_UART, SRC_UART_TX, SRC_INPUT,
+       SRC_PLANT, SRC_SLOSH, SRC_WDT, SRC_STEP };
+
+static uint8_t          reg8[ SIM_NREG8 ];
+static uint16_t         reg16[ SIM_NREG16 ];
+static sim_addr_t       adc10sa;
+
+static sim_time_t       now;
+static sim_time_t       end_time;
+static sim_time_t       max_step;       // sim_set_max_step, 0 to jump
+static sim_time_t       next_step;
+static jmp_buf          run_env;
+
+static unsigned int     sr;
+static unsigned int     *isr_sr;        // stacked SR of the ISR in progress
+
+static uint8_t          pin_in[ 4 ];    // externally driven pin levels, P1..P3
+static unsigned int     analog[ 8 ];    // ADC counts per channel
+
+static sim_timer_t      timer[ 2 ];
+
+static int              adc_busy;
+static sim_time_t       adc_done;
+static unsigned int     dtc_block;      // block the DTC is filling, 0 or 1
+static unsigned int     dtc_pos;        // transfers into that block
+static int              dtc_stopped;    // last block filled without ADC10CT
+
+static int              uart_written;   // UCA0TXBUF accessed since the last sync
+static int              uart_full;      // UCA0TXBUF holds a character
+static int              uart_busy;      // the shift register is sending uart_shift
+static uint8_t          uart_shift;
+static sim_time_t       uart_done;
+static void             ( *uart_hook )( sim_time_t t, unsigned char c );
+
+static int              wdt_on;         // WDTCTL has been written with WDTHOLD clear
+static uint16_t         wdt_ctl;        // low byte of WDTCTL as configured
+static uint16_t         wdt_seen;       // WDTCTL as it reads back after the last write
+static sim_time_t       wdt_count;      // sim ticks counted up to wdt_mark
+static sim_time_t       wdt_mark;
+static int              hung;           // SIM_IN_HANG: the CPU is stuck until a reset
+
+static unsigned char    *fw_image;      // fw_data and fw_bss as the C startup leaves them
+
+static uint8_t          info[ SIM_INFO_SIZE ];  // survives sim_reset, like the part's flash
+static int              info_ready;
+static int              ( *flash_hook )( unsigned int addr, int erase );
+
+unsigned int            sim_stack[ SIM_STACK_WORDS ];   // HAL_STACK_LOW, painted by the firmware
+
+static sim_input_t      inputs[ SIM_MAX_INPUTS ];
+static int              n_inputs;
+static int              next_input;
+
+static int              plant_on;
+static sim_well_t       plant[ SIM_WELLS ];
+static int              plant_next;     // well of the earliest float edge, as sim_next found it
+static unsigned long    slosh_seed;     // its own generator, so a sloshing run leaves rand( ) alone
+static void             ( *input_hook )( sim_time_t t, int well, int kind, int ch, unsigned int value );
+
+static int              outputs[ SIM_NSIG ];
+static sim_time_t       output_since[ SIM_NSIG ];
+static void             ( *output_hook )( sim_time_t t, int sig, int on );
+static uint8_t          out_shadow[ 6 ];    // P1OUT, P1DIR, P2OUT, P2DIR, P3OUT, P3DIR at the last scan
+
+static sim_stats_t      stats;
+
+static const char * const signal_names[ SIM_NSIG ] = {
+    "FILL", "DRAIN", "FLOAT_LED", "STATUS_LED", "FILL_LED", "DRAIN_LED",
+    "FILL1", "DRAIN1", "FILL2", "DRAIN2", "FILL3", "DRAIN3"
+};
+
+static void sim_sync( void );
+static sim_time_t sim_next( int *src );
+static void sim_step( void );
+static void cpu_reset( uint8_t ifg1, int por, int ram_lost );
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Interrupt Dispatch                                                                                  //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Like the CPU, entry clears GIE and the LPM bits and RETI restores the       //
+// stacked SR, which __bic_SR_register_on_exit may have edited.  ISRs only run at simulator events,    //
+// so the firmware's own code is never pre-empted between two instructions.                            //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static void sim_isr( int vec, void ( *isr )( void ) ) {
+
+    unsigned int stacked = sr;
+    unsigned int *outer = isr_sr;
+
+    stats.isr[ vec ]++;
+    if( !isr ) return;
+
+    isr_sr = &stacked;
+    sr &= ~( GIE | SR_LPM_BITS );
+    isr( );
+    sr = stacked;
+    isr_sr = outer;
+    sim_sync( );
+}
+
+void sim_eint( void ) { sr |= GIE; }
+void sim_dint( void ) { sr &= ~GIE; }
+unsigned int sim_get_sr( void ) { return( sr ); }
+
+void sim_bic_sr_on_exit( unsigned int bits ) {
+
+    if( isr_sr ) *isr_sr &= ~bits;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Timer_A                                                                                             //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Continuous mode only.  The count is derived from the sim clock rather than  //
+// stepped, so a timer costs nothing between compare events.                                           //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static unsigned long long timer_count( const sim_timer_t *t ) {
+
+    if( !t->period ) return( t->count_base );
+    return( t->count_base + ( now - t->time_base ) / t->period );
+}
+
+static void timer_configure( sim_timer_t *t ) {
+
+    uint16_t ctl = reg16[ t->base + SIM_TA_CTL ];
+    sim_time_t period = 0;
+
+    if( ctl & TACLR ) {
+        reg16[ t->base + SIM_TA_CTL ] = ctl &= ~TACLR;
+        t->count_base = 0;
+        t->time_base = now;
+        t->matched = ~0ULL;
+        t->ctl = ctl;
+        t->next = SIM_NEVER;
+    }
+    if( ctl == t->ctl && t->period ) return;
+
+    if( ctl & ( MC_1 | MC_2 ) ) {
+        if( ( ctl & ( TASSEL_1 | TASSEL_2 ) ) == TASSEL_1 ) period = SIM_ACLK_TICKS;
+        else if( ( ctl & ( TASSEL_1 | TASSEL_2 ) ) == TASSEL_2 ) period = SIM_SMCLK_TICKS;
+        period <<= ( ctl & ID_3 ) >> 6;
+    }
+    t->count_base = timer_count( t );
+    t->time_base = now;
+    t->period = period;
+    t->ctl = ctl;
+    t->next = SIM_NEVER;
+}
+
+static sim_time_t timer_next( sim_timer_t *t ) {
+
+    uint16_t cctl0 = reg16[ t->base + SIM_TA_CCTL0 ];
+    uint16_t ccr0 = reg16[ t->base + SIM_TA_CCR0 ];
+    unsigned long long count, delta;
+
+    if( !( cctl0 & CCIE ) ) return( SIM_NEVER );
+    if( cctl0 & CCIFG ) return( ( sr & GIE ) ? now : SIM_NEVER );       // pending
+    if( !t->period ) return( SIM_NEVER );
+    if( t->next != SIM_NEVER && cctl0 == t->cctl0 && ccr0 == t->ccr0 ) return( t->next );
+
+    count = timer_count( t );
+    delta = ( ccr0 - count ) & 0xFFFF;
+    if( !delta ) {
+        if( count != t->matched ) return( now );
+        delta = 0x10000;
+    }
+    t->cctl0 = cctl0;
+    t->ccr0 = ccr0;
+    t->next = t->time_base + ( count + delta - t->count_base ) * t->period;
+    return( t->next );
+}
+
+static void timer_fire( sim_timer_t *t, void ( *isr )( void ) ) {
+
+    t->next = SIM_NEVER;
+    if( !( reg16[ t->base + SIM_TA_CCTL0 ] & CCIFG ) ) {
+        t->matched = timer_count( t );
+        reg16[ t->base + SIM_TA_CCTL0 ] |= CCIFG;
+    }
+    if( sr & GIE ) {
+        reg16[ t->base + SIM_TA_CCTL0 ] &= ~CCIFG;
+        sim_isr( t->vec, isr );
+    }
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// ADC10 and Data Transfer Controller                                                                  //
+//                                                                                                     //
+// Notes/Warnings/Caveats: A sequence converts INCH down to A0 and the DTC stores the results as       //
+// native unsigned ints at ADC10SA, ADC10DTC1 per block.  With ADC10TB it alternates between two       //
+// blocks and ADC10B1 tells which one just filled; without ADC10CT it stops after the last block       //
+// until ADC10SA is written again.  ADC10IFG is raised per block when the DTC is in use and per        //
+// sequence otherwise.  The firmware never reads ADC10SA, so any access to it restarts the DTC.        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static unsigned int adc_channels( void ) {
+
+    if( ( reg16[ SIM_ADC10CTL1 ] & CONSEQ_3 ) == CONSEQ_0 ) return( 1 );
+    if( ( reg16[ SIM_ADC10CTL1 ] & CONSEQ_3 ) == CONSEQ_2 ) return( 1 );
+    return( ( reg16[ SIM_ADC10CTL1 ] >> 12 ) + 1 );
+}
+
+static void adc_start( void ) {
+
+    reg16[ SIM_ADC10CTL0 ] &= ~ADC10SC;
+    reg16[ SIM_ADC10CTL1 ] |= ADC10BUSY;
+    adc_busy = 1;
+    adc_done = now + adc_channels( ) * SIM_ADC_CONV_TICKS;
+}
+
+static void dtc_transfer( unsigned int value ) {
+
+    unsigned int n = reg8[ SIM_ADC10DTC1 ];
+
+    ( ( unsigned int * )adc10sa )[ dtc_block * n + dtc_pos ] = value;
+    if( ++dtc_pos < n ) return;
+
+    // Block full
+    dtc_pos = 0;
+    reg16[ SIM_ADC10CTL0 ] |= ADC10IFG;
+    if( !( reg8[ SIM_ADC10DTC0 ] & ADC10TB ) ) {
+        if( !( reg8[ SIM_ADC10DTC0 ] & ADC10CT ) ) dtc_stopped = 1;
+        return;
+    }
+    if( dtc_block == 0 ) reg8[ SIM_ADC10DTC0 ] |= ADC10B1;
+    else reg8[ SIM_ADC10DTC0 ] &= ~ADC10B1;
+    dtc_block ^= 1;
+    if( dtc_block == 0 && !( reg8[ SIM_ADC10DTC0 ] & ADC10CT ) ) dtc_stopped = 1;
+}
+
+static void adc_complete( void ) {
+
+    unsigned int n = adc_channels( );
+    unsigned int ch = reg16[ SIM_ADC10CTL1 ] >> 12;
+    unsigned int k;
+
+    if( !adc_busy ) goto pending;
+
+    for( k = 0; k < n; k++, ch-- ) {
+        reg16[ SIM_ADC10MEM ] = analog[ ch ];
+        if( reg8[ SIM_ADC10DTC1 ] && adc10sa && !dtc_stopped ) dtc_transfer( analog[ ch ] );
+    }
+
+    adc_busy = 0;
+    reg16[ SIM_ADC10CTL1 ] &= ~ADC10BUSY;
+    if( !reg8[ SIM_ADC10DTC1 ] ) reg16[ SIM_ADC10CTL0 ] |= ADC10IFG;
+
+pending:
+    if( ( reg16[ SIM_ADC10CTL0 ] & ADC10IE ) && ( sr & GIE ) ) {
+        reg16[ SIM_ADC10CTL0 ] &= ~ADC10IFG;
+        sim_isr( SIM_VEC_ADC10, ADC10_ISR );
+    }
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// USCI_A0 UART Transmitter                                                                            //
+//                                                                                                     //
+// Notes/Warnings/Caveats: UCA0TXBUF feeds a shift register that takes one character time per byte,    //
+// from UCA0BRx and UCBRSx on the selected clock (UCOS16 is not modelled).  UCA0TXIFG is set while     //
+// the buffer is free, so with UCA0TXIE the TX vector keeps firing until the ISR writes a byte or      //
+// clears the enable, as on the part.  The firmware never reads UCA0TXBUF, so any access is a write.   //
+// UCSWRST holds the transmitter idle with UCA0TXIFG set.  Sent bytes go to the uart hook.             //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static sim_time_t uart_char_time( void ) {
+
+    unsigned int br = reg8[ SIM_UCA0BR0 ] | ( reg8[ SIM_UCA0BR1 ] << 8 );
+    unsigned int brs = ( reg8[ SIM_UCA0MCTL ] >> 1 ) & 7;
+    unsigned int ctl0 = reg8[ SIM_UCA0CTL0 ];
+    unsigned int bits;
+    sim_time_t clk = ( reg8[ SIM_UCA0CTL1 ] & UCSSEL_2 ) ? SIM_SMCLK_TICKS : SIM_ACLK_TICKS;
+
+    // Start, 7 or 8 data (UC7BIT), parity (UCPEN), 1 or 2 stop (UCSPB)
+    bits = 1 + ( ( ctl0 & 0x10 ) ? 7 : 8 ) + ( ( ctl0 & 0x80 ) ? 1 : 0 ) + ( ( ctl0 & 0x08 ) ? 2 : 1 );
+    if( !br ) br = 1;
+    return( bits * ( ( sim_time_t )br * 8 + brs ) * clk / 8 );
+}
+
+static void uart_sync( void ) {
+
+    if( reg8[ SIM_UCA0CTL1 ] & UCSWRST ) {
+        uart_written = uart_full = uart_busy = 0;
+        reg8[ SIM_IFG2 ] |= UCA0TXIFG;
+        return;
+    }
+
+    if( uart_written ) {
+        uart_written = 0;
+        uart_full = 1;
+        reg8[ SIM_IFG2 ] &= ~UCA0TXIFG;
+    }
+
+    if( uart_full && !uart_busy ) {
+        uart_shift = reg8[ SIM_UCA0TXBUF ];
+        uart_full = 0;
+        uart_busy = 1;
+        uart_done = now + uart_char_time( );
+        reg8[ SIM_IFG2 ] |= UCA0TXIFG;
+    }
+}
+
+static void uart_complete( void ) {
+
+    uart_busy = 0;
+    stats.uart_bytes++;
+    if( uart_hook ) uart_hook( now, uart_shift );
+}
+
+static int uart_pending( void ) {
+
+    return( ( sr & GIE ) && ( reg8[ SIM_IE2 ] & UCA0TXIE ) && ( reg8[ SIM_IFG2 ] & UCA0TXIFG ) );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Flash Controller and Information Memory                                                             //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Only information memory is modelled, and only word programming and segment  //
+// erase.  The firmware reads it through sim_info and programs it through sim_flash_word (HAL_INFO and //
+// HAL_FLASH_WORD), which checks FCTL as the part would: a locked controller, a missing FWKEY, segment //
+// A or a word programmed twice without an erase are counted in flash_errors and, except the last, do  //
+// nothing.  The CPU is held for the program or erase time on the flash timing generator clock; the    //
+// peripherals carry on, and interrupts wait since the firmware has them off.  A flash hook may cut    //
+// the power during any operation: the cells it was changing are left half done and sim_run returns.   //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static sim_time_t flash_tftg( void ) {
+
+    unsigned int fctl2 = reg16[ SIM_FCTL2 ];
+    sim_time_t clk = ( fctl2 & 0x00C0 ) == FSSEL_0 ? SIM_ACLK_TICKS : SIM_SMCLK_TICKS;
+    sim_time_t t = clk * ( ( fctl2 & 0x3F ) + 1 );
+
+    if( SIM_HZ / t < 257000 || SIM_HZ / t > 476000 ) stats.flash_errors++;
+    return( t );
+}
+
+static void flash_stall( sim_time_t t ) {
+
+    sim_time_t until = now + t;
+    int src;
+
+    stats.flash_busy += t;
+    if( t > stats.flash_longest ) stats.flash_longest = t;
+
+    while( sim_next( &src ) <= until && src != SRC_NONE ) sim_step( );
+    stats.active_time += until - now;
+    now = until;
+    sim_sync( );
+}
+
+const uint8_t *sim_info( sim_addr_t addr ) {
+
+    if( addr < SIM_INFO_BASE || addr >= SIM_INFO_BASE + SIM_INFO_SIZE ) {
+        fprintf( stderr, "sim: information memory read at 0x%04lx\n", ( unsigned long )addr );
+        exit( 1 );
+    }
+    return( &info[ addr - SIM_INFO_BASE ] );
+}
+
+void sim_flash_word( sim_addr_t addr, unsigned int w ) {
+
+    unsigned int fctl1 = reg16[ SIM_FCTL1 ], k, off = ( unsigned int )( addr - SIM_INFO_BASE );
+    int erase = ( fctl1 & ERASE ) != 0, cut;
+    uint8_t *seg;
+
+    sim_info( addr );
+    if( ( fctl1 & 0xFF00 ) != FWKEY || ( reg16[ SIM_FCTL3 ] & 0xFF00 ) != FWKEY || ( reg16[ SIM_FCTL3 ] & LOCK )
+     || !( fctl1 & ( ERASE | WRT ) ) || ( fctl1 & MERAS ) || off >= SIM_INFO_SIZE - SIM_INFO_SEG || ( off & 1 ) ) {
+        stats.flash_errors++;
+        return;
+    }
+
+    cut = flash_hook && flash_hook( ( unsigned int )addr, erase );
+
+    if( erase ) {
+        seg = &info[ off & ~( SIM_INFO_SEG - 1 ) ];
+        stats.flash_erases++;
+        if( !cut ) memset( seg, 0xFF, SIM_INFO_SEG );
+        else for( k = 0; k < SIM_INFO_SEG; k++ ) seg[ k ] |= ( uint8_t )rand( );
+        if( !cut ) flash_stall( SIM_FLASH_ERASE_TFTG * flash_tftg( ) );
+    } else {
+        if( info[ off ] != 0xFF || info[ off + 1 ] != 0xFF ) stats.flash_errors++;
+        if( cut ) w |= rand( ) & 0xFFFF;
+        info[ off ] &= ( uint8_t )w;
+        info[ off + 1 ] &= ( uint8_t )( w >> 8 );
+        stats.flash_words++;
+        if( !cut ) flash_stall( SIM_FLASH_WORD_TFTG * flash_tftg( ) );
+    }
+    if( cut ) longjmp( run_env, SIM_JMP_END );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Watchdog Timer+                                                                                     //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Watchdog mode only; WDTTMSEL stops it.  The watchdog is left out until the  //
+// firmware first writes WDTCTL without WDTHOLD, so a harness that never touches it is not reset 32 ms //
+// in by the PUC default.  A write is seen at the next sync, after which WDTCTL is set back to how it  //
+// reads (0x69 password byte, WDTCNTCL clear) so that the same kick written twice is still a change.   //
+// The count is kept in sim ticks and does not stop in LPM3, so SMCLK as the source is only right for  //
+// a CPU that stays awake.  A wrong password resets the part like an expiry.                           //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static sim_time_t wdt_interval( void ) {
+
+    static const sim_time_t div[ 4 ] = { 32768, 8192, 512, 64 };
+
+    return( div[ wdt_ctl & ( WDTIS1 | WDTIS0 ) ] * ( ( wdt_ctl & WDTSSEL ) ? SIM_ACLK_TICKS : SIM_SMCLK_TICKS ) );
+}
+
+static int wdt_counting( void ) {
+
+    return( wdt_on && !( wdt_ctl & ( WDTHOLD | WDTTMSEL ) ) );
+}
+
+static void wdt_sync( void ) {
+
+    uint16_t v = reg16[ SIM_WDTCTL ];
+
+    if( v == wdt_seen ) return;
+    if( ( v & 0xFF00 ) != WDTPW ) cpu_reset( WDTIFG, 0, 0 );
+
+    if( wdt_counting( ) ) wdt_count += now - wdt_mark;
+    wdt_mark = now;
+    if( v & WDTCNTCL ) wdt_count = 0;
+
+    wdt_ctl = v & 0x00FF & ~WDTCNTCL;
+    if( !( wdt_ctl & WDTHOLD ) ) wdt_on = 1;
+    reg16[ SIM_WDTCTL ] = wdt_seen = 0x6900 | wdt_ctl;
+}
+
+static sim_time_t wdt_next( void ) {
+
+    sim_time_t t = wdt_interval( );
+
+    if( !wdt_counting( ) ) return( SIM_NEVER );
+    return( wdt_count >= t ? now : wdt_mark + ( t - wdt_count ) );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Digital I/O                                                                                         //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Pins are only driven from outside (scenario inputs and the plant), so       //
+// edges are detected where the level is set.  PxIES selects falling (1) or rising (0) edges.          //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static void port_drive( int port, uint8_t level ) {
+
+    static const int ifg[ 3 ] = { SIM_P1IFG, SIM_P2IFG, 0 };
+    static const int ies[ 3 ] = { SIM_P1IES, SIM_P2IES, 0 };
+    uint8_t rising = level & ~pin_in[ port ];
+    uint8_t falling = pin_in[ port ] & ~level;
+
+    pin_in[ port ] = level;
+    if( port > 2 ) return;
+
+    reg8[ ifg[ port - 1 ] ] |= ( rising & ~reg8[ ies[ port - 1 ] ] ) | ( falling & reg8[ ies[ port - 1 ] ] );
+}
+
+static int port_pending( int port ) {
+
+    if( !( sr & GIE ) ) return( 0 );
+    if( port == 1 ) return( ( reg8[ SIM_P1IFG ] & reg8[ SIM_P1IE ] ) != 0 );
+    return( ( reg8[ SIM_P2IFG ] & reg8[ SIM_P2IE ] ) != 0 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Live Well Plant                                                                                     //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Level moves linearly with the pumps that are running; the float edge is     //
+// solved for in closed form so a fill or drain costs one event.  Each well is a plant of its own,     //
+// with its own pumps and float.  Underway, water sloshing about the trip point makes the float        //
+// chatter (SIM_IN_SLOSH): after each edge the pin toggles an even number of times over about the      //
+// slosh time, while the level, and so the plant, has only the one edge.                               //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static int plant_float( int w ) {
+
+    return( plant[ w ].full );
+}
+
+// Only what the pin does is the firmware's input, and so what a recording holds
+static void float_pin( int w, int full ) {
+
+    if( ( ( pin_in[ 2 ] & SIM_FLOAT_BIT( w ) ) != 0 ) == full ) return;
+    port_drive( 2, full ? ( pin_in[ 2 ] | SIM_FLOAT_BIT( w ) ) : ( pin_in[ 2 ] & ~SIM_FLOAT_BIT( w ) ) );
+    if( input_hook ) input_hook( now, w, SIM_IN_FLOAT, 0, ( unsigned int )full );
+}
+
+static void plant_set_float( int w, int full ) {
+
+    plant[ w ].full = full;
+    plant[ w ].chatter = 0;
+    plant[ w ].chatter_at = SIM_NEVER;
+    float_pin( w, full );
+}
+
+static sim_time_t slosh_rand( sim_time_t n ) {
+
+    slosh_seed = slosh_seed * 1103515245UL + 12345UL;
+    return( n ? ( ( slosh_seed >> 16 ) & 0x7FFF ) * n / 0x8000 : 0 );
+}
+
+// Next toggle somewhere in the rest of the slosh time, shared out between the toggles left
+static void slosh_schedule( int w ) {
+
+    sim_well_t *p = &plant[ w ];
+
+    p->chatter_at = p->chatter ? now + 1 + slosh_rand( 2 * p->slosh / ( sim_time_t )( p->chatter + 1 ) ) : SIM_NEVER;
+}
+
+static void slosh_event( int w ) {
+
+    sim_well_t *p = &plant[ w ];
+
+    p->chatter--;
+    float_pin( w, p->chatter & 1 ? !p->full : p->full );
+    slosh_schedule( w );
+}
+
+static void plant_advance( int w ) {
+
+    sim_well_t *p = &plant[ w ];
+
+    p->p.level += p->rate * ( double )( now - p->time );
+    if( p->p.level < 0.0 ) p->p.level = 0.0;
+    if( p->p.level > p->p.capacity ) p->p.level = p->p.capacity;
+    p->time = now;
+
+    // Linear in between, so the extremes are all at the points it is brought up to date
+    if( !p->topped ) return;
+    if( p->p.level < stats.level_min[ w ] ) stats.level_min[ w ] = p->p.level;
+    if( p->p.level > stats.level_max[ w ] ) stats.level_max[ w ] = p->p.level;
+}
+
+static void plant_schedule( int w ) {
+
+    sim_well_t *p = &plant[ w ];
+    double target, ticks;
+
+    p->edge = SIM_NEVER;
+    if( p->rate > 0.0 && !plant_float( w ) ) target = p->p.float_at;
+    else if( p->rate < 0.0 && plant_float( w ) ) target = p->p.float_at - p->p.hyst;
+    else return;
+
+    ticks = ( target - p->p.level ) / p->rate;
+    p->edge = now + ( ticks > 0.0 ? ( sim_time_t )ticks + 1 : 0 );
+}
+
+static void plant_pumps( int w ) {
+
+    sim_well_t *p = &plant[ w ];
+
+    if( !plant_on ) return;
+
+    plant_advance( w );
+    p->rate = ( ( outputs[ SIM_SIG_WFILL( w ) ] ? p->p.fill_rate : 0.0 )
+              - ( outputs[ SIM_SIG_WDRAIN( w ) ] ? p->p.drain_rate : 0.0 ) ) / ( double )SIM_HZ;
+    plant_schedule( w );
+}
+
+static void plant_edge_event( int w ) {
+
+    plant_advance( w );
+    plant_set_float( w, !plant_float( w ) );
+    if( plant_float( w ) && !plant[ w ].topped ) {
+        plant[ w ].topped = 1;
+        stats.level_min[ w ] = stats.level_max[ w ] = plant[ w ].p.level;
+    }
+    plant_schedule( w );
+
+    if( !plant[ w ].slosh ) return;
+    plant[ w ].chatter = 2 * ( 1 + ( int )slosh_rand( 3 ) );
+    slosh_schedule( w );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Register Synchronisation                                                                            //
+//                                                                                                     //
+// Description: Runs before every register access and event.  Picks up what the firmware wrote since   //
+//              the last call (timer reconfiguration, ADC start, relay and LED changes) and refreshes  //
+//              the input registers.                                                                   //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static int port_bit( int out, int dir, uint8_t bit, int active_low ) {
+
+    if( !( reg8[ dir ] & bit ) ) return( 0 );
+    return( ( ( reg8[ out ] & bit ) != 0 ) != active_low );
+}
+
+static void sim_outputs( void ) {
+
+    int level[ SIM_NSIG ] = { 0 };
+    int sig, w, pumps = 0;
+
+    // Nothing to do unless an output port or its direction was written
+    if( reg8[ SIM_P1OUT ] == out_shadow[ 0 ] && reg8[ SIM_P1DIR ] == out_shadow[ 1 ]
+     && reg8[ SIM_P2OUT ] == out_shadow[ 2 ] && reg8[ SIM_P2DIR ] == out_shadow[ 3 ]
+     && reg8[ SIM_P3OUT ] == out_shadow[ 4 ] && reg8[ SIM_P3DIR ] == out_shadow[ 5 ] ) return;
+    out_shadow[ 0 ] = reg8[ SIM_P1OUT ];
+    out_shadow[ 1 ] = reg8[ SIM_P1DIR ];
+    out_shadow[ 2 ] = reg8[ SIM_P2OUT ];
+    out_shadow[ 3 ] = reg8[ SIM_P2DIR ];
+    out_shadow[ 4 ] = reg8[ SIM_P3OUT ];
+    out_shadow[ 5 ] = reg8[ SIM_P3DIR ];
+
+    for( w = 0; w < SIM_WELLS; w++ ) {
+        level[ SIM_SIG_WFILL( w ) ]  = port_bit( SIM_RELAY_OUT, SIM_RELAY_DIR, SIM_FILL_BIT( w ), 1 );
+        level[ SIM_SIG_WDRAIN( w ) ] = port_bit( SIM_RELAY_OUT, SIM_RELAY_DIR, SIM_DRAIN_BIT( w ), 1 );
+    }
+    level[ SIM_SIG_FLOAT_LED ]  = port_bit( SIM_P2OUT, SIM_P2DIR, BIT3, 0 );
+    level[ SIM_SIG_STATUS_LED ] = port_bit( SIM_P2OUT, SIM_P2DIR, BIT5, 0 );
+    level[ SIM_SIG_FILL_LED ]   = port_bit( SIM_P1OUT, SIM_P1DIR, BIT0, 0 );
+    level[ SIM_SIG_DRAIN_LED ]  = port_bit( SIM_P1OUT, SIM_P1DIR, BIT6, 0 );
+
+    for( sig = 0; sig < SIM_NSIG; sig++ ) {
+        if( level[ sig ] == outputs[ sig ] ) continue;
+        if( outputs[ sig ] ) stats.on_time[ sig ] += now - output_since[ sig ];
+        else stats.starts[ sig ]++;
+        outputs[ sig ] = level[ sig ];
+        output_since[ sig ] = now;
+        for( w = 0; w < SIM_WELLS; w++ ) {
+            if( sig == SIM_SIG_WFILL( w ) || sig == SIM_SIG_WDRAIN( w ) ) pumps |= 1 << w;
+        }
+        if( output_hook ) output_hook( now, sig, level[ sig ] );
+    }
+    for( w = 0; w < SIM_WELLS; w++ ) {
+        if( pumps & ( 1 << w ) ) plant_pumps( w );
+    }
+}
+
+static void sim_sync( void ) {
+
+    wdt_sync( );
+    timer_configure( &timer[ 0 ] );
+    timer_configure( &timer[ 1 ] );
+
+    if( !adc_busy
+     && ( reg16[ SIM_ADC10CTL0 ] & ( ADC10ON | ENC | ADC10SC ) ) == ( ADC10ON | ENC | ADC10SC ) ) {
+        adc_start( );
+    }
+
+    uart_sync( );
+    sim_outputs( );
+}
+
+volatile uint8_t *sim_reg8( int id ) {
+
+    sim_sync( );
+
+    switch( id ) {
+    case SIM_P1IN:
+        reg8[ id ] = ( pin_in[ 1 ] & ~reg8[ SIM_P1DIR ] ) | ( reg8[ SIM_P1OUT ] & reg8[ SIM_P1DIR ] );
+        break;
+    case SIM_P2IN:
+        reg8[ id ] = ( pin_in[ 2 ] & ~reg8[ SIM_P2DIR ] ) | ( reg8[ SIM_P2OUT ] & reg8[ SIM_P2DIR ] );
+        break;
+    case SIM_P3IN:
+        reg8[ id ] = ( pin_in[ 3 ] & ~reg8[ SIM_P3DIR ] ) | ( reg8[ SIM_P3OUT ] & reg8[ SIM_P3DIR ] );
+        break;
+    case SIM_UCA0STAT:
+        reg8[ id ] = ( reg8[ id ] & ~UCBUSY ) | ( ( uart_busy || uart_full ) ? UCBUSY : 0 );
+        break;
+    case SIM_UCA0TXBUF:
+        uart_written = 1;
+        break;
+    }
+    return( &reg8[ id ] );
+}
+
+volatile uint16_t *sim_reg16( int id ) {
+
+    sim_sync( );
+
+    if( id == SIM_TA0 + SIM_TA_R ) reg16[ id ] = ( uint16_t )timer_count( &timer[ 0 ] );
+    if( id == SIM_TA1 + SIM_TA_R ) reg16[ id ] = ( uint16_t )timer_count( &timer[ 1 ] );
+    return( &reg16[ id ] );
+}
+
+volatile sim_addr_t *sim_adc10sa( void ) {
+
+    sim_sync( );
+    dtc_block = 0;
+    dtc_pos = 0;
+    dtc_stopped = 0;
+    return( &adc10sa );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Event Scheduling                                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static sim_time_t sim_next( int *src ) {
+
+    sim_time_t t, best = SIM_NEVER;
+    int w;
+
+    *src = SRC_NONE;
+    if( ( t = timer_next( &timer[ 0 ] ) ) < best ) { best = t; *src = SRC_TIMER0; }
+    if( ( t = timer_next( &timer[ 1 ] ) ) < best ) { best = t; *src = SRC_TIMER1; }
+    if( adc_busy && adc_done < best ) { best = adc_done; *src = SRC_ADC; }
+    if( ( sr & GIE ) && ( reg16[ SIM_ADC10CTL0 ] & ( ADC10IFG | ADC10IE ) ) == ( ADC10IFG | ADC10IE ) ) {
+        best = now; *src = SRC_ADC;
+    }
+    if( port_pending( 1 ) ) { best = now; *src = SRC_PORT1; }
+    if( port_pending( 2 ) ) { best = now; *src = SRC_PORT2; }
+    if( uart_busy && uart_done < best ) { best = uart_done; *src = SRC_UART; }
+    if( uart_pending( ) ) { best = now; *src = SRC_UART_TX; }
+    if( next_input < n_inputs && inputs[ next_input ].at < best ) { best = inputs[ next_input ].at; *src = SRC_INPUT; }
+    for( w = 0; plant_on && w < SIM_WELLS; w++ ) {
+        if( plant[ w ].edge < best ) { best = plant[ w ].edge; *src = SRC_PLANT; plant_next = w; }
+        if( plant[ w ].chatter_at < best ) { best = plant[ w ].chatter_at; *src = SRC_SLOSH; plant_next = w; }
+    }
+    if( ( t = wdt_next( ) ) < best ) { best = t; *src = SRC_WDT; }
+    if( max_step && next_step < best ) { best = next_step; *src = SRC_STEP; }
+    if( best < now ) best = now;
+    return( best );
+}
+
+static void sim_apply_input( void ) {
+
+    const sim_input_t *in = &inputs[ next_input++ ];
+    int w = in->well;
+
+    if( w < 0 || w >= SIM_WELLS ) return;       // sim_add_well_input keeps them out, this tells the compiler
+
+    if( in->kind == SIM_IN_FLOAT ) {
+        if( plant_on ) plant_advance( w );
+        plant_set_float( w, in->value );
+        if( plant_on ) plant_schedule( w );
+    } else if( in->kind == SIM_IN_POT ) {
+        if( analog[ in->ch & 7 ] == ( in->value & 0x3FF ) ) return;
+        analog[ in->ch & 7 ] = in->value & 0x3FF;
+        if( input_hook ) input_hook( now, 0, SIM_IN_POT, in->ch & 7, in->value & 0x3FF );
+    } else if( in->kind == SIM_IN_RATES ) {
+        if( plant_on ) plant_advance( w );
+        plant[ w ].p.fill_rate = in->ch;
+        plant[ w ].p.drain_rate = in->value;
+        plant_pumps( w );
+    } else if( in->kind == SIM_IN_SLOSH ) {
+        plant[ w ].slosh = ( sim_time_t )in->value * SIM_MS;
+    } else if( in->kind == SIM_IN_RESET ) {
+        if( input_hook ) input_hook( now, 0, SIM_IN_RESET, 0, in->value );
+        if( in->value == SIM_RESET_PIN ) cpu_reset( RSTIFG, 0, 0 );
+        cpu_reset( PORIFG, 1, in->value == SIM_RESET_POWER );
+    } else if( in->kind == SIM_IN_HANG && !hung ) {
+        // Stuck with interrupts off: only the watchdog, or the end of the run, gets out of here
+        if( input_hook ) input_hook( now, 0, SIM_IN_HANG, 0, 0 );
+        stats.hangs++;
+        hung = 1;
+        sr &= ~( GIE | SR_LPM_BITS );
+        while( hung ) sim_step( );
+    }
+}
+
+static void sim_step( void ) {
+
+    int src;
+    sim_time_t t;
+
+    sim_sync( );
+    t = sim_next( &src );
+    if( t > end_time || src == SRC_NONE ) {
+        now = end_time;
+        sim_sync( );
+        longjmp( run_env, SIM_JMP_END );
+    }
+    if( sr & CPUOFF ) stats.sleep_time += t - now;
+    else stats.active_time += t - now;
+    now = t;
+    if( src != SRC_STEP ) stats.events++;
+
+    switch( src ) {
+    case SRC_TIMER0: timer_fire( &timer[ 0 ], Timer0_A0 ); break;
+    case SRC_TIMER1: timer_fire( &timer[ 1 ], Timer1_A0 ); break;
+    case SRC_ADC:    adc_complete( ); break;
+    case SRC_PORT1:  sim_isr( SIM_VEC_PORT1, Port_1 ); break;
+    case SRC_PORT2:  sim_isr( SIM_VEC_PORT2, Port_2 ); break;
+    case SRC_UART:   uart_complete( ); break;
+    case SRC_UART_TX: sim_isr( SIM_VEC_USCI_TX, USCI0TX_ISR ); break;
+    case SRC_INPUT:  sim_apply_input( ); break;
+    case SRC_PLANT:  plant_edge_event( plant_next ); break;
+    case SRC_SLOSH:  slosh_event( plant_next ); break;
+    case SRC_WDT:    cpu_reset( WDTIFG, 0, 0 ); break;
+    case SRC_STEP:   next_step += max_step; break;
+    }
+    sim_sync( );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Firmware Hooks                                                                                      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void sim_idle( void ) {
+
+    stats.idles++;
+    sim_step( );
+}
+
+void sim_bis_sr( unsigned int bits ) {
+
+    sr |= bits;
+    if( !( sr & CPUOFF ) ) return;
+
+    stats.sleeps++;
+    while( sr & CPUOFF ) sim_step( );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Simulator Control                                                                                   //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Registers and peripherals to their PUC state; IFG1 is left for the caller
+static void periph_reset( void ) {
+
+    memset( reg8, 0, sizeof( reg8 ) );
+    memset( reg16, 0, sizeof( reg16 ) );
+    memset( timer, 0, sizeof( timer ) );
+
+    timer[ 0 ].next = timer[ 1 ].next = SIM_NEVER;
+    timer[ 0 ].base = SIM_TA0;
+    timer[ 0 ].vec = SIM_VEC_TIMER0_A0;
+    timer[ 1 ].base = SIM_TA1;
+    timer[ 1 ].vec = SIM_VEC_TIMER1_A0;
+
+    reg16[ SIM_WDTCTL ] = wdt_seen = 0x6900;
+    wdt_on = 0;
+    wdt_ctl = 0;
+    wdt_count = 0;
+    wdt_mark = now;
+    reg8[ SIM_CALBC1_1MHZ ] = 0x86;
+    reg8[ SIM_CALDCO_1MHZ ] = 0xB6;
+    reg8[ SIM_UCA0CTL1 ] = UCSWRST;
+    reg8[ SIM_IFG2 ] = UCA0TXIFG;
+
+    reg16[ SIM_FCTL1 ] = 0x9600;
+    reg16[ SIM_FCTL2 ] = 0x9642;
+    reg16[ SIM_FCTL3 ] = 0x9658;
+
+    adc10sa = 0;
+    adc_busy = 0;
+    dtc_block = 0;
+    dtc_pos = 0;
+    dtc_stopped = 0;
+    uart_written = uart_full = uart_busy = 0;
+    sr = 0;
+    isr_sr = 0;
+    hung = 0;
+}
+
+// Firmware RAM back to the C startup image; no-init RAM gets noise if the power went
+static void fw_ram_load( int ram_lost ) {
+
+    size_t data = __stop_fw_data - __start_fw_data, bss = __stop_fw_bss - __start_fw_bss;
+    char *p;
+
+    if( fw_image && data ) memcpy( __start_fw_data, fw_image, data );
+    if( fw_image && bss ) memcpy( __start_fw_bss, fw_image + data, bss );
+    if( ram_lost ) for( p = __start_fw_noinit; p < __stop_fw_noinit; p++ ) *p = ( char )rand( );
+}
+
+// Runs before main, while the firmware's variables still hold their initial values
+__attribute__(( constructor )) static void fw_ram_save( void ) {
+
+    size_t data = __stop_fw_data - __start_fw_data, bss = __stop_fw_bss - __start_fw_bss;
+
+    if( !( fw_image = malloc( data + bss + 1 ) ) ) return;
+    if( data ) memcpy( fw_image, __start_fw_data, data );
+    if( bss ) memcpy( fw_image + data, __start_fw_bss, bss );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Resets the simulated part and restarts the firmware from its entry point.              //
+// Arguments:   ifg1 - reset flags to raise, por - power-on reset (IFG1 starts over),                  //
+//              ram_lost - the supply went away long enough to lose no-init RAM                        //
+// Returns:     Does not return                                                                        //
+//                                                                                                     //
+// Notes/Warnings/Caveats: The relays drop as the port pins go back to inputs.                         //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static void cpu_reset( uint8_t ifg1, int por, int ram_lost ) {
+
+    uint8_t flags = por ? 0 : reg8[ SIM_IFG1 ];
+
+    stats.resets++;
+    if( ifg1 & WDTIFG ) stats.watchdog_resets++;
+    stats.last_reset = now;
+
+    periph_reset( );
+    reg8[ SIM_IFG1 ] = flags | ifg1;
+    fw_ram_load( ram_lost );
+    sim_sync( );
+    longjmp( run_env, SIM_JMP_RESET );
+}
+
+void sim_reset( void ) {
+
+    int k;
+
+    now = 0;
+    periph_reset( );
+    reg8[ SIM_IFG1 ] = PORIFG;
+
+    memset( &stats, 0, sizeof( stats ) );
+    memset( outputs, 0, sizeof( outputs ) );
+    memset( output_since, 0, sizeof( output_since ) );
+    memset( pin_in, 0, sizeof( pin_in ) );
+    memset( out_shadow, 0xFF, sizeof( out_shadow ) );
+    memset( analog, 0, sizeof( analog ) );
+
+    if( !info_ready ) memset( info, 0xFF, sizeof( info ) );
+    info_ready = 1;
+
+    uart_hook = 0;
+    flash_hook = 0;
+    input_hook = 0;
+    n_inputs = next_input = 0;
+    plant_on = 0;
+    memset( plant, 0, sizeof( plant ) );
+    for( k = 0; k < SIM_WELLS; k++ ) plant[ k ].edge = plant[ k ].chatter_at = SIM_NEVER;
+    slosh_seed = 1;
+    output_hook = 0;
+    max_step = 0;
+}
+
+void sim_set_plant( const sim_plant_t *p ) {
+
+    int w;
+
+    plant_on = ( p != 0 );
+    for( w = 0; p && w < SIM_WELLS; w++ ) sim_set_well_plant( w, p );
+}
+
+// Sets one well's plant, leaving the others as they are
+void sim_set_well_plant( int well, const sim_plant_t *p ) {
+
+    sim_well_t *w;
+
+    if( !p || well < 0 || well >= SIM_WELLS ) return;
+
+    plant_on = 1;
+    w = &plant[ well ];
+    w->p = *p;
+    w->time = now;
+    w->rate = 0.0;
+    plant_set_float( well, w->p.level >= w->p.float_at );
+    plant_schedule( well );
+}
+
+void sim_add_input( sim_time_t at, int kind, int ch, unsigned int value ) {
+
+    sim_add_well_input( at, 0, kind, ch, value );
+}
+
+void sim_add_well_input( sim_time_t at, int well, int kind, int ch, unsigned int value ) {
+
+    int k;
+
+    if( n_inputs == SIM_MAX_INPUTS || well < 0 || well >= SIM_WELLS ) return;
+
+    // Keep the script sorted; inputs at the same instant stay in the order given
+    for( k = n_inputs; k > next_input && inputs[ k - 1 ].at > at; k-- ) inputs[ k ] = inputs[ k - 1 ];
+    inputs[ k ].at = at;
+    inputs[ k ].well = well;
+    inputs[ k ].kind = kind;
+    inputs[ k ].ch = ch;
+    inputs[ k ].value = value;
+    n_inputs++;
+
+    // Inputs at time zero are the power-on state
+    while( next_input < n_inputs && inputs[ next_input ].at <= now ) sim_apply_input( );
+}
+
+void sim_set_output_hook( void ( *hook )( sim_time_t t, int sig, int on ) ) {
+
+    output_hook = hook;
+}
+
+void sim_set_uart_hook( void ( *hook )( sim_time_t t, unsigned char c ) ) {
+
+    uart_hook = hook;
+}
+
+// Called as the firmware's inputs change: float pins, pot counts, scripted resets and hangs
+void sim_set_input_hook( void ( *hook )( sim_time_t t, int well, int kind, int ch, unsigned int value ) ) {
+
+    input_hook = hook;
+}
+
+// Wakes the simulator at least every step ticks, with nothing else happening, to check the jumps
+void sim_set_max_step( sim_time_t step ) {
+
+    max_step = step;
+    next_step = now + step;
+}
+
+void sim_set_flash_hook( int ( *hook )( unsigned int addr, int erase ) ) {
+
+    flash_hook = hook;
+}
+
+// The information memory image, SIM_INFO_SIZE bytes from 0x1000; erased until something is written
+unsigned char *sim_flash( void ) {
+
+    if( !info_ready ) memset( info, 0xFF, sizeof( info ) );
+    info_ready = 1;
+    return( info );
+}
+
+// Each run starts from a power up; a reset along the way re-enters the firmware at entry
+int sim_run( int ( *entry )( void ), sim_time_t end ) {
+
+    int sig;
+
+    end_time = end;
+    fw_ram_load( 1 );
+    if( setjmp( run_env ) != SIM_JMP_END ) entry( );
+
+    for( sig = 0; sig < SIM_NSIG; sig++ ) {
+        if( outputs[ sig ] ) stats.on_time[ sig ] += now - output_since[ sig ];
+        output_since[ sig ] = now;
+    }
+    stats.run_time = now;
+    return( 0 );
+}
+
+sim_time_t sim_now( void ) { return( now ); }
+const sim_stats_t *sim_stats( void ) { return( &stats ); }
+const char *sim_signal_name( int sig ) { return( signal_names[ sig ] ); }
+
+// Firmware RAM on the host, which has wider pointers and alignment than the G2553
+void sim_fw_ram( unsigned long *data, unsigned long *bss, unsigned long *noinit ) {
+
+    *data = ( unsigned long )( __stop_fw_data - __start_fw_data );
+    *bss = ( unsigned long )( __stop_fw_bss - __start_fw_bss );
+    *noinit = ( unsigned long )( __stop_fw_noinit - __start_fw_noinit );
+}
@@ -0,0 +1,314 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                  MSP430G2553 Register Emulation                                     //
+//                                                                                                     //
+//                                                                                                     //
+// File              : sim_msp430.h                                                                    //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Stand-in for <msp430.h> when the firmware is compiled for the host (LWC_SIM).  Every peripheral     //
+// register is an lvalue returned by an accessor, so the simulator sees each access and can bring      //
+// timers, the ADC and the port pins up to date before the firmware looks at them.  Only the           //
+// registers and bit names the firmware actually uses are provided; values match the TI header.        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef SIM_MSP430_H
+#define SIM_MSP430_H
+
+#include <stdint.h>
+
+typedef uintptr_t sim_addr_t;
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Register Identifiers                                                                                //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+enum {
+    SIM_P1IN, SIM_P1OUT, SIM_P1DIR, SIM_P1IFG, SIM_P1IES, SIM_P1IE, SIM_P1SEL, SIM_P1SEL2, SIM_P1REN,
+    SIM_P2IN, SIM_P2OUT, SIM_P2DIR, SIM_P2IFG, SIM_P2IES, SIM_P2IE, SIM_P2SEL, SIM_P2SEL2, SIM_P2REN,
+    SIM_P3IN, SIM_P3OUT, SIM_P3DIR, SIM_P3SEL, SIM_P3SEL2, SIM_P3REN,
+    SIM_IE1, SIM_IFG1, SIM_IE2, SIM_IFG2,
+    SIM_DCOCTL, SIM_BCSCTL1, SIM_BCSCTL2, SIM_BCSCTL3,
+    SIM_ADC10DTC0, SIM_ADC10DTC1, SIM_ADC10AE0,
+    SIM_CALBC1_1MHZ, SIM_CALDCO_1MHZ,
+    SIM_UCA0CTL0, SIM_UCA0CTL1, SIM_UCA0BR0, SIM_UCA0BR1, SIM_UCA0MCTL, SIM_UCA0STAT, SIM_UCA0TXBUF,
+    SIM_NREG8
+};
+
+// Timer blocks are laid out identically so the simulator can treat them generically
+#define SIM_TA_CTL              0
+#define SIM_TA_R                1
+#define SIM_TA_CCTL0            2
+#define SIM_TA_CCTL1            3
+#define SIM_TA_CCTL2            4
+#define SIM_TA_CCR0             5
+#define SIM_TA_CCR1             6
+#define SIM_TA_CCR2             7
+#define SIM_TA_REGS             8
+
+enum {
+    SIM_WDTCTL,
+    SIM_TA0 = SIM_WDTCTL + 1,
+    SIM_TA1 = SIM_TA0 + SIM_TA_REGS,
+    SIM_ADC10CTL0 = SIM_TA1 + SIM_TA_REGS,
+    SIM_ADC10CTL1,
+    SIM_ADC10MEM,
+    SIM_FCTL1,
+    SIM_FCTL2,
+    SIM_FCTL3,
+    SIM_NREG16
+};
+
+volatile uint8_t *sim_reg8( int id );
+volatile uint16_t *sim_reg16( int id );
+volatile sim_addr_t *sim_adc10sa( void );
+const uint8_t *sim_info( sim_addr_t addr );
+void sim_flash_word( sim_addr_t addr, unsigned int w );
+
+// Stand-in for the RAM between the variables and the top of the stack (HAL_STACK_LOW)
+#define SIM_STACK_WORDS         128
+extern unsigned int sim_stack[ SIM_STACK_WORDS ];
+
+#define P1IN                    (*sim_reg8( SIM_P1IN ))
+#define P1OUT                   (*sim_reg8( SIM_P1OUT ))
+#define P1DIR                   (*sim_reg8( SIM_P1DIR ))
+#define P1IFG                   (*sim_reg8( SIM_P1IFG ))
+#define P1IES                   (*sim_reg8( SIM_P1IES ))
+#define P1IE                    (*sim_reg8( SIM_P1IE ))
+#define P1SEL                   (*sim_reg8( SIM_P1SEL ))
+#define P1SEL2                  (*sim_reg8( SIM_P1SEL2 ))
+#define P1REN                   (*sim_reg8( SIM_P1REN ))
+
+#define P2IN                    (*sim_reg8( SIM_P2IN ))
+#define P2OUT                   (*sim_reg8( SIM_P2OUT ))
+#define P2DIR                   (*sim_reg8( SIM_P2DIR ))
+#define P2IFG                   (*sim_reg8( SIM_P2IFG ))
+#define P2IES                   (*sim_reg8( SIM_P2IES ))
+#define P2IE                    (*sim_reg8( SIM_P2IE ))
+#define P2SEL                   (*sim_reg8( SIM_P2SEL ))
+#define P2SEL2                  (*sim_reg8( SIM_P2SEL2 ))
+#define P2REN                   (*sim_reg8( SIM_P2REN ))
+
+#define P3IN                    (*sim_reg8( SIM_P3IN ))
+#define P3OUT                   (*sim_reg8( SIM_P3OUT ))
+#define P3DIR                   (*sim_reg8( SIM_P3DIR ))
+#define P3SEL                   (*sim_reg8( SIM_P3SEL ))
+#define P3SEL2                  (*sim_reg8( SIM_P3SEL2 ))
+#define P3REN                   (*sim_reg8( SIM_P3REN ))
+
+#define IE1                     (*sim_reg8( SIM_IE1 ))
+#define IFG1                    (*sim_reg8( SIM_IFG1 ))
+#define IE2                     (*sim_reg8( SIM_IE2 ))
+#define IFG2                    (*sim_reg8( SIM_IFG2 ))
+
+#define DCOCTL                  (*sim_reg8( SIM_DCOCTL ))
+#define BCSCTL1                 (*sim_reg8( SIM_BCSCTL1 ))
+#define BCSCTL2                 (*sim_reg8( SIM_BCSCTL2 ))
+#define BCSCTL3                 (*sim_reg8( SIM_BCSCTL3 ))
+#define CALBC1_1MHZ             (*sim_reg8( SIM_CALBC1_1MHZ ))
+#define CALDCO_1MHZ             (*sim_reg8( SIM_CALDCO_1MHZ ))
+
+#define WDTCTL                  (*sim_reg16( SIM_WDTCTL ))
+
+#define TA0CTL                  (*sim_reg16( SIM_TA0 + SIM_TA_CTL ))
+#define TA0R                    (*sim_reg16( SIM_TA0 + SIM_TA_R ))
+#define TA0CCTL0                (*sim_reg16( SIM_TA0 + SIM_TA_CCTL0 ))
+#define TA0CCTL1                (*sim_reg16( SIM_TA0 + SIM_TA_CCTL1 ))
+#define TA0CCTL2                (*sim_reg16( SIM_TA0 + SIM_TA_CCTL2 ))
+#define TA0CCR0                 (*sim_reg16( SIM_TA0 + SIM_TA_CCR0 ))
+#define TA0CCR1                 (*sim_reg16( SIM_TA0 + SIM_TA_CCR1 ))
+#define TA0CCR2                 (*sim_reg16( SIM_TA0 + SIM_TA_CCR2 ))
+
+#define TA1CTL                  (*sim_reg16( SIM_TA1 + SIM_TA_CTL ))
+#define TA1R                    (*sim_reg16( SIM_TA1 + SIM_TA_R ))
+#define TA1CCTL0                (*sim_reg16( SIM_TA1 + SIM_TA_CCTL0 ))
+#define TA1CCTL1                (*sim_reg16( SIM_TA1 + SIM_TA_CCTL1 ))
+#define TA1CCTL2                (*sim_reg16( SIM_TA1 + SIM_TA_CCTL2 ))
+#define TA1CCR0                 (*sim_reg16( SIM_TA1 + SIM_TA_CCR0 ))
+#define TA1CCR1                 (*sim_reg16( SIM_TA1 + SIM_TA_CCR1 ))
+#define TA1CCR2                 (*sim_reg16( SIM_TA1 + SIM_TA_CCR2 ))
+
+#define ADC10CTL0               (*sim_reg16( SIM_ADC10CTL0 ))
+#define ADC10CTL1               (*sim_reg16( SIM_ADC10CTL1 ))
+#define ADC10MEM                (*sim_reg16( SIM_ADC10MEM ))
+#define ADC10DTC0               (*sim_reg8( SIM_ADC10DTC0 ))
+#define ADC10DTC1               (*sim_reg8( SIM_ADC10DTC1 ))
+#define ADC10AE0                (*sim_reg8( SIM_ADC10AE0 ))
+#define ADC10SA                 (*sim_adc10sa( ))
+
+#define UCA0CTL0                (*sim_reg8( SIM_UCA0CTL0 ))
+#define UCA0CTL1                (*sim_reg8( SIM_UCA0CTL1 ))
+#define UCA0BR0                 (*sim_reg8( SIM_UCA0BR0 ))
+#define UCA0BR1                 (*sim_reg8( SIM_UCA0BR1 ))
+#define UCA0MCTL                (*sim_reg8( SIM_UCA0MCTL ))
+#define UCA0STAT                (*sim_reg8( SIM_UCA0STAT ))
+#define UCA0TXBUF               (*sim_reg8( SIM_UCA0TXBUF ))
+
+#define FCTL1                   (*sim_reg16( SIM_FCTL1 ))
+#define FCTL2                   (*sim_reg16( SIM_FCTL2 ))
+#define FCTL3                   (*sim_reg16( SIM_FCTL3 ))
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Bit Definitions                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#define BIT0                    0x0001
+#define BIT1                    0x0002
+#define BIT2                    0x0004
+#define BIT3                    0x0008
+#define BIT4                    0x0010
+#define BIT5                    0x0020
+#define BIT6                    0x0040
+#define BIT7                    0x0080
+
+// Status register
+#define GIE                     0x0008
+#define CPUOFF                  0x0010
+#define OSCOFF                  0x0020
+#define SCG0                    0x0040
+#define SCG1                    0x0080
+#define LPM0_bits               ( CPUOFF )
+#define LPM3_bits               ( SCG1 + SCG0 + CPUOFF )
+
+// Watchdog
+#define WDTPW                   0x5A00
+#define WDTHOLD                 0x0080
+#define WDTNMIES                0x0040
+#define WDTNMI                  0x0020
+#define WDTTMSEL                0x0010          // interval timer mode
+#define WDTCNTCL                0x0008
+#define WDTSSEL                 0x0004          // ACLK
+#define WDTIS1                  0x0002
+#define WDTIS0                  0x0001
+
+// IFG1 reset flags
+#define WDTIFG                  0x01
+#define OFIFG                   0x02
+#define PORIFG                  0x04
+#define RSTIFG                  0x08
+#define NMIIFG                  0x10
+
+// Timer_A
+#define TASSEL_1                0x0100          // ACLK
+#define TASSEL_2                0x0200          // SMCLK
+#define ID_0                    0x0000
+#define ID_1                    0x0040
+#define ID_2                    0x0080
+#define ID_3                    0x00C0
+#define MC_0                    0x0000
+#define MC_1                    0x0010          // Up
+#define MC_2                    0x0020          // Continuous
+#define TACLR                   0x0004
+#define TAIE                    0x0002
+#define TAIFG                   0x0001
+#define OUTMOD_7                0x00E0          // reset/set
+#define CCIE                    0x0010
+#define CCIFG                   0x0001
+
+// ADC10
+#define ADC10SC                 0x0001
+#define ENC                     0x0002
+#define ADC10IFG                0x0004
+#define ADC10IE                 0x0008
+#define ADC10ON                 0x0010
+#define MSC                     0x0080
+#define ADC10SHT_0              0x0000
+#define ADC10SHT_1              0x0800
+#define ADC10SHT_2              0x1000
+#define ADC10SHT_3              0x1800
+
+#define ADC10BUSY               0x0001
+#define CONSEQ_0                0x0000
+#define CONSEQ_1                0x0002
+#define CONSEQ_2                0x0004
+#define CONSEQ_3                0x0006
+#define INCH_0                  0x0000
+#define INCH_1                  0x1000
+#define INCH_2                  0x2000
+#define INCH_3                  0x3000
+#define INCH_4                  0x4000
+#define INCH_5                  0x5000
+#define INCH_6                  0x6000
+#define INCH_7                  0x7000
+
+#define ADC10FETCH              0x0001
+#define ADC10B1                 0x0002
+#define ADC10CT                 0x0004
+#define ADC10TB                 0x0008
+
+// USCI_A0, UART mode
+#define UCSWRST                 0x01
+#define UCSSEL_1                0x40            // ACLK
+#define UCSSEL_2                0x80            // SMCLK
+#define UCBRS_0                 0x00
+#define UCBRS_1                 0x02
+#define UCBRS_2                 0x04
+#define UCBRS_3                 0x06
+#define UCBRS_4                 0x08
+#define UCBRS_5                 0x0A
+#define UCBRS_6                 0x0C
+#define UCBRS_7                 0x0E
+#define UCBUSY                  0x01
+#define UCA0TXIE                0x02            // IE2
+#define UCA0TXIFG               0x02            // IFG2
+
+// Flash controller
+#define FWKEY                   0xA500
+#define ERASE                   0x0002          // FCTL1
+#define MERAS                   0x0004
+#define WRT                     0x0040
+#define BLKWRT                  0x0080
+#define FSSEL_0                 0x0000          // FCTL2, ACLK
+#define FSSEL_1                 0x0040          // MCLK
+#define FSSEL_2                 0x0080          // SMCLK
+#define FN0                     0x0001
+#define FN1                     0x0002
+#define FN2                     0x0004
+#define FN3                     0x0008
+#define FN4                     0x0010
+#define FN5                     0x0020
+#define BUSY                    0x0001          // FCTL3
+#define KEYV                    0x0002
+#define ACCVIFG                 0x0004
+#define LOCK                    0x0010
+#define LOCKA                   0x0040
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Intrinsics                                                                                          //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void sim_eint( void );
+void sim_dint( void );
+void sim_bis_sr( unsigned int bits );
+void sim_bic_sr_on_exit( unsigned int bits );
+unsigned int sim_get_sr( void );
+
+#define _EINT( )                        sim_eint( )
+#define _DINT( )                        sim_dint( )
+#define __enable_interrupt( )           sim_eint( )
+#define __disable_interrupt( )          sim_dint( )
+#define __bis_SR_register( x )          sim_bis_sr( x )
+#define __bic_SR_register_on_exit( x )  sim_bic_sr_on_exit( x )
+#define __get_SR_register( )            sim_get_sr( )
+#define __no_operation( )
+
+// ISRs are plain functions on the host; the simulator calls them by name
+#define __interrupt
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Firmware Hooks (see hal.h)                                                                          //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void sim_idle( void );
+
+#endif
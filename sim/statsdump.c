@@ -0,0 +1,87 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                       Statistics Log Decoder                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : statsdump.c                                                                     //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Prints the pump totals from an information memory image (see stats.h).  The image starts at 0x1000  //
+// and is raw bytes as written by lwcsim -F, or with -x a hex dump such as mspdebug "md 0x1000 192"    //
+// prints.  -v also lists every slot.                                                                  //
+//                                                                                                     //
+// Usage: statsdump [-x] [-v] [file]                                                                   //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "statsimg.h"
+
+static size_t read_hex( FILE *f, unsigned char *buf, size_t max ) {
+
+    char line[ 512 ], *p, *end;
+    size_t n = 0;
+
+    while( n < max && fgets( line, sizeof( line ), f ) ) {
+        p = strchr( line, ':' );
+        p = p ? p + 1 : line;
+        for( ;; ) {
+            while( *p == ' ' || *p == '\t' ) p++;
+            if( !isxdigit( ( unsigned char )p[ 0 ] ) || !isxdigit( ( unsigned char )p[ 1 ] ) ) break;
+            if( p[ 2 ] && !isspace( ( unsigned char )p[ 2 ] ) ) break;
+            if( n < max ) buf[ n++ ] = ( unsigned char )strtoul( p, &end, 16 );
+            p = end;
+        }
+    }
+    return( n );
+}
+
+int main( int argc, char **argv ) {
+
+    static const char * const slot_states[] = { "blank", "valid", "torn" };
+    unsigned char img[ STATS_IMAGE_SIZE ];
+    const char *path = 0;
+    int hex = 0, verbose = 0, a, s;
+    stats_rec_t r;
+    size_t n;
+    FILE *f = stdin;
+
+    for( a = 1; a < argc; a++ ) {
+        if( !strcmp( argv[ a ], "-x" ) ) hex = 1;
+        else if( !strcmp( argv[ a ], "-v" ) ) verbose = 1;
+        else if( argv[ a ][ 0 ] != '-' && !path ) path = argv[ a ];
+        else {
+            fprintf( stderr, "usage: %s [-x] [-v] [file]\n", argv[ 0 ] );
+            return( 2 );
+        }
+    }
+    if( path && !( f = fopen( path, hex ? "r" : "rb" ) ) ) {
+        perror( path );
+        return( 1 );
+    }
+    n = hex ? read_hex( f, img, sizeof( img ) ) : fread( img, 1, sizeof( img ), f );
+    if( f != stdin ) fclose( f );
+
+    if( n < sizeof( img ) ) {
+        fprintf( stderr, "need %u bytes from 0x%04X, got %lu\n", STATS_IMAGE_SIZE, STATS_BASE, ( unsigned long )n );
+        return( 1 );
+    }
+
+    if( verbose ) {
+        for( s = 0; s < STATS_SLOTS; s++ ) {
+            printf( "slot %d  0x%04X  %s\n", s, STATS_BASE + s * STATS_REC_SIZE, slot_states[ stats_slot_state( img, s ) ] );
+        }
+    }
+    stats_latest( img, &r );
+    stats_print( &r );
+    return( 0 );
+}
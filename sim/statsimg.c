@@ -0,0 +1,99 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                      Statistics Log Image Reader                                    //
+//                                                                                                     //
+//                                                                                                     //
+// File              : statsimg.c                                                                      //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Reads the record ring stats.c keeps in segments D to B, written independently of the firmware so    //
+// the benches check one against the other.  img is the STATS_IMAGE_SIZE bytes from STATS_BASE.        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+
+#include "statsimg.h"
+
+static unsigned int get16( const unsigned char *p ) {
+
+    return( p[ 0 ] | ( p[ 1 ] << 8 ) );
+}
+
+static unsigned long get32( const unsigned char *p ) {
+
+    return( get16( p ) | ( ( unsigned long )get16( p + 2 ) << 16 ) );
+}
+
+int stats_slot_state( const unsigned char *img, int slot ) {
+
+    const unsigned char *r = img + slot * STATS_REC_SIZE;
+    unsigned int sum, k;
+
+    for( k = 0; k < STATS_REC_SIZE && r[ k ] == 0xFF; k++ );
+    if( k == STATS_REC_SIZE ) return( STATS_SLOT_BLANK );
+
+    sum = get16( r + SR_SEQ );
+    for( k = SR_FILL_S; k < STATS_REC_SIZE; k += 2 ) sum += get16( r + k );
+    if( get16( r + SR_SEQ ) == 0xFFFF || get16( r + SR_CHECK ) != ( ~sum & 0xFFFF ) ) return( STATS_SLOT_TORN );
+    return( STATS_SLOT_VALID );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Decodes the newest valid record.                                                       //
+// Arguments:   img - log image, r - filled in                                                         //
+// Returns:     its slot, or -1 if there is none (r is then all zero)                                  //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int stats_latest( const unsigned char *img, stats_rec_t *r ) {
+
+    const unsigned char *p;
+    unsigned int seq;
+    int s, best = -1;
+
+    for( s = 0; s < STATS_SLOTS; s++ ) {
+        if( stats_slot_state( img, s ) != STATS_SLOT_VALID ) continue;
+        seq = get16( img + s * STATS_REC_SIZE + SR_SEQ );
+        if( best < 0 || ( ( seq - r->seq ) & 0x8000 ) == 0 ) {
+            best = s;
+            r->seq = seq;
+        }
+    }
+
+    r->slot = best;
+    if( best < 0 ) {
+        r->seq = 0;
+        r->fill_s = r->drain_s = r->fill_starts = r->drain_starts = r->boots = r->powered_min = 0;
+        return( -1 );
+    }
+    p = img + best * STATS_REC_SIZE;
+    r->fill_s = get32( p + SR_FILL_S );
+    r->drain_s = get32( p + SR_DRAIN_S );
+    r->fill_starts = get32( p + SR_FILL_STARTS );
+    r->drain_starts = get32( p + SR_DRAIN_STARTS );
+    r->boots = get32( p + SR_BOOTS );
+    r->powered_min = get32( p + SR_POWERED_MIN );
+    return( best );
+}
+
+void stats_print( const stats_rec_t *r ) {
+
+    if( r->slot < 0 ) {
+        printf( "no valid record\n" );
+        return;
+    }
+    printf( "record %u in slot %d\n", r->seq, r->slot );
+    printf( "  fill pump   %10.2f h  %8lu starts\n", r->fill_s / 3600.0, r->fill_starts );
+    printf( "  drain pump  %10.2f h  %8lu starts\n", r->drain_s / 3600.0, r->drain_starts );
+    printf( "  powered     %10.2f h  %8lu resets\n", r->powered_min / 60.0, r->boots );
+}
@@ -0,0 +1,37 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                      Statistics Log Image Reader                                    //
+//                                                                                                     //
+//                                                                                                     //
+// File              : statsimg.h                                                                      //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef STATSIMG_H
+#define STATSIMG_H
+
+#include "../stats.h"
+
+#define STATS_IMAGE_SIZE        ( STATS_SEGS * STATS_SEG_SIZE )
+
+typedef struct {
+    int             slot;                   // -1 when the log holds no valid record
+    unsigned int    seq;
+    unsigned long   fill_s, drain_s;
+    unsigned long   fill_starts, drain_starts;
+    unsigned long   boots, powered_min;
+} stats_rec_t;
+
+int stats_slot_state( const unsigned char *img, int slot );
+int stats_latest( const unsigned char *img, stats_rec_t *r );
+void stats_print( const stats_rec_t *r );
+
+#define STATS_SLOT_BLANK        0
+#define STATS_SLOT_VALID        1
+#define STATS_SLOT_TORN         2
+
+#endif
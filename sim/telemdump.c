@@ -0,0 +1,62 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                       Telemetry Stream Decoder                                      //
+//                                                                                                     //
+//                                                                                                     //
+// File              : telemdump.c                                                                     //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Prints each frame of a telemetry stream (see telem.h), one line per frame, then a count of good     //
+// frames, CRC failures and bytes skipped while hunting for a frame start.  The stream is raw bytes    //
+// as written by lwcsim -U or captured from the board's TX pin at 9600 8N1, e.g.                       //
+//                                                                                                     //
+//   stty -F /dev/ttyUSB0 9600 raw && telemdump /dev/ttyUSB0                                           //
+//                                                                                                     //
+// Usage: telemdump [-q] [file]      -q prints the counts only                                         //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <string.h>
+
+#include "telemparse.h"
+
+int main( int argc, char **argv ) {
+
+    telem_parser_t p;
+    telem_frame_t fr;
+    const char *path = 0;
+    int quiet = 0, a, c;
+    FILE *f = stdin;
+
+    for( a = 1; a < argc; a++ ) {
+        if( !strcmp( argv[ a ], "-q" ) ) quiet = 1;
+        else if( argv[ a ][ 0 ] != '-' && !path ) path = argv[ a ];
+        else {
+            fprintf( stderr, "usage: %s [-q] [file]\n", argv[ 0 ] );
+            return( 2 );
+        }
+    }
+    if( path && !( f = fopen( path, "rb" ) ) ) {
+        perror( path );
+        return( 1 );
+    }
+
+    telem_parser_init( &p );
+    while( ( c = getc( f ) ) != EOF ) {
+        if( telem_parse( &p, ( unsigned char )c, &fr ) && !quiet ) {
+            telem_print( &fr );
+            fflush( stdout );
+        }
+    }
+    if( f != stdin ) fclose( f );
+
+    printf( "# %lu frames, %lu bad CRC, %lu bytes skipped, %u bytes left over\n",
+            p.frames, p.bad_crc, p.skipped, p.n );
+    return( p.bad_crc || p.skipped ? 1 : 0 );
+}
@@ -0,0 +1,196 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                       Telemetry Loopback Check                                      //
+//                                                                                                     //
+//                                                                                                     //
+// File              : telemloop.c                                                                     //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs the firmware on the default plant with the simulated UART wired to the host parser and checks  //
+// every frame against what the simulator saw on the pins when the frame was built:                    //
+//                                                                                                     //
+//   - no CRC failures, no skipped bytes and no sequence gaps                                          //
+//   - one frame per TELEM_MS and none dropped by TelemSend                                            //
+//   - the fill and drain flags match the frame's well's relays, and the float flag the float LED      //
+//   - the uptime matches the simulated clock                                                          //
+//                                                                                                     //
+// The build time is taken as one character before the first byte finished, the character time being   //
+// the gap between the first two bytes.  The captured stream is then fed again with bytes dropped and  //
+// flipped, and the parser must lose only the frames that were hit.  Exits 1 on any failure.           //
+//                                                                                                     //
+// Usage: telemloop [hours]                                                                            //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../telem.h"
+#include "sim.h"
+#include "telemparse.h"
+
+int lwc_main( void );
+
+#ifdef LWC_TELEMETRY
+
+#define HIST                    8               // output changes kept per signal
+#define MAX_STREAM              ( 1 << 22 )
+
+static const sim_plant_t plant = { 0.0, 40000.0, 450.0, 900.0, 30000.0, 500.0 };
+
+static struct {
+    sim_time_t      t[ HIST ];
+    int             on[ HIST ];
+    unsigned int    n;
+} hist[ SIM_NSIG ];
+
+static telem_parser_t parser;
+static sim_time_t first_t, second_t;
+static unsigned char *stream;
+static unsigned long stream_len, frames, failures, last_seq = 0x100;
+
+static void fail( const telem_frame_t *f, const char *what ) {
+
+    if( ++failures <= 10 ) printf( "  frame #%u at %lu s: %s\n", f->seq, f->uptime, what );
+}
+
+static void on_output( sim_time_t t, int sig, int on ) {
+
+    unsigned int k = hist[ sig ].n++ % HIST;
+
+    hist[ sig ].t[ k ] = t;
+    hist[ sig ].on[ k ] = on;
+}
+
+// Level of a signal at time t, from the last HIST changes
+static int level_at( int sig, sim_time_t t ) {
+
+    unsigned int k, n = hist[ sig ].n;
+
+    for( k = n; k > 0 && k + HIST > n; k-- ) {
+        if( hist[ sig ].t[ ( k - 1 ) % HIST ] <= t ) return( hist[ sig ].on[ ( k - 1 ) % HIST ] );
+    }
+    return( n > HIST ? -1 : 0 );
+}
+
+static void check( const telem_frame_t *f ) {
+
+    sim_time_t built = first_t - ( second_t - first_t );
+    int fill, drain, led = level_at( SIM_SIG_FLOAT_LED, built );
+    unsigned long secs = ( unsigned long )( built / SIM_HZ );
+
+    if( last_seq < 0x100 && f->seq != ( ( last_seq + 1 ) & 0xFF ) ) fail( f, "sequence gap" );
+    last_seq = f->seq;
+
+    if( f->well >= SIM_WELLS ) {
+        fail( f, "bad well" );
+        return;
+    }
+    fill = level_at( SIM_SIG_WFILL( f->well ), built );
+    drain = level_at( SIM_SIG_WDRAIN( f->well ), built );
+
+    if( fill < 0 || drain < 0 || led < 0 ) fail( f, "pin history too short" );
+    if( fill != !!( f->flags & TFL_FILL ) ) fail( f, "fill flag does not match the relay" );
+    if( drain != !!( f->flags & TFL_DRAIN ) ) fail( f, "drain flag does not match the relay" );
+    if( !( f->flags & TFL_FLOAT_UNKNOWN ) && led == !!( f->flags & TFL_FLOAT_FULL ) ) {
+        fail( f, "float flag does not match the float LED" );
+    }
+    if( f->uptime != secs ) fail( f, "uptime does not match the clock" );
+    if( f->state > 5 ) fail( f, "bad LiveWellState" );
+}
+
+static void on_uart( sim_time_t t, unsigned char c ) {
+
+    telem_frame_t f;
+
+    if( stream_len < MAX_STREAM ) stream[ stream_len++ ] = c;
+
+    if( parser.n == 0 && c == TELEM_SYNC ) first_t = t;
+    if( parser.n == 1 ) second_t = t;
+    if( telem_parse( &parser, c, &f ) ) {
+        frames++;
+        check( &f );
+    }
+}
+
+// Feeds the captured stream again with one byte dropped or flipped every `every` bytes
+static int damaged( unsigned long every ) {
+
+    telem_parser_t p;
+    telem_frame_t f;
+    unsigned long k, hit = 0;
+    unsigned char c;
+
+    telem_parser_init( &p );
+    for( k = 0; k < stream_len; k++ ) {
+        c = stream[ k ];
+        if( k % every == every / 2 ) {
+            hit++;
+            if( hit & 1 ) continue;
+            c ^= 0x10;
+        }
+        telem_parse( &p, c, &f );
+    }
+    printf( "  %lu bytes hit: %lu of %lu frames kept, %lu bad CRC, %lu bytes skipped\n",
+            hit, p.frames, frames, p.bad_crc, p.skipped );
+
+    // A hit costs the frame it lands in, and at most the one after while the parser resyncs
+    return( p.frames + 2 * hit < frames );
+}
+
+int main( int argc, char **argv ) {
+
+    double hours = argc > 1 ? atof( argv[ 1 ] ) : 6.0;
+    const sim_stats_t *s;
+    unsigned long expect;
+
+    if( !( stream = malloc( MAX_STREAM ) ) ) return( 1 );
+
+    sim_reset( );
+    sim_set_plant( &plant );
+    sim_add_input( 0, SIM_IN_POT, SIM_POT_INTERVAL, 300 );
+    sim_add_input( 0, SIM_IN_POT, SIM_POT_DURATION, 200 );
+    sim_add_input( 0, SIM_IN_POT, SIM_POT_DRAIN, 512 );
+    sim_add_input( ( sim_time_t )( hours * 1800.0 * SIM_HZ ), SIM_IN_POT, SIM_POT_DURATION, 700 );
+    sim_set_output_hook( on_output );
+    sim_set_uart_hook( on_uart );
+    telem_parser_init( &parser );
+
+    sim_run( lwc_main, ( sim_time_t )( hours * 3600.0 * SIM_HZ ) );
+    s = sim_stats( );
+
+    expect = ( unsigned long )( s->run_time / ( TELEM_MS * SIM_MS ) );
+    printf( "telemloop: %.1f h, %lu frames (%lu expected), %llu bytes, %lu bad CRC, %lu bytes skipped,"
+            " %u dropped\n", hours, frames, expect, s->uart_bytes, parser.bad_crc, parser.skipped, TelemDropped );
+
+    if( parser.bad_crc || parser.skipped ) failures++;
+    if( TelemDropped ) failures++;
+    if( frames + 2 < expect || frames > expect ) {
+        printf( "  frame count is off\n" );
+        failures++;
+    }
+    if( damaged( 997 ) ) {
+        printf( "  parser lost more than the damaged frames\n" );
+        failures++;
+    }
+
+    printf( "telemloop: %s\n", failures ? "FAILED" : "ok" );
+    free( stream );
+    return( failures ? 1 : 0 );
+}
+
+#else
+
+int main( void ) {
+
+    printf( "telemloop: built without LWC_TELEMETRY, nothing to check\n" );
+    return( 0 );
+}
+
+#endif
@@ -0,0 +1,133 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                       Telemetry Frame Parser                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : telemparse.c                                                                    //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Byte-at-a-time decoder for the frames telem.c sends.  It hunts for TELEM_SYNC, then takes the       //
+// length and the rest of the frame; a wrong length or CRC drops the sync byte and searches the bytes  //
+// already buffered, so a frame that starts inside a damaged one is still found.                       //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <string.h>
+
+#include "telemparse.h"
+
+static const char * const state_names[] = {
+    "ALL_STOP", "RAISE_LEVEL", "AERATE", "RAISE_LEVEL_IN_DURATION", "LOWER_LEVEL", "RAISE_LEVEL_B4_ALL_STOP"
+};
+
+static unsigned int crc16( unsigned int crc, unsigned char b ) {
+
+    unsigned int x = ( ( crc >> 8 ) ^ b ) & 0xFF;
+
+    x ^= x >> 4;
+    return( ( ( crc << 8 ) ^ ( x << 12 ) ^ ( x << 5 ) ^ x ) & 0xFFFF );
+}
+
+static unsigned long field( const unsigned char *pl, int at, int bytes ) {
+
+    unsigned long v = 0;
+
+    while( bytes-- ) v = ( v << 8 ) | pl[ at + bytes ];
+    return( v );
+}
+
+void telem_parser_init( telem_parser_t *p ) {
+
+    memset( p, 0, sizeof( *p ) );
+}
+
+// Drops buf[ 0 ] and keeps whatever follows from the next TELEM_SYNC on
+static void resync( telem_parser_t *p ) {
+
+    unsigned int k;
+
+    for( k = 1; k < p->n && p->buf[ k ] != TELEM_SYNC; k++ );
+    p->skipped += k;
+    memmove( p->buf, p->buf + k, p->n - k );
+    p->n -= k;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Feeds one received byte to the parser.                                                 //
+// Arguments:   p - parser, c - the byte, f - filled in when a frame completes                         //
+// Returns:     1 when f holds a new frame, else 0                                                     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int telem_parse( telem_parser_t *p, unsigned char c, telem_frame_t *f ) {
+
+    const unsigned char *pl;
+    unsigned int crc, k;
+
+    if( !p->n && c != TELEM_SYNC ) {
+        p->skipped++;
+        return( 0 );
+    }
+    p->buf[ p->n++ ] = c;
+
+    for( ;; ) {
+        if( p->n >= 2 && p->buf[ 1 ] != TELEM_LEN ) {
+            resync( p );
+            continue;
+        }
+        if( p->n < TELEM_FRAME ) return( 0 );
+
+        for( crc = 0xFFFF, k = 1; k < TELEM_FRAME - 2; k++ ) crc = crc16( crc, p->buf[ k ] );
+        if( crc != ( p->buf[ TELEM_FRAME - 2 ] | ( unsigned int )p->buf[ TELEM_FRAME - 1 ] << 8 ) ) {
+            p->bad_crc++;
+            resync( p );
+            continue;
+        }
+        break;
+    }
+
+    pl = p->buf + 2;
+    f->seq = pl[ TF_SEQ ];
+    f->pot[ 0 ] = ( unsigned int )field( pl, TF_POT_DRAIN, 2 );
+    f->pot[ 1 ] = ( unsigned int )field( pl, TF_POT_DURATION, 2 );
+    f->pot[ 2 ] = ( unsigned int )field( pl, TF_POT_INTERVAL, 2 );
+    f->interval_ms = field( pl, TF_INTERVAL_MS, 3 );
+    f->duration_ms = field( pl, TF_DURATION_MS, 3 );
+    f->drain_ms = field( pl, TF_DRAIN_MS, 2 );
+    f->well = pl[ TF_STATE ] >> TF_WELL_SHIFT;
+    f->state = pl[ TF_STATE ] & TF_STATE_MASK;
+    f->flags = pl[ TF_FLAGS ];
+    f->uptime = field( pl, TF_UPTIME, 4 );
+    f->fall_ms = ( unsigned int )field( pl, TF_FALL_MS, 2 );
+    f->fill_ms = ( unsigned int )field( pl, TF_FILL_MS, 2 );
+    f->tofull_ms = field( pl, TF_TO_FULL, 2 ) * 100;
+
+    p->n = 0;
+    p->frames++;
+    return( 1 );
+}
+
+void telem_print( const telem_frame_t *f ) {
+
+    printf( "%8lu s #%-3u well %u %-23s fill %-3s drain %-3s float %-5s%s%s  interval %6.1f s  duration %6.1f s"
+            "  drain %5.2f s  pots %4u %4u %4u  model fall %5.2f s fill %5.2f s%s%s  to full %5.1f s\n",
+            f->uptime, f->seq, f->well, f->state < 6 ? state_names[ f->state ] : "?",
+            ( f->flags & TFL_FILL ) ? "on" : "off", ( f->flags & TFL_DRAIN ) ? "on" : "off",
+            ( f->flags & TFL_FLOAT_UNKNOWN ) ? "?" : ( f->flags & TFL_FLOAT_FULL ) ? "full" : "empty",
+            ( f->flags & TFL_DRAINING ) ? "  DRAIN OVERRIDE" : "",
+            f->state == 2 ? ( ( f->flags & TFL_AERATING ) ? "  aerating" : "  resting" ) : "",
+            f->interval_ms / 1000.0, f->duration_ms / 1000.0, f->drain_ms / 1000.0,
+            f->pot[ 2 ], f->pot[ 1 ], f->pot[ 0 ], f->fall_ms / 1000.0, f->fill_ms / 1000.0,
+            ( f->flags & TFL_MODEL ) ? " ready" : "", ( f->flags & TFL_ALONE ) ? " alone" : "",
+            f->tofull_ms / 1000.0 );
+}
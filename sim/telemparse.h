@@ -0,0 +1,43 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                       Telemetry Frame Parser                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : telemparse.h                                                                    //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef TELEMPARSE_H
+#define TELEMPARSE_H
+
+#include "../telem.h"
+
+typedef struct {
+    unsigned int    seq;
+    unsigned int    pot[ 3 ];               // the well's drain pot, POT_DURATION, POT_INTERVAL order
+    unsigned long   interval_ms, duration_ms, drain_ms;
+    unsigned int    well;                   // the frame's well, they take turns
+    unsigned int    state;
+    unsigned int    flags;                  // TFL_*
+    unsigned long   uptime;                 // seconds
+    unsigned int    fall_ms, fill_ms;       // model, ms a band
+    unsigned long   tofull_ms;
+} telem_frame_t;
+
+typedef struct {
+    unsigned char   buf[ TELEM_FRAME ];
+    unsigned int    n;                      // bytes of a candidate frame held in buf
+    unsigned long   frames;                 // good frames
+    unsigned long   bad_crc;
+    unsigned long   skipped;                // bytes thrown away hunting for TELEM_SYNC
+} telem_parser_t;
+
+void telem_parser_init( telem_parser_t *p );
+int telem_parse( telem_parser_t *p, unsigned char c, telem_frame_t *f );
+void telem_print( const telem_frame_t *f );
+
+#endif
@@ -0,0 +1,201 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                          Trace Log Decoder                                          //
+//                                                                                                     //
+//                                                                                                     //
+// File              : tracedump.c                                                                     //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Turns a TraceLog image (see trace.h) into a timeline, oldest record first, with times relative to   //
+// the oldest record.  The image is raw bytes as written by lwcsim -T, or with -x a hex dump such as   //
+// mspdebug "md TraceLog 66" prints: an address up to ':' is skipped, then hex bytes are read until    //
+// anything else on the line.  The ring size is taken from the image length.                           //
+//                                                                                                     //
+// With -r it writes the float switch edges as an lwcsim script instead, for replay: the ring keeps no //
+// knob readings, so the pots are left at the script's defaults and only the floats are replayed.      //
+//                                                                                                     //
+// Usage: tracedump [-x] [-r] [file]                                                                   //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../trace.h"
+
+#define MAX_IMAGE               ( 2 + 128 * TRACE_REC )
+
+static const char * const state_names[] = {
+    "ALL_STOP", "RAISE_LEVEL", "AERATE", "RAISE_LEVEL_IN_DURATION", "LOWER_LEVEL", "RAISE_LEVEL_B4_ALL_STOP"
+};
+
+static const char * const event_names[] = {
+    "EV_FULL", "EV_EMPTY", "EV_INTERVAL", "EV_DURATION", "EV_DRAINED"
+};
+
+static const char * const relay_names[ 4 ] = { "all off", "fill", "drain", "fill + drain" };
+
+#define NAME( tab, i )          ( ( unsigned )( i ) < sizeof( tab ) / sizeof( tab[ 0 ] ) ? tab[ i ] : "?" )
+
+static size_t read_raw( FILE *f, unsigned char *buf ) {
+
+    return( fread( buf, 1, MAX_IMAGE, f ) );
+}
+
+static size_t read_hex( FILE *f, unsigned char *buf ) {
+
+    char line[ 512 ], *p, *end;
+    unsigned long v;
+    size_t n = 0;
+
+    while( n < MAX_IMAGE && fgets( line, sizeof( line ), f ) ) {
+        p = strchr( line, ':' );
+        p = p ? p + 1 : line;
+        for( ;; ) {
+            while( *p == ' ' || *p == '\t' ) p++;
+            if( !isxdigit( ( unsigned char )p[ 0 ] ) || !isxdigit( ( unsigned char )p[ 1 ] ) ) break;
+            if( p[ 2 ] && !isspace( ( unsigned char )p[ 2 ] ) ) break;
+            v = strtoul( p, &end, 16 );
+            if( n < MAX_IMAGE ) buf[ n++ ] = ( unsigned char )v;
+            p = end;
+        }
+    }
+    return( n );
+}
+
+// states holds the last state seen in each well, -1 until one is
+static void describe( const unsigned char *r, int *states ) {
+
+    unsigned char id = r[ 0 ] & TR_ID_MASK, arg = r[ 1 ], w = r[ 0 ] >> TR_WELL_SHIFT;
+    int *state = &states[ w ];
+
+    if( w && id != TR_INTERVAL && id != TR_DURATION ) printf( "well %u ", w );
+
+    switch( id ) {
+    case TR_RESET:
+        printf( "reset" );
+        for( w = 0; w < 4; w++ ) states[ w ] = 0;
+        break;
+    case TR_STATE:
+        if( *state >= 0 ) printf( "%s -> ", NAME( state_names, *state ) );
+        else printf( "-> " );
+        printf( "%s on %s", NAME( state_names, arg & 0x0F ), NAME( event_names, arg >> 4 ) );
+        *state = arg & 0x0F;
+        break;
+    case TR_RELAYS:
+        printf( "relays %s", relay_names[ arg & 3 ] );
+        break;
+    case TR_TIMEOUT:
+        printf( "TMR_PUMP posts %s", NAME( event_names, arg ) );
+        break;
+    case TR_EDGE:
+        printf( "float switch edge, now %s", arg ? "high" : "low" );
+        break;
+    case TR_FLOAT:
+        printf( "float %s", arg ? "FULL" : "EMPTY" );
+        break;
+    case TR_DRAIN:
+        printf( "drain override %s", arg ? "ON" : "off" );
+        break;
+    case TR_INTERVAL:
+        printf( "interval knob %.0f s", arg * 4.096 );
+        break;
+    case TR_DURATION:
+        printf( "duration knob %.0f s", arg * 4.096 );
+        break;
+    case TR_DRAIN_TIME:
+        printf( "drain knob %.2f s", arg * 0.064 );
+        break;
+    case TR_WARM:
+        printf( "warm restart after %s, resumes %s", ( arg >> 4 ) & 0x01 ? "watchdog" :
+                ( arg >> 4 ) & 0x08 ? "reset pin" : ( arg >> 4 ) & 0x04 ? "brownout" : "unknown reset",
+                NAME( state_names, arg & 0x0F ) );
+        *state = arg & 0x0F;
+        break;
+    case TR_FALL:
+        printf( "model fall %.2f s a band", arg * 0.064 );
+        break;
+    case TR_FILL:
+        printf( "model fill %.2f s a band", arg * 0.064 );
+        break;
+    case TR_TO_FULL:
+        printf( "full after %u s%s", arg, arg == 255 ? " or more" : "" );
+        break;
+    case TR_STACK:
+        printf( "stack down to %u bytes%s", arg * 2, arg == 255 ? " or more" : "" );
+        break;
+    case TR_SLOSH:
+        printf( "float chattered, model unused for %u exchanges", arg );
+        break;
+    default:
+        printf( "unknown id %u arg %u", id, arg );
+        break;
+    }
+}
+
+int main( int argc, char **argv ) {
+
+    unsigned char img[ MAX_IMAGE ];
+    const unsigned char *r;
+    const char *path = 0;
+    unsigned int len, head, count, k, dt;
+    unsigned long long t = 0, gap = 0;
+    int hex = 0, rec = 0, state[ 4 ] = { -1, -1, -1, -1 }, shown = 0, a;
+    size_t n;
+    FILE *f = stdin;
+
+    for( a = 1; a < argc; a++ ) {
+        if( !strcmp( argv[ a ], "-x" ) ) hex = 1;
+        else if( !strcmp( argv[ a ], "-r" ) ) rec = 1;
+        else if( argv[ a ][ 0 ] != '-' && !path ) path = argv[ a ];
+        else {
+            fprintf( stderr, "usage: %s [-x] [-r] [file]\n", argv[ 0 ] );
+            return( 2 );
+        }
+    }
+    if( path && !( f = fopen( path, hex ? "r" : "rb" ) ) ) {
+        perror( path );
+        return( 1 );
+    }
+    n = hex ? read_hex( f, img ) : read_raw( f, img );
+    if( f != stdin ) fclose( f );
+
+    len = n >= 2 ? ( unsigned int )( n - 2 ) / TRACE_REC : 0;
+    if( !len || ( len & ( len - 1 ) ) || img[ 0 ] >= len || img[ 1 ] > len ) {
+        fprintf( stderr, "not a TraceLog image (%lu bytes)\n", ( unsigned long )n );
+        return( 1 );
+    }
+    head = img[ 0 ];
+    count = img[ 1 ];
+
+    if( rec ) printf( "#\n# Float edges of a TraceLog, %u of %u records, times from the oldest.\n#\nnoplant\n", count, len );
+    else printf( "%u of %u records, times from the oldest, 1/1024 s resolution\n", count, len );
+    for( k = 0; k < count; k++ ) {
+        r = img + 2 + ( ( head + len - count + k ) % len ) * TRACE_REC;
+        dt = r[ 2 ] | ( r[ 3 ] << 8 );
+
+        if( r[ 0 ] == TR_TIME ) {
+            gap += ( ( unsigned long long )r[ 1 ] << 16 ) | dt;
+            continue;
+        }
+        if( shown++ ) t += gap + dt;
+        gap = 0;
+
+        if( rec ) {
+            if( ( r[ 0 ] & TR_ID_MASK ) != TR_EDGE ) continue;
+            printf( "at %.3f well %u float %s\n", t * 1000.0 / 1024.0, r[ 0 ] >> TR_WELL_SHIFT, r[ 1 ] ? "full" : "empty" );
+            continue;
+        }
+        printf( "%12.3f s  ", t / 1024.0 );
+        describe( r, state );
+        printf( "\n" );
+    }
+    return( 0 );
+}
@@ -0,0 +1,185 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                   Live Well Controller Simulator                                    //
+//                                                                                                     //
+//                                          Well Count Bench                                           //
+//                                                                                                     //
+//                                                                                                     //
+// File              : wellbench.c                                                                     //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Runs one scenario through lwcsim and lwcsim-w2 .. lwcsim-w4, the firmware built for one to four     //
+// wells, and shows what each well costs: LPM wakes and interrupts an hour, CPU time, and the          //
+// firmware's RAM, then the same over the one-well build divided by the wells added.  The RAM is the   //
+// G2553's, as memreport -T sizes each build's objects.                                                //
+//                                                                                                     //
+// Exits 1 if a build fails to run, if well 0 does not pump the same on every build, as the other      //
+// wells must not change it, if a well never starts its pumps, or if a build takes more RAM than       //
+// WELL_RAM allows it.  wells.h stops a firmware build whose wells won't fit on that figure.           //
+//                                                                                                     //
+// Usage: wellbench [scenario], scenarios/wells.txt by default                                         //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../wells.h"
+
+#define MAX_WELLS               4
+#define MAX_DRIFT_S             1.0             // well 0's pump time may differ by rounding only
+#define DRIFT( x, y )           ( ( x ) - ( y ) > MAX_DRIFT_S || ( y ) - ( x ) > MAX_DRIFT_S )
+#define LEAN_RAM( n )           ( WELL_ONE_BASE + ( ( n ) - 1 ) * WELL_EACH_BASE )     // WELL_RAM, every option out
+
+static const char * const sims[ MAX_WELLS ] = { "lwcsim", "lwcsim-w2", "lwcsim-w3", "lwcsim-w4" };
+static const char * const objs[ MAX_WELLS ] = { "fw_*.o", "w2_fw_*.o", "w3_fw_*.o", "w4_fw_*.o" };
+
+typedef struct {
+    double          hours;
+    unsigned long   wakes, isrs;
+    double          cpu_s;
+    unsigned long   ram;                        // data + bss + noinit, on the G2553
+    unsigned long   starts[ MAX_WELLS ];        // fill and drain together
+    double          fill_s, drain_s;            // well 0's
+} result_t;
+
+// Adds up the "Name count" pairs of the interrupts line
+static unsigned long count_isrs( const char *p ) {
+
+    unsigned long n = 0;
+    char *end;
+
+    while( ( p = strpbrk( p, "0123456789" ) ) ) {
+        if( p[ -1 ] != ' ' ) {                  // a digit in a vector name, Timer0_A0
+            while( *p >= '0' && *p <= '9' ) p++;
+            continue;
+        }
+        n += strtoul( p, &end, 10 );
+        p = end;
+    }
+    return( n );
+}
+
+// Runs one simulator on the scenario and picks its summary lines apart
+static int run( const char *sim, const char *scenario, result_t *r ) {
+
+    char cmd[ 512 ], line[ 256 ];
+    unsigned long fs, ds;
+    double f, d;
+    FILE *p;
+    int w, found = 0;
+
+    memset( r, 0, sizeof( *r ) );
+    snprintf( cmd, sizeof( cmd ), "./%s -q -f %s", sim, scenario );
+    if( !( p = popen( cmd, "r" ) ) ) {
+        perror( sim );
+        return( -1 );
+    }
+    while( fgets( line, sizeof( line ), p ) ) {
+        if( sscanf( line, "# simulated %lf h", &r->hours ) == 1 ) found |= 1;
+        if( sscanf( line, "# main loop %lu LPM wakes", &r->wakes ) == 1 ) found |= 2;
+        if( !strncmp( line, "# interrupts", 12 ) ) {
+            r->isrs = count_isrs( line + 12 );
+            found |= 4;
+        }
+        if( sscanf( line, "# cpu %*f%% active (%lf s)", &r->cpu_s ) == 1 ) found |= 8;
+        if( sscanf( line, "# fill pump %lu starts, %lf s on", &fs, &r->fill_s ) == 2 ) r->starts[ 0 ] += fs;
+        if( sscanf( line, "# drain pump %lu starts, %lf s on", &ds, &r->drain_s ) == 2 ) r->starts[ 0 ] += ds;
+        if( sscanf( line, "# well %d pumps fill %lu starts, %lf s on, drain %lu starts, %lf s on", &w, &fs, &f,
+                    &ds, &d ) == 5 && w > 0 && w < MAX_WELLS ) {
+            r->starts[ w ] = fs + ds;
+        }
+    }
+    if( pclose( p ) || found != 15 || r->hours <= 0.0 ) {
+        fprintf( stderr, "wellbench: %s did not run %s\n", sim, scenario );
+        return( -1 );
+    }
+    return( 0 );
+}
+
+// Sizes one build's firmware objects for the G2553
+static int ram( const char *obj, result_t *r ) {
+
+    char cmd[ 256 ], line[ 256 ];
+    unsigned long data;
+    FILE *p;
+
+    snprintf( cmd, sizeof( cmd ), "./memreport -T %s", obj );
+    if( !( p = popen( cmd, "r" ) ) ) {
+        perror( "memreport" );
+        return( -1 );
+    }
+    while( fgets( line, sizeof( line ), p ) ) {
+        if( sscanf( line, "memreport: ram %lu bytes: %lu data", &r->ram, &data ) == 2 ) break;
+    }
+    while( fgets( line, sizeof( line ), p ) );
+    if( pclose( p ) || !r->ram ) {
+        fprintf( stderr, "wellbench: memreport could not size %s\n", obj );
+        return( -1 );
+    }
+    return( 0 );
+}
+
+int main( int argc, char **argv ) {
+
+    const char *scenario = argc > 1 ? argv[ 1 ] : "scenarios/wells.txt";
+    result_t r[ MAX_WELLS ], *a, *b = &r[ 0 ];
+    double run_s;
+    int n, w, failures = 0;
+
+    printf( "wellbench: %s\n", scenario );
+    printf( "wellbench: %5s %10s %10s %8s %8s  %10s %10s %8s %8s\n", "wells", "wakes/h", "ISRs/h", "cpu %",
+            "ram", "+wakes/h", "+ISRs/h", "+cpu %", "+ram" );
+    printf( "wellbench: %5s %10s %10s %8s %8s  %39s\n", "", "", "", "", "", "each well over one" );
+
+    for( n = 1; n <= MAX_WELLS; n++ ) {
+        if( run( sims[ n - 1 ], scenario, &r[ n - 1 ] ) || ram( objs[ n - 1 ], &r[ n - 1 ] ) ) {
+            failures++;
+            if( n == 1 ) break;
+            continue;
+        }
+
+        a = &r[ n - 1 ];
+        run_s = a->hours * 3600.0;
+
+        printf( "wellbench: %5d %10.0f %10.0f %8.3f %8lu", n, a->wakes / a->hours, a->isrs / a->hours,
+                100.0 * a->cpu_s / run_s, a->ram );
+        if( n > 1 ) {
+            printf( "  %10.0f %10.0f %8.3f %8.0f", ( ( double )a->wakes - b->wakes ) / a->hours / ( n - 1 ),
+                    ( ( double )a->isrs - b->isrs ) / a->hours / ( n - 1 ),
+                    100.0 * ( a->cpu_s - b->cpu_s ) / run_s / ( n - 1 ), ( ( double )a->ram - b->ram ) / ( n - 1 ) );
+        }
+        printf( "\n" );
+
+        if( n > 1 && ( a->starts[ 0 ] != b->starts[ 0 ] || DRIFT( a->fill_s, b->fill_s ) ||
+                       DRIFT( a->drain_s, b->drain_s ) ) ) {
+            printf( "  %s: well 0 pumped %lu starts, %.1f/%.1f s, one well %lu starts, %.1f/%.1f s\n", sims[ n - 1 ],
+                    a->starts[ 0 ], a->fill_s, a->drain_s, b->starts[ 0 ], b->fill_s, b->drain_s );
+            failures++;
+        }
+        for( w = 0; w < n; w++ ) {
+            if( a->starts[ w ] ) continue;
+            printf( "  %s: well %d never started a pump\n", sims[ n - 1 ], w );
+            failures++;
+        }
+        if( a->ram > ( unsigned long )WELL_RAM( n ) ) {
+            printf( "  %s: %lu bytes of RAM, over the %d WELL_RAM allows %d wells\n", sims[ n - 1 ], a->ram,
+                    WELL_RAM( n ), n );
+            failures++;
+        }
+    }
+
+    for( n = MAX_WELLS; n > 1 && WELL_RAM( n ) + WELL_STACK_BYTES > LWC_RAM_BYTES; n-- );
+    printf( "wellbench: ram sized for the G2553; %d well%s its %d bytes with a %d byte stack\n", n,
+            n > 1 ? "s fit" : " fits", LWC_RAM_BYTES, WELL_STACK_BYTES );
+    for( n = MAX_WELLS; n > 1 && LEAN_RAM( n ) + WELL_STACK_BASE > LWC_RAM_BYTES; n-- );
+    printf( "wellbench: %d well%s with LWC_NO_TRACE, LWC_NO_WARM and LWC_NO_STATS (bench sizes two)\n", n,
+            n > 1 ? "s fit" : " fits" );
+
+    printf( "wellbench: %s\n", failures ? "FAILED" : "ok" );
+    return( failures ? 1 : 0 );
+}
@@ -0,0 +1,117 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                        Stack High-Water Mark                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : stack.c                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// The stack shares the G2553's 512 bytes with everything else and grows down towards the variables.   //
+// At startup StackPaint fills the free RAM between them with STACK_PAINT; the lowest word that no     //
+// longer holds it is as deep as the stack has been.  StackCheck looks at STACK_SLICE words a main     //
+// loop pass, from the bottom up to the mark so far, so a full sweep is spread over a few dozen passes //
+// and never holds the loop up.  A deeper mark is kept in StackMax and traced as TR_STACK; a debugger  //
+// reads StackMax, or calls StackUsed for a sweep there and then.                                      //
+//                                                                                                     //
+// The simulator gives the firmware a block of its own to paint (see hal.h), which the host's stack    //
+// never touches, so there the mark stays where StackPaint found the stack pointer.                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "hal.h"
+#include "stack.h"
+#include "trace.h"
+
+unsigned int StackMax;
+
+static unsigned int *StackMark;                 // lowest word found changed
+static unsigned int *StackCursor;               // next word StackCheck looks at
+
+// A word at p has been overwritten: p is the new mark
+static void StackDeeper( unsigned int *p ) {
+
+    StackMark = p;
+    StackMax = ( unsigned int )( ( char * )HAL_STACK_TOP - ( char * )p );
+    TRACE( TR_STACK, StackMax >> 1 > 255 ? 255 : StackMax >> 1 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Paints the free RAM below the stack pointer.                                           //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Call first thing in main, with interrupts off.  About 1.5 ms at 1 MHz.      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void StackPaint( void ) {
+
+    unsigned int *p, *sp = HAL_SP( );
+
+    for( p = HAL_STACK_LOW; p < sp; p++ ) *p = STACK_PAINT;
+
+    StackMark = sp;
+    StackCursor = HAL_STACK_LOW;
+    StackMax = ( unsigned int )( ( char * )HAL_STACK_TOP - ( char * )sp );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Looks at the next STACK_SLICE painted words for the stack having gone deeper.          //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Called at the end of every main loop pass.                                  //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void StackCheck( void ) {
+
+    unsigned char k;
+
+    for( k = 0; k < STACK_SLICE && StackCursor < StackMark; k++, StackCursor++ ) {
+        if( *StackCursor != STACK_PAINT ) {
+            StackDeeper( StackCursor );
+            break;
+        }
+    }
+    if( StackCursor >= StackMark ) StackCursor = HAL_STACK_LOW;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Sweeps all the painted words at once.                                                  //
+// Arguments:   None                                                                                   //
+// Returns:     StackMax, brought up to date                                                           //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Up to a few ms; for a debugger or a bench, not the main loop.               //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned int StackUsed( void ) {
+
+    unsigned int *p;
+
+    for( p = HAL_STACK_LOW; p < StackMark; p++ ) {
+        if( *p != STACK_PAINT ) {
+            StackDeeper( p );
+            break;
+        }
+    }
+    return( StackMax );
+}
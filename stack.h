@@ -0,0 +1,26 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                        Stack High-Water Mark                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : stack.h                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef STACK_H
+#define STACK_H
+
+#define STACK_PAINT                 0x5AA5      // free RAM holds this until the stack reaches it
+#define STACK_SLICE                 8           // words StackCheck looks at in a call
+
+extern unsigned int StackMax;                   // deepest the stack has gone, bytes below the top of RAM
+
+void StackPaint( void );
+void StackCheck( void );
+unsigned int StackUsed( void );
+
+#endif
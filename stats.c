@@ -0,0 +1,287 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Pump Statistics Log                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : stats.c                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Lifetime pump hours and relay cycles, kept in information flash so they survive a power cycle.      //
+//                                                                                                     //
+// The relay stage reports every switching to StatsRelays, which only adds to RAM.  With more than one //
+// well the counters are the totals over all of them: fill pump hours are every fill pump's.  Every    //
+// STATS_COMMIT_MIN the main loop appends one record holding the running totals to the next slot of    //
+// the ring in segments D, C and B; nothing is ever rewritten in place.  When the next slot is not     //
+// blank, its segment is erased first, on its own loop pass, so no pass stalls for more than one       //
+// erase (about 15 ms) and pump events wait at most that long.  Each segment is erased once per        //
+// STATS_SLOTS commits.                                                                                //
+//                                                                                                     //
+// A record is programmed payload first, then its check word, then its sequence number, so a record    //
+// cut short by a power loss either stays blank in SR_SEQ or fails the check.  At reset StatsInit      //
+// takes the valid record with the highest sequence number; the segment being erased never holds it.   //
+//                                                                                                     //
+// Build with LWC_NO_STATS to compile it all out, and the RAM its counters take with it (see wells.h). //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "sched.h"
+#include "stats.h"
+
+#ifndef LWC_NO_STATS
+
+#if STATS_SLOTS < 2 * STATS_SEGS || STATS_SEG_SIZE % STATS_REC_SIZE
+#error Stats records must fit a segment a whole number of times, at least twice
+#endif
+
+#define STATS_PERIOD                ( ( TBTICKS )STATS_COMMIT_MIN * 60 * TB_HZ )
+#define SLOT_ADDR( s )              ( STATS_BASE + ( s ) * STATS_REC_SIZE )
+#define SLOT_SEG( s )               ( ( s ) / ( STATS_SEG_SIZE / STATS_REC_SIZE ) )
+
+static unsigned char StatsLast;                 // slot of the newest record, 0xFF if none
+static unsigned char StatsPending;              // a pump ran or the MCU reset since the last commit
+static unsigned char StatsBoot;                 // the reset is not counted in flash yet
+static unsigned char StatsOn[ LWC_WELLS ];      // relays on per well, fill | drain << 1
+static unsigned int StatsStarts[ 2 ];           // fill, drain starts not yet committed
+static unsigned long StatsRun[ 2 ];             // ACLK ticks on not yet committed
+static TBTICKS StatsSince[ LWC_WELLS ][ 2 ];                // clock when the relay came on
+static unsigned long StatsUpS;                  // seconds powered already in flash
+
+static unsigned int Get16( const unsigned char *p ) {
+
+    return( p[ 0 ] | ( ( unsigned int )p[ 1 ] << 8 ) );
+}
+
+static unsigned long Get32( const unsigned char *p ) {
+
+    return( Get16( p ) | ( ( unsigned long )Get16( p + 2 ) << 16 ) );
+}
+
+// ~( sum of every word but SR_CHECK ), so the sequence number is covered too
+static unsigned int Check( const unsigned char *r ) {
+
+    unsigned int sum = Get16( r + SR_SEQ ), k;
+
+    for( k = SR_FILL_S; k < STATS_REC_SIZE; k += 2 ) sum += Get16( r + k );
+    return( ~sum & 0xFFFF );
+}
+
+// Counter k of STATS_COUNTERS gathered since the last commit, mins the minutes powered
+static unsigned long StatsCount( unsigned char k, unsigned long mins ) {
+
+    if( k < 2 ) return( StatsRun[ k ] >> 15 );
+    if( k < 4 ) return( StatsStarts[ k - 2 ] );
+    if( k == 4 ) return( StatsBoot );
+    return( mins );
+}
+
+static int Blank( unsigned char slot ) {
+
+    const unsigned char *r = HAL_INFO( SLOT_ADDR( slot ) );
+    unsigned char k;
+
+    for( k = 0; k < STATS_REC_SIZE; k++ ) if( r[ k ] != 0xFF ) return( 0 );
+    return( 1 );
+}
+
+static int Valid( unsigned char slot ) {
+
+    const unsigned char *r = HAL_INFO( SLOT_ADDR( slot ) );
+
+    return( Get16( r + SR_SEQ ) != 0xFFFF && Get16( r + SR_CHECK ) == Check( r ) );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: One flash operation: erases the segment holding addr, or programs a word there.        //
+// Arguments:   mode - ERASE or WRT, addr - target, w - word to program                                //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: The CPU is held until the flash is done: about 90 us for a word, 15 ms for  //
+//                         an erase.  Interrupts are off meanwhile, their flags wait.                  //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static void FlashOp( unsigned int mode, unsigned int addr, unsigned int w ) {
+
+    unsigned int sr = __get_SR_register( );
+
+    __disable_interrupt( );
+
+    FCTL3 = FWKEY;                              // clear LOCK
+    FCTL1 = FWKEY + mode;
+    HAL_FLASH_WORD( addr, w );                  // a dummy write starts an erase
+    FCTL1 = FWKEY;
+    FCTL3 = FWKEY + LOCK;
+
+    if( sr & GIE ) __enable_interrupt( );
+}
+
+static void StatsTick( TBTICKS now ) {
+
+    WakeEvents |= WAKE_STATS;
+    SchedArm( TMR_STATS, now + STATS_PERIOD, StatsTick );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Finds the newest record, counts the reset and starts the commit timer.                 //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Call after TimebaseInit, with the relays off.  Slots that are neither       //
+//                         blank nor valid were cut short and are left for the next erase.             //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void StatsInit( void ) {
+
+    unsigned int seq, best = 0;
+    unsigned char s;
+
+    FCTL2 = FWKEY + FSSEL_1 + FN1;              // MCLK / 3 = 333 kHz, inside 257 to 476 kHz
+
+    StatsLast = 0xFF;
+    for( s = 0; s < LWC_WELLS; s++ ) StatsOn[ s ] = 0;
+    StatsStarts[ 0 ] = StatsStarts[ 1 ] = 0;
+    StatsRun[ 0 ] = StatsRun[ 1 ] = 0;
+
+    for( s = 0; s < STATS_SLOTS; s++ ) {
+        if( !Valid( s ) ) continue;
+        seq = Get16( HAL_INFO( SLOT_ADDR( s ) ) + SR_SEQ );
+        if( StatsLast == 0xFF || ( ( seq - best ) & 0x8000 ) == 0 ) {
+            StatsLast = s;
+            best = seq;
+        }
+    }
+
+    StatsBoot = StatsPending = 1;
+    StatsUpS = TimeSeconds();
+
+    SchedArm( TMR_STATS, TimeTicks() + STATS_PERIOD, StatsTick );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Counts relay starts and on-time.                                                       //
+// Arguments:   w      - well                                                                          //
+//              relays - its fill on | drain on << 1, as now driven                                    //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Called on every relay write; repeating the current state costs nothing.     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void StatsRelays( unsigned char w, unsigned char relays ) {
+
+    unsigned char changed = relays ^ StatsOn[ w ], p;
+    TBTICKS now;
+
+    if( !changed ) return;
+    now = TimeTicks();
+
+    for( p = 0; p < 2; p++ ) {
+        if( !( changed & ( 1 << p ) ) ) continue;
+        if( relays & ( 1 << p ) ) {
+            StatsStarts[ p ]++;
+            StatsSince[ w ][ p ] = now;
+        } else {
+            StatsRun[ p ] += now - StatsSince[ w ][ p ];
+        }
+    }
+    StatsOn[ w ] = relays;
+    StatsPending = 1;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Appends the running totals to the log.                                                 //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Main loop only, on WAKE_STATS.  If the next slot's segment must be erased   //
+//                         first, this pass only erases and posts WAKE_STATS again for the write.      //
+//                         Each counter goes to flash as it is summed, with the check word kept as it  //
+//                         goes, so the record is never built on the stack.                            //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void StatsCommit( void ) {
+
+    unsigned char slot, on, w, p, k;
+    const unsigned char *last = 0;
+    unsigned long v, mins;
+    unsigned int seq, sum;
+    TBTICKS now;
+
+    if( !StatsPending ) return;
+
+    slot = StatsLast == 0xFF ? 0 : ( StatsLast + 1 ) % STATS_SLOTS;
+    if( !Blank( slot ) ) {
+        if( StatsLast != 0xFF && SLOT_SEG( slot ) == SLOT_SEG( StatsLast ) ) {
+            slot = ( SLOT_SEG( slot ) + 1 ) % STATS_SEGS * ( STATS_SEG_SIZE / STATS_REC_SIZE );
+        }
+        if( !Blank( slot ) ) {
+            FlashOp( ERASE, SLOT_ADDR( slot ), 0 );
+            __disable_interrupt( );
+            WakeEvents |= WAKE_STATS;
+            __enable_interrupt( );
+            return;
+        }
+    }
+
+    // Close the on-time of relays still on
+    now = TimeTicks();
+    on = 0;
+    for( w = 0; w < LWC_WELLS; w++ ) {
+        for( p = 0; p < 2; p++ ) {
+            if( StatsOn[ w ] & ( 1 << p ) ) {
+                StatsRun[ p ] += now - StatsSince[ w ][ p ];
+                StatsSince[ w ][ p ] = now;
+            }
+        }
+        on |= StatsOn[ w ];
+    }
+    mins = ( TimeSeconds() - StatsUpS ) / 60;
+
+    if( StatsLast != 0xFF ) last = HAL_INFO( SLOT_ADDR( StatsLast ) );
+    seq = last ? Get16( last + SR_SEQ ) + 1 : 0;
+    if( ( seq & 0xFFFF ) == 0xFFFF ) seq = 0;
+    sum = seq + ( STATS_REC_SIZE - SR_RESERVED ) / 2 * 0xFFFF;             // the reserved words stay erased
+
+    for( k = 0; k < STATS_COUNTERS; k++ ) {
+        v = StatsCount( k, mins ) + ( last ? Get32( last + SR_FILL_S + 4 * k ) : 0 );
+        FlashOp( WRT, SLOT_ADDR( slot ) + SR_FILL_S + 4 * k, ( unsigned int )( v & 0xFFFF ) );
+        FlashOp( WRT, SLOT_ADDR( slot ) + SR_FILL_S + 4 * k + 2, ( unsigned int )( v >> 16 ) );
+        sum += ( unsigned int )( v & 0xFFFF ) + ( unsigned int )( v >> 16 );
+    }
+    FlashOp( WRT, SLOT_ADDR( slot ) + SR_CHECK, ~sum & 0xFFFF );
+    FlashOp( WRT, SLOT_ADDR( slot ) + SR_SEQ, seq );
+
+    StatsLast = slot;
+    StatsRun[ 0 ] &= 0x7FFF;
+    StatsRun[ 1 ] &= 0x7FFF;
+    StatsStarts[ 0 ] = StatsStarts[ 1 ] = 0;
+    StatsBoot = 0;
+    StatsUpS += mins * 60;
+    StatsPending = on != 0;
+}
+
+#endif
@@ -0,0 +1,62 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                          Pump Statistics Log                                        //
+//                                                                                                     //
+//                                                                                                     //
+// File              : stats.h                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef STATS_H
+#define STATS_H
+
+// Minutes between commits to flash; counters gathered since the last commit are lost at power off
+#ifndef STATS_COMMIT_MIN
+#define STATS_COMMIT_MIN            60
+#endif
+
+//
+// Information memory segments D, C and B (A holds the DCO calibration and is never touched), used     //
+//  as one ring of STATS_SLOTS records.  The layout is bytes, little endian, so a dump reads the same  //
+//  on any host (see sim/statsdump.c).                                                                 //
+//
+#define STATS_BASE                  0x1000      // segment D
+#define STATS_SEGS                  3
+#define STATS_SEG_SIZE              64
+#define STATS_REC_SIZE              32
+#define STATS_SLOTS                 ( STATS_SEGS * STATS_SEG_SIZE / STATS_REC_SIZE )
+
+#define SR_SEQ                      0           // record number, written last; 0xFFFF while blank
+#define SR_CHECK                    2           // ~( sum of the other 15 words )
+#define SR_FILL_S                   4           // fill pump seconds on
+#define SR_DRAIN_S                  8           // drain pump seconds on
+#define SR_FILL_STARTS              12          // fill relay off to on transitions
+#define SR_DRAIN_STARTS             16
+#define SR_BOOTS                    20          // resets
+#define SR_POWERED_MIN              24          // minutes powered
+#define SR_RESERVED                 28          // left erased
+#define STATS_COUNTERS              6           // 32-bit counters from SR_FILL_S
+
+#ifndef LWC_NO_STATS
+
+#define STATS_INIT( )               StatsInit( )
+#define STATS_RELAYS( w, relays )   StatsRelays( ( w ), ( relays ) )
+#define STATS_COMMIT( )             StatsCommit( )
+
+void StatsInit( void );
+void StatsRelays( unsigned char w, unsigned char relays );
+void StatsCommit( void );
+
+#else
+
+#define STATS_INIT( )               ( ( void )0 )
+#define STATS_RELAYS( w, relays )   ( ( void )0 )
+#define STATS_COMMIT( )             ( ( void )0 )
+
+#endif
+
+#endif
@@ -0,0 +1,215 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                           UART Telemetry                                            //
+//                                                                                                     //
+//                                                                                                     //
+// File              : telem.c                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// Every TELEM_MS the main loop packs the pots, the knob times, the float, LiveWellState, the relays   //
+// and the fill/drain model into a framed binary record (see telem.h) and drops it into a TX ring;     //
+// USCI0TX_ISR drains the ring one byte per interrupt.  If the previous frame has not gone out yet,    //
+// the new one is dropped and counted rather than waited for.  With more than one well the frames take //
+// the wells in turn, the well's number in TF_STATE, so the line rate is the same for any number.      //
+//                                                                                                     //
+// USCI_A0 runs from ACLK at 9600 baud, so it keeps sending in LPM3.  Transmit only, on P1.2           //
+// (UCA0TXD): the telemetry board moves the duration pot from P1.2 to P1.4 (see adc.h), and P1.1,      //
+// UCA0RXD, stays the interval pot.  sim/telemdump decodes the stream.                                 //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "adapt.h"
+#include "adc.h"
+#include "debounce.h"
+#include "pumps.h"
+#include "sched.h"
+#include "telem.h"
+
+#ifdef LWC_TELEMETRY
+
+#if TELEM_RING & ( TELEM_RING - 1 ) || TELEM_RING <= TELEM_FRAME
+#error TELEM_RING must be a power of two larger than a frame
+#endif
+
+unsigned int TelemDropped;                      // frames skipped because the ring was still busy
+
+static unsigned char TelemRing[ TELEM_RING ];
+static volatile unsigned char TelemHead;        // next free slot, moved by TelemSend
+static volatile unsigned char TelemTail;        // next byte to send, moved by USCI0TX_ISR
+static unsigned char TelemSeq;
+static unsigned char TelemWell;                 // well the next frame reports
+
+static void TelemTick( TBTICKS now );
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Sets up USCI_A0 as a 9600 8N1 transmitter on ACLK and starts the frame timer.          //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: 32768 / 9600 = 3.41, so UCBR 3 with UCBRS 3 (TI's table for 32 kHz).        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void TelemInit( void ) {
+
+    UCA0CTL1 |= UCSWRST;
+    UCA0CTL1 = UCSSEL_1 + UCSWRST;              // ACLK
+    UCA0CTL0 = 0;                               // 8N1, LSB first
+    UCA0BR0 = 3;
+    UCA0BR1 = 0;
+    UCA0MCTL = UCBRS_3;
+
+    P1SEL |= BIT2;                              // P1.2 = UCA0TXD
+    P1SEL2 |= BIT2;
+
+    UCA0CTL1 &= ~UCSWRST;
+
+    SchedArm( TMR_TELEM, TimeTicks(), TelemTick );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: TMR_TELEM handler, asks the main loop for a frame.                                     //
+// Arguments:   now - unused                                                                           //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: None                                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static void TelemTick( TBTICKS now ) {
+
+    ( void )now;
+    WakeEvents |= WAKE_TELEM;
+
+    SCHED_EVERY( TMR_TELEM, TELEM_MS, TelemTick );
+}
+
+// CRC-16/CCITT, one byte, without a table
+static unsigned int Crc16( unsigned int crc, unsigned char b ) {
+
+    unsigned int x = ( ( crc >> 8 ) ^ b ) & 0xFF;
+
+    x ^= x >> 4;
+    return( ( ( crc << 8 ) ^ ( x << 12 ) ^ ( x << 5 ) ^ x ) & 0xFFFF );
+}
+
+// Stores an n-byte field, little endian, at slot at of the ring
+static void TelemPut( unsigned char at, unsigned long v, unsigned char n ) {
+
+    for( ; n; n-- ) {
+        TelemRing[ at++ & ( TELEM_RING - 1 ) ] = ( unsigned char )v;
+        v >>= 8;
+    }
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Queues one telemetry frame, for the next well in turn.                                 //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Main loop only.  The frame is written straight into the ring ahead of       //
+//                         TelemHead, with no copy on the stack, and published in one store, so        //
+//                         USCI0TX_ISR never sees half of it.                                          //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void TelemSend( void ) {
+
+    unsigned char flags = 0, w = TelemWell, h, p, k;
+    const ADAPTMODEL *a = &Adapt[ w ];
+    unsigned int crc, drain;
+
+    if( ( ( TelemTail - TelemHead - 1 ) & ( TELEM_RING - 1 ) ) < TELEM_FRAME ) {
+        TelemDropped++;
+        return;
+    }
+    TelemWell = w + 1 < LWC_WELLS ? w + 1 : 0;
+
+    if( !( RELAY_OUT & FILL_BIT( w ) ) ) flags |= TFL_FILL;     // relays are active low
+    if( !( RELAY_OUT & DRAIN_BIT( w ) ) ) flags |= TFL_DRAIN;
+    if( FloatState[ w ] == INDICATES_FULL ) flags |= TFL_FLOAT_FULL;
+    if( FloatState[ w ] == FLOAT_UNKNOWN ) flags |= TFL_FLOAT_UNKNOWN;
+    if( Draining[ w ] ) flags |= TFL_DRAINING;
+    if( AerateStatus[ w ] == 2 ) flags |= TFL_AERATING;
+    if( AdaptReady( w ) ) flags |= TFL_MODEL;
+    if( a->alone ) flags |= TFL_ALONE;
+
+    drain = PotFiltered[ POT_WELL_DRAIN( w ) ];
+
+    p = TelemHead + 2;                          // payload start; the ring divides 256, so p wraps with it
+    TelemPut( p + TF_SEQ, TelemSeq++, 1 );
+    TelemPut( p + TF_POT_DRAIN, drain, 2 );
+    TelemPut( p + TF_POT_DURATION, PotFiltered[ POT_DURATION ], 2 );
+    TelemPut( p + TF_POT_INTERVAL, PotFiltered[ POT_INTERVAL ], 2 );
+    TelemPut( p + TF_INTERVAL_MS, CycleIntervalTime, 3 );
+    TelemPut( p + TF_DURATION_MS, CycleDurationTime, 3 );
+    TelemPut( p + TF_DRAIN_MS, DrainDurationTime[ w ], 2 );
+    TelemPut( p + TF_STATE, LiveWellState[ w ] | w << TF_WELL_SHIFT, 1 );
+    TelemPut( p + TF_FLAGS, flags, 1 );
+    TelemPut( p + TF_UPTIME, TimeSeconds(), 4 );
+    TelemPut( p + TF_FALL_MS, a->fall, 2 );
+    TelemPut( p + TF_FILL_MS, a->fill, 2 );
+    TelemPut( p + TF_TO_FULL, a->tofull, 2 );
+
+    h = TelemHead;
+    TelemRing[ h ] = TELEM_SYNC;
+    h = ( h + 1 ) & ( TELEM_RING - 1 );
+    TelemRing[ h ] = TELEM_LEN;
+    crc = 0xFFFF;
+    for( k = 0; k < TELEM_LEN + 1; k++ ) {      // the length and the payload, as they sit in the ring
+        crc = Crc16( crc, TelemRing[ h ] );
+        h = ( h + 1 ) & ( TELEM_RING - 1 );
+    }
+    TelemRing[ h ] = ( unsigned char )crc;
+    h = ( h + 1 ) & ( TELEM_RING - 1 );
+    TelemRing[ h ] = ( unsigned char )( crc >> 8 );
+    h = ( h + 1 ) & ( TELEM_RING - 1 );
+
+    TelemHead = h;
+    IE2 |= UCA0TXIE;                            // UCA0TXIFG is set while idle, so this starts it
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: USCI_A0 transmit interrupt, UCA0TXBUF is free.                                         //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Turns itself off when the ring is empty; TelemSend turns it back on.        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#pragma vector=USCIAB0TX_VECTOR
+__interrupt void USCI0TX_ISR( void ) {
+
+    unsigned char t = TelemTail;
+
+    if( t != TelemHead ) {
+        UCA0TXBUF = TelemRing[ t ];
+        TelemTail = t = ( t + 1 ) & ( TELEM_RING - 1 );
+    }
+    if( t == TelemHead ) IE2 &= ~UCA0TXIE;
+}
+
+#endif
@@ -0,0 +1,75 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                           UART Telemetry                                            //
+//                                                                                                     //
+//                                                                                                     //
+// File              : telem.h                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef TELEM_H
+#define TELEM_H
+
+// Frame period; a frame takes about 32 ms on the wire at 9600 baud
+#ifndef TELEM_MS
+#define TELEM_MS                    1000
+#endif
+
+#define TELEM_RING                  32          // TX ring, a power of two holding at least one frame
+
+//
+// Frame: TELEM_SYNC, TELEM_LEN, TELEM_LEN payload bytes, CRC-16/CCITT (0xFFFF start) of the length
+//  and payload, low byte first.  Multi-byte fields are little endian.
+//
+#define TELEM_SYNC                  0xA5
+#define TELEM_LEN                   27
+#define TELEM_FRAME                 ( TELEM_LEN + 4 )
+
+#define TF_SEQ                      0           // frame counter, wraps
+#define TF_POT_DRAIN                1           // PotFiltered, 2 bytes each, ADC counts; the well's own
+#define TF_POT_DURATION             3
+#define TF_POT_INTERVAL             5
+#define TF_INTERVAL_MS              7           // CycleIntervalTime, 3 bytes
+#define TF_DURATION_MS              10          // CycleDurationTime, 3 bytes
+#define TF_DRAIN_MS                 13          // DrainDurationTime, 2 bytes
+#define TF_STATE                    15          // LiveWellState, the well in the high bits
+#define TF_FLAGS                    16          // TFL_*, for the well
+#define TF_UPTIME                   17          // seconds since power up, 4 bytes; a warm restart carries on
+#define TF_FALL_MS                  21          // Adapt.fall, 2 bytes, 0 until the first trip
+#define TF_FILL_MS                  23          // Adapt.fill, 2 bytes
+#define TF_TO_FULL                  25          // Adapt.tofull, 2 bytes, 100 ms units
+
+#define TF_WELL_SHIFT               4           // TF_STATE: well << 4 | state, one well per frame in turn
+#define TF_STATE_MASK               0x0F
+
+#define TFL_FILL                    0x01        // spray/fill relay on
+#define TFL_DRAIN                   0x02        // drain relay on
+#define TFL_FLOAT_FULL              0x04
+#define TFL_FLOAT_UNKNOWN           0x08        // still debouncing after reset
+#define TFL_DRAINING                0x10        // drain override
+#define TFL_AERATING                0x20        // AerateStatus 2, else resting
+#define TFL_MODEL                   0x40        // AdaptReady
+#define TFL_ALONE                   0x80        // the exchange under way runs the drain alone
+
+#ifdef LWC_TELEMETRY
+
+#define TELEM_INIT( )               TelemInit( )
+#define TELEM_SEND( )               TelemSend( )
+
+extern unsigned int TelemDropped;
+
+void TelemInit( void );
+void TelemSend( void );
+
+#else
+
+#define TELEM_INIT( )               ( ( void )0 )
+#define TELEM_SEND( )               ( ( void )0 )
+
+#endif
+
+#endif
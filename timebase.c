@@ -0,0 +1,343 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                           Tickless Timebase                                         //
+//                                                                                                     //
+//                                                                                                     //
+// File              : timebase.c                                                                      //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// TA1 free-runs on the 32.768 kHz crystal and is never reloaded.  The clock is a 32-bit count of      //
+// those ticks, kept as the count at the last update plus however far TA1R has moved since, so it is   //
+// exact: milliseconds are derived from it (x 125 / 4096) rather than counted, and nothing drifts the  //
+// way the old 33-tick reload did (1.0071 ms per "ms").  Updates happen with interrupts off, and at    //
+// least every TB_MAX_AHEAD ticks because that is the furthest an alarm is ever set.                   //
+//                                                                                                     //
+// The count wraps every 36.4 hours.  Deadlines are never that far ahead, so they are kept in 32 bits  //
+// and compared by difference (TB_BEFORE, TB_DUE).  A start time whose age can run past a wrap, a      //
+// relay's last switch or the state a well entered, is kept with ClockEpoch, the number of wraps, as   //
+// a TBTIME48 from TimeNow48, and TimeSince48 reads its age, saturated rather than wrapped.            //
+//                                                                                                     //
+// Instead of a 1 kHz tick, TA1CCR0 is set for the earliest thing Timer1_A0 has to do.                 //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "timebase.h"
+
+static TBTICKS ClockBase;                       // ticks at the last update
+static unsigned int ClockEpoch;                 // times ClockBase has wrapped
+static unsigned int ClockMark;                  // TA1R at the last update
+static TBTICKS AlarmAt;                         // what TA1CCR0 is set for
+static unsigned char AlarmKicked;               // Timer1_A0 is pending to reconsider AlarmAt
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Reads TA1R.                                                                            //
+// Arguments:   None                                                                                   //
+// Returns:     Timer count                                                                            //
+//                                                                                                     //
+// Notes/Warnings/Caveats: TA1 is clocked from ACLK, not MCLK, so a read can catch the count changing; //
+//                         two reads that agree are taken as good.                                     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+static unsigned int TimerRead( void ) {
+
+    unsigned int r;
+
+    do {
+        r = TA1R;
+    } while( r != TA1R );
+
+    return( r );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Starts TA1 on ACLK with the first alarm already pending.                               //
+// Arguments:   start - clock to carry on from, 0 at power up                                          //
+//              epoch - its wraps, 0 at power up                                                       //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Timer1_A0 runs as soon as interrupts are enabled and sets its own alarm.    //
+//                         A warm restart passes the clock it saved, so deadlines taken from the       //
+//                         snapshot stay in the same time frame.                                       //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void TimebaseInit( TBTICKS start, unsigned int epoch ) {
+
+    ClockBase = start;
+    ClockEpoch = epoch;
+    ClockMark = 0;
+    AlarmKicked = 1;
+
+    TA1CTL = TASSEL_1 + MC_2 + TACLR;           // ACLK/1, Cont Mode
+    TA1CCR0 = TB_MAX_AHEAD;
+    TA1CCTL0 = CCIE + CCIFG;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Brings the clock up to TA1R.                                                           //
+// Arguments:   None                                                                                   //
+// Returns:     Current time in ticks                                                                  //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Interrupts must be off.                                                     //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+TBTICKS TimebaseUpdate( void ) {
+
+    unsigned int r = TimerRead();
+    unsigned int d = ( r - ClockMark ) & 0xFFFF;
+
+    ClockBase += d;
+    if( ClockBase < d ) ClockEpoch++;
+    ClockMark = r;
+
+    return( ClockBase );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Sets TA1CCR0 for the next deadline.                                                    //
+// Arguments:   at - absolute time in ticks, at most TB_MAX_AHEAD away when nothing is due             //
+// Returns:     Nonzero when at is already due (or too close to catch), so the caller handles it now   //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Called from Timer1_A0 only.  Deadlines beyond TB_MAX_AHEAD get an           //
+//                         intermediate alarm that just updates the clock.                             //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int TimebaseAlarm( TBTICKS at ) {
+
+    TBTICKS now = TimebaseUpdate();
+    unsigned int ahead;
+
+    if( TB_DUE( at, now ) ) return( 1 );
+
+    ahead = ( at - now > TB_MAX_AHEAD ) ? TB_MAX_AHEAD : ( unsigned int )( at - now );
+    AlarmAt = now + ahead;
+    AlarmKicked = 0;
+    TA1CCR0 = ClockMark + ahead;
+
+    // Make sure the count did not pass the compare while it was being written
+    if( ( ( TimerRead() - ClockMark ) & 0xFFFF ) >= ahead ) return( 1 );
+    return( 0 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Gets Timer1_A0 to reconsider its alarm because a deadline was added.                   //
+// Arguments:   at - the new deadline in ticks                                                         //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Only raises the interrupt when at is earlier than the alarm already set.    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void TimebaseKick( TBTICKS at ) {
+
+    unsigned int sr = __get_SR_register( );
+
+    __disable_interrupt( );
+    if( !AlarmKicked && TB_BEFORE( at, AlarmAt ) ) {
+        AlarmKicked = 1;
+        TA1CCTL0 |= CCIFG;
+    }
+    if( sr & GIE ) __enable_interrupt( );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: The clock, read atomically.                                                            //
+// Arguments:   None                                                                                   //
+// Returns:     Ticks since power up, modulo 2^32, carried over a warm restart                         //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Safe from any context.                                                      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+TBTICKS TimeTicks( void ) {
+
+    unsigned int sr = __get_SR_register( );
+    TBTICKS t;
+
+    __disable_interrupt( );
+    t = TimebaseUpdate();
+    if( sr & GIE ) __enable_interrupt( );
+
+    return( t );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: The clock and its wraps, read together.                                                //
+// Arguments:   t - filled with TimeTicks() and ClockEpoch                                             //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Safe from any context.                                                      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void TimeNow48( TBTIME48 *t ) {
+
+    unsigned int sr = __get_SR_register( );
+
+    __disable_interrupt( );
+    t->ticks = TimebaseUpdate();
+    t->epoch = ClockEpoch;
+    if( sr & GIE ) __enable_interrupt( );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Widens a 32-bit time taken less than one wrap before now.                              //
+// Arguments:   t   - filled with at and its wraps                                                     //
+//              at  - TimeTicks() at most 36.4 hours before now                                        //
+//              now - from TimeNow48                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: An at older than that reads one or more wraps too young.                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void TimeRecent48( TBTIME48 *t, TBTICKS at, const TBTIME48 *now ) {
+
+    t->ticks = at;
+    t->epoch = now->epoch - ( at > now->ticks );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Ticks from one 48-bit time to a later one.                                             //
+// Arguments:   then - start, now - end                                                                //
+// Returns:     now - then, 0xFFFFFFFF for a wrap or more, 0 if then is after now                      //
+//                                                                                                     //
+// Notes/Warnings/Caveats: None                                                                        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned long TimeSince48( const TBTIME48 *then, const TBTIME48 *now ) {
+
+    unsigned int wraps = now->epoch - then->epoch - ( now->ticks < then->ticks );
+
+    if( wraps ) return( wraps & 0x8000 ? 0 : 0xFFFFFFFFUL );
+    return( now->ticks - then->ticks );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: The clock's wraps, for a warm restart to carry over with the clock.                    //
+// Arguments:   None                                                                                   //
+// Returns:     ClockEpoch                                                                             //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Pair it with a TimeTicks read taken with interrupts off.                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned int TimeEpoch( void ) {
+
+    return( ClockEpoch );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Seconds since power up, carried over a warm restart.                                   //
+// Arguments:   None                                                                                   //
+// Returns:     The epoch and the clock's top 17 bits                                                  //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Safe from any context.  Good for 262,143 epochs, 1,088 years.               //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned long TimeSeconds( void ) {
+
+    unsigned int sr = __get_SR_register( );
+    unsigned long s;
+
+    __disable_interrupt( );
+    s = ( ( unsigned long )ClockEpoch << 17 ) + ( TimebaseUpdate() >> 15 );
+    if( sr & GIE ) __enable_interrupt( );
+
+    return( s );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Ticks to whole milliseconds, t x 1000 / 32768 = t x 125 / 4096.                        //
+// Arguments:   t - ticks                                                                              //
+// Returns:     milliseconds, truncated                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Whole 4096-tick blocks are exactly 125 ms, so only the remainder is scaled  //
+//                         and nothing overflows 32 bits.                                              //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned long TicksToMs( TBTICKS t ) {
+
+    return( ( t >> 12 ) * 125 + ( ( ( unsigned int )t & 4095 ) * 125UL >> 12 ) );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Milliseconds to ticks, rounded up so a deadline is never early.                        //
+// Arguments:   ms - at most 1,048,575 (17 minutes), larger values are clamped                         //
+// Returns:     ticks                                                                                  //
+//                                                                                                     //
+// Notes/Warnings/Caveats: The knobs top out at 10 minutes and an adapted rest runs a few seconds past //
+//                         that.  A clamped time would end early, as PumpPost posts a due timeout      //
+//                         without looking again.                                                      //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+unsigned long MsToTicks( unsigned long ms ) {
+
+    if( ms > 0xFFFFFUL ) ms = 0xFFFFFUL;
+    return( ( ms * 4096UL + 124 ) / 125 );
+}
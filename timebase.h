@@ -0,0 +1,54 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                           Tickless Timebase                                         //
+//                                                                                                     //
+//                                                                                                     //
+// File              : timebase.h                                                                      //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+#define TB_HZ                       32768UL     // ACLK, TA1 count rate
+
+// ms to ACLK ticks is 4096 / 125 exactly; whole ticks and the remainder in 1/125ths of a tick
+#define TB_WHOLE( ms )              ( ( ( unsigned long )( ms ) * 4096UL ) / 125 )
+#define TB_FRAC( ms )               ( ( unsigned int )( ( ( unsigned long )( ms ) * 4096UL ) % 125 ) )
+#define TB_TICKS( ms )              ( TB_WHOLE( ms ) + ( TB_FRAC( ms ) != 0 ) )     // rounded up
+
+#define TB_MAX_AHEAD                0x8000      // longest alarm, TA1 must be read well inside a wrap
+#define TB_MIN_AHEAD                2           // closer than this is treated as already due
+
+typedef uint32_t TBTICKS;                       // ACLK ticks since power up, wraps every 36.4 hours
+
+// The clock with its wraps, 48 bits, for a start time whose age may run past a wrap
+typedef struct {
+    TBTICKS         ticks;
+    unsigned int    epoch;
+} TBTIME48;
+
+// Times are compared by their difference, so they order correctly within 18 hours of each other
+#define TB_BEFORE( a, b )           ( ( int32_t )( ( a ) - ( b ) ) < 0 )
+#define TB_DUE( at, now )           ( ( int32_t )( ( at ) - ( now ) - TB_MIN_AHEAD ) <= 0 )
+
+void TimebaseInit( TBTICKS start, unsigned int epoch );
+TBTICKS TimebaseUpdate( void );
+int TimebaseAlarm( TBTICKS at );
+void TimebaseKick( TBTICKS at );
+TBTICKS TimeTicks( void );
+void TimeNow48( TBTIME48 *t );
+void TimeRecent48( TBTIME48 *t, TBTICKS at, const TBTIME48 *now );
+unsigned long TimeSince48( const TBTIME48 *then, const TBTIME48 *now );
+unsigned int TimeEpoch( void );
+unsigned long TimeSeconds( void );
+unsigned long TicksToMs( TBTICKS t );
+unsigned long MsToTicks( unsigned long ms );
+
+#endif
@@ -0,0 +1,121 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                             Event Trace                                             //
+//                                                                                                     //
+//                                                                                                     //
+// File              : trace.c                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// A ring of the last TRACE_LEN state changes, relay writes, float and knob changes, each four bytes:  //
+// id, arg and the time since the previous record in 1/1024 s.  Trace points sit only where something  //
+// changes, never in the per-sample paths, so the G2553's 16 records cover the last couple of          //
+// exchanges and a record costs a clock read, one call and four byte stores.                           //
+//                                                                                                     //
+// The ring is in no-init RAM beside WarmSnap.  A watchdog reset that restarts warm keeps it, so what  //
+// led up to the reset is still there after it, followed by TR_RESET and each well's TR_WARM; a cold   //
+// start empties it.  Read it with a debugger (mspdebug "md TraceLog 66") or lwcsim-original -T and    //
+// decode it with sim/tracedump.                                                                       //
+//                                                                                                     //
+// Build with LWC_NO_TRACE to compile it all out.  The telemetry board is built that way unless        //
+// LWC_TRACE is given, as its RAM goes to the UART frame and the frames report the state anyway (see   //
+// wells.h).                                                                                           //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include "lwc.h"
+#include "timebase.h"
+#include "trace.h"
+
+#ifndef LWC_NO_TRACE
+
+#if TRACE_LEN & ( TRACE_LEN - 1 ) || TRACE_LEN > 128
+#error TRACE_LEN must be a power of two, at most 128
+#endif
+
+HAL_NOINIT TRACELOG TraceLog;
+
+static HAL_NOINIT unsigned long TraceLast;      // clock at the last record, 1/1024 s
+
+static void TracePut( unsigned char id, unsigned char arg, unsigned int dt ) {
+
+    unsigned char *r = TraceLog.rec[ TraceLog.head ];
+
+    r[ 0 ] = id;
+    r[ 1 ] = arg;
+    r[ 2 ] = ( unsigned char )dt;
+    r[ 3 ] = ( unsigned char )( dt >> 8 );
+
+    TraceLog.head = ( TraceLog.head + 1 ) & ( TRACE_LEN - 1 );
+    if( TraceLog.count < TRACE_LEN ) TraceLog.count++;
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Empties the log, unless a warm restart keeps it, and records the reset.                //
+// Arguments:   warm - WarmStart's verdict                                                             //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Call after TimebaseInit.  The records need no checksum of their own: a warm //
+//                         start has shown RAM held, and only the indexes are checked.                 //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void TraceInit( int warm ) {
+
+    if( !warm || TraceLog.head >= TRACE_LEN || TraceLog.count > TRACE_LEN ) {
+        TraceLog.head = 0;
+        TraceLog.count = 0;
+        TraceLast = ( unsigned long )TimeTicks() >> TRACE_SHIFT;
+    }
+
+    TRACE( TR_RESET, 0 );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Appends a record, overwriting the oldest once the ring is full.                        //
+// Arguments:   id - TR_*, arg - payload, at - TimeTicks() when it happened, a moment ago at most      //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Safe from any context.  TRACE reads the clock before the call rather than   //
+//                         inside it, so a trace point nests one call deep.  The records stay in       //
+//                         order, so one made since at takes the same time as it.  The clock wraps     //
+//                         every 36 hours, so a gap is exact up to that; one over 65535 / 1024 s takes //
+//                         a TR_TIME record first, and one over 4.5 hours is recorded as 4.5 hours.    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void TraceRecAt( unsigned char id, unsigned char arg, TBTICKS at ) {
+
+    unsigned int sr = __get_SR_register( );
+    unsigned long t, dt;
+
+    __disable_interrupt( );
+
+    t = ( unsigned long )at >> TRACE_SHIFT;
+    dt = ( t - TraceLast ) & ( 0xFFFFFFFFUL >> TRACE_SHIFT );
+    if( dt > ( 0xFFFFFFFFUL >> ( TRACE_SHIFT + 1 ) ) ) dt = 0;
+    else TraceLast = t;
+
+    if( dt > 0xFFFF ) {
+        if( dt > 0xFFFFFFUL ) dt = 0xFFFFFFUL;
+        TracePut( TR_TIME, ( unsigned char )( dt >> 16 ), ( unsigned int )dt );
+        dt = 0;
+    }
+    TracePut( id, arg, ( unsigned int )dt );
+
+    if( sr & GIE ) __enable_interrupt( );
+}
+
+#endif
@@ -0,0 +1,81 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                             Event Trace                                             //
+//                                                                                                     //
+//                                                                                                     //
+// File              : trace.h                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "timebase.h"
+#include "wells.h"
+
+// TRACE_LEN records are kept (wells.h).  Each costs TRACE_REC bytes of RAM, so the G2553 keeps 16, the
+// last couple of exchanges; a bench build with RAM to spare can take -DTRACE_LEN=64.
+#define TRACE_REC                   4           // id, arg, dt low, dt high
+
+#define TRACE_SHIFT                 5           // dt unit is 2^5 ACLK ticks, 1/1024 s
+
+// Record ids and what arg holds
+#define TR_TIME                     0           // gap too long for dt, arg:dt is its 24-bit length
+#define TR_RESET                    1           // firmware started, arg 0
+#define TR_STATE                    2           // transition, arg event << 4 | new state
+#define TR_RELAYS                   3           // relays driven, arg fill on | drain on << 1
+#define TR_TIMEOUT                  4           // TMR_PUMP posted event arg
+#define TR_EDGE                     5           // float switch edge starts a debounce, arg FLOAT_SWITCH( w ) != 0
+#define TR_FLOAT                    6           // FloatState changed to arg, timed from FloatSince
+#define TR_DRAIN                    7           // drain override on (1) or off (0)
+#define TR_INTERVAL                 8           // CycleIntervalTime >> 12, 4.096 s units
+#define TR_DURATION                 9           // CycleDurationTime >> 12
+#define TR_DRAIN_TIME               10          // DrainDurationTime >> 6, 64 ms units
+#define TR_WARM                     11          // warm restart, arg IFG1 reset flags << 4 | state resumed
+#define TR_FALL                     12          // Adapt.fall changed, >> 6, 64 ms units
+#define TR_FILL                     13          // Adapt.fill changed, >> 6
+#define TR_TO_FULL                  14          // RAISE_LEVEL* reached full, arg seconds, 255 at most
+#define TR_STACK                    15          // StackMax went up, arg bytes / 2, 255 at most
+#define TR_SLOSH                    16          // float read full while lowering, arg ADAPT_CALM
+
+// Records for one well carry it in the top bits of the id; TR_INTERVAL and TR_DURATION are shared
+#define TR_WELL_SHIFT               6
+#define TR_ID_MASK                  0x3F
+#define TRACE_W( id, w, arg )       TRACE( ( id ) | ( w ) << TR_WELL_SHIFT, arg )
+#define TRACE_KNOB_W( id, w, was, arg ) TRACE_KNOB( ( id ) | ( w ) << TR_WELL_SHIFT, was, arg )
+
+// The whole log is bytes, so a raw memory dump reads the same on any host (see sim/tracedump.c)
+typedef struct {
+    unsigned char   head;                       // slot the next record goes in
+    unsigned char   count;                      // records held, up to TRACE_LEN
+    unsigned char   rec[ TRACE_LEN ][ TRACE_REC ];
+} TRACELOG;
+
+#ifndef LWC_NO_TRACE
+
+extern TRACELOG TraceLog;
+
+#define TRACE_INIT( warm )          TraceInit( warm )
+#define TRACE( id, arg )            TraceRecAt( ( id ), ( unsigned char )( arg ), TimeTicks( ) )
+#define TRACE_AT( id, arg, at )     TraceRecAt( ( id ), ( unsigned char )( arg ), ( at ) )
+
+// A knob or model time, only when its traced byte differs from was's; a move of less than a unit adds nothing
+#define TRACE_KNOB( id, was, arg )  ( ( unsigned char )( ( was ) ^ ( arg ) ) ? TRACE( id, arg ) : ( void )0 )
+
+void TraceInit( int warm );
+void TraceRecAt( unsigned char id, unsigned char arg, TBTICKS at );
+
+#else
+
+#define TRACE_INIT( warm )          ( ( void )( warm ) )
+#define TRACE( id, arg )            ( ( void )0 )
+#define TRACE_AT( id, arg, at )     ( ( void )0 )
+#define TRACE_KNOB( id, was, arg )  ( ( void )( id ), ( void )( was ) )     // Learn's id and w are only traced
+
+#endif
+
+#endif
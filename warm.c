@@ -0,0 +1,188 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                            Warm Restart                                             //
+//                                                                                                     //
+//                                                                                                     //
+// File              : warm.c                                                                          //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+// After every main loop pass WarmSave copies what the pumps need to carry on into WarmSnap, a small   //
+// checksummed record in no-init RAM: each well's state, tAerate, tLower and float level, its relays   //
+// and when each last switched, the filtered pots and the clock they were taken at.  WatchdogTick      //
+// moves the clock on every WDT_KICK_MS.  The pot filter windows are no-init as well (see filter.c).   //
+//                                                                                                     //
+// A watchdog reset, or a brownout short enough for RAM to hold, leaves all of it in place.  At the    //
+// next start WarmStart checks it, the clock resumes from the saved value, and the relays are back as  //
+// they were as soon as the ports are set up, with no float probe and no wait for the filters to fill. //
+// A timeout in progress carries on and only runs long by the time between the last save and the       //
+// reset.  A power up, or anything that fails the checks for any well, starts cold as before.          //
+//                                                                                                     //
+// Build with LWC_NO_WARM to leave it out, and WarmSnap's RAM with it: every reset then starts cold.   //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#include <stddef.h>
+
+#include "lwc.h"
+#include "adc.h"
+#include "debounce.h"
+#include "filter.h"
+#include "pumps.h"
+#include "relay.h"
+#include "trace.h"
+#include "warm.h"
+
+#ifndef LWC_NO_WARM
+
+HAL_NOINIT WARMSNAP WarmSnap;
+
+// Fails to compile unless the per-well bytes leave magic on a word boundary, as Check sums whole words
+typedef char WarmMagicCheck[ offsetof( WARMSNAP, magic ) % 2 == 0 ? 1 : -1 ];
+
+static unsigned char WarmCause;                 // IFG1 reset flags at startup
+
+static unsigned int Check( void ) {
+
+    const unsigned char *p = ( const unsigned char * )&WarmSnap;
+    const unsigned char *end = ( const unsigned char * )&WarmSnap.check;
+    unsigned int sum = 0;
+
+    for( ; p < end; p += 2 ) sum += p[ 0 ] | ( ( unsigned int )p[ 1 ] << 8 );
+    return( ~sum & 0xFFFF );
+}
+
+#endif
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Decides between a warm and a cold start.                                               //
+// Arguments:   None                                                                                   //
+// Returns:     Nonzero when WarmSnap and the pot filters survived the reset, never with LWC_NO_WARM   //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Call first thing, before TimebaseInit.  Clears the reset flags in IFG1.     //
+//                         On a cold start the snapshot is invalidated and the filters emptied.        //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+int WarmStart( void ) {
+
+#ifdef LWC_NO_WARM
+    IFG1 &= ~( WDTIFG + PORIFG + RSTIFG );
+    AuxReset();
+    return( 0 );
+#else
+    unsigned char ch, w;
+    int ok;
+
+    WarmCause = IFG1 & ( WDTIFG + PORIFG + RSTIFG );
+    IFG1 &= ~( WDTIFG + PORIFG + RSTIFG );
+
+    ok = WarmSnap.magic == WARM_MAGIC && WarmSnap.check == Check();
+
+    for( w = 0; ok && w < LWC_WELLS; w++ ) {
+        ok = WarmSnap.state[ w ] < PUMP_STATES && WarmSnap.status[ w ] <= 2
+          && ( WarmSnap.level[ w ] == INDICATES_EMPTY || WarmSnap.level[ w ] == INDICATES_FULL )
+          && !TB_BEFORE( WarmSnap.clock, WarmSnap.aerate[ w ] )
+          && !TB_BEFORE( WarmSnap.clock, WarmSnap.lower[ w ] );
+    }
+
+    for( ch = 0; ok && ch < POT_CHANNELS; ch++ ) ok = WarmSnap.pot[ ch ] <= 0x3FF && AuxValid( ch );
+
+    if( !ok ) {
+        WarmSnap.magic = 0;
+        AuxReset();
+    }
+    return( ok );
+#endif
+}
+
+#ifndef LWC_NO_WARM
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Puts the float levels and the filtered pots back as they were saved.                   //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Warm start only.  Every pot is marked dirty, so ReadPots rebuilds the knob  //
+//                         times and the drain override from them; PumpResume then sets the relays.    //
+//                         The float debounce still runs and corrects FloatState if the float moved.   //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void WarmRestore( void ) {
+
+    unsigned char ch, w;
+
+    __disable_interrupt();
+    for( w = 0; w < LWC_WELLS; w++ ) FloatState[ w ] = WarmSnap.level[ w ];
+    for( ch = 0; ch < POT_CHANNELS; ch++ ) PotFiltered[ ch ] = WarmSnap.pot[ ch ];
+    PotDirty = POT_ALL;
+    __enable_interrupt();
+
+    for( w = 0; w < LWC_WELLS; w++ ) TRACE_W( TR_WARM, w, ( WarmCause << 4 ) | WarmSnap.state[ w ] );
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Takes a new snapshot.                                                                  //
+// Arguments:   None                                                                                   //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Main loop only, at the end of a pass when the state and its inputs agree.   //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void WarmSave( void ) {
+
+    unsigned char ch, w;
+
+    __disable_interrupt();
+    WarmSnap.clock = TimebaseUpdate();
+    WarmSnap.epoch = TimeEpoch();
+    PumpSave( &WarmSnap );
+    RelaySave( &WarmSnap );
+    for( w = 0; w < LWC_WELLS; w++ ) WarmSnap.level[ w ] = FloatState[ w ];
+    for( ch = 0; ch < POT_CHANNELS; ch++ ) WarmSnap.pot[ ch ] = PotFiltered[ ch ];
+    WarmSnap.magic = WARM_MAGIC;
+    WarmSnap.check = Check();
+    __enable_interrupt();
+}
+
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                                                                                     //
+//                                                                                                     //
+// Description: Moves the snapshot's clock on, so a restart loses at most one WDT_KICK_MS of it.       //
+// Arguments:   now - dispatch time                                                                    //
+// Returns:     Nothing                                                                                //
+//                                                                                                     //
+// Notes/Warnings/Caveats: Called from Timer1_A0.  Does nothing until the first WarmSave.              //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+void WarmClock( TBTICKS now ) {
+
+    if( WarmSnap.magic != WARM_MAGIC ) return;
+
+    WarmSnap.clock = now;
+    WarmSnap.epoch = TimeEpoch();
+    WarmSnap.check = Check();
+}
+
+#endif
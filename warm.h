@@ -0,0 +1,66 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                            Warm Restart                                             //
+//                                                                                                     //
+//                                                                                                     //
+// File              : warm.h                                                                          //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef WARM_H
+#define WARM_H
+
+#include "adc.h"
+#include "timebase.h"
+
+//
+// The watchdog runs in watchdog mode from ACLK / 32768, so it resets the part 1 s after the last kick.
+//  WatchdogTick (main.c) kicks it every WDT_KICK_MS, but only while the main loop is still going round.
+//
+#define WDT_KICK_MS                 500
+#define WDT_KICK( )                 ( WDTCTL = WDTPW + WDTCNTCL + WDTSSEL )
+
+#define WARM_MAGIC                  0x5752
+
+// Kept in no-init RAM; everything up to check is covered by it.  The arrays are per well.
+typedef struct {
+    TBTICKS         clock;                      // TimeTicks at the last save, the clock resumes from here
+    unsigned int    epoch;                      // TimeEpoch with it
+    TBTICKS         aerate[ LWC_WELLS ];        // tAerate
+    TBTICKS         lower[ LWC_WELLS ];         // tLower
+    TBTICKS         since[ LWC_WELLS ][ 2 ];    // RelaySince, fill and drain
+    unsigned int    pot[ POT_CHANNELS ];        // PotFiltered
+    unsigned char   state[ LWC_WELLS ];         // LiveWellState
+    unsigned char   status[ LWC_WELLS ];        // AerateStatus
+    unsigned char   level[ LWC_WELLS ];         // FloatState, never FLOAT_UNKNOWN
+    unsigned char   relays[ LWC_WELLS ];        // RelayOn
+    unsigned int    magic;                      // WARM_MAGIC, on a word boundary (warm.c checks)
+    unsigned int    check;                      // ~( sum of the 16-bit words before it )
+} WARMSNAP;
+
+// WarmStart is always there; built with LWC_NO_WARM it clears the reset flags and always starts cold
+int WarmStart( void );
+
+#ifndef LWC_NO_WARM
+
+extern WARMSNAP WarmSnap;
+
+#define WARM_SAVE( )                WarmSave( )
+#define WARM_CLOCK( now )           WarmClock( now )
+
+void WarmRestore( void );
+void WarmSave( void );
+void WarmClock( TBTICKS now );
+
+#else
+
+#define WARM_SAVE( )                ( ( void )0 )
+#define WARM_CLOCK( now )           ( ( void )( now ) )
+
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//                                                                                                     //
+//                                           Live Well Controller                                      //
+//                                                                                                     //
+//                                             Live Wells                                              //
+//                                                                                                     //
+//                                                                                                     //
+// File              : wells.h                                                                         //
+// Software Engineer : Chris Langer                                                                    //
+//                                                                                                     //
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+#ifndef WELLS_H
+#define WELLS_H
+
+// Live wells run by one controller, each with its own float, relays, drain knob and state
+#ifndef LWC_WELLS
+#define LWC_WELLS                   1
+#endif
+#if LWC_WELLS < 1 || LWC_WELLS > 4
+#error LWC_WELLS must be 1 to 4
+#endif
+
+// The telemetry board reports its state over the UART instead of keeping the trace; LWC_TRACE keeps both
+#if defined( LWC_TELEMETRY ) && !defined( LWC_TRACE ) && !defined( LWC_NO_TRACE )
+#define LWC_NO_TRACE
+#endif
+
+// Trace records kept, a power of two (see trace.h)
+#ifndef TRACE_LEN
+#define TRACE_LEN                   16
+#endif
+
+// RAM on the part
+#ifndef LWC_RAM_BYTES
+#define LWC_RAM_BYTES               512         // G2553
+#endif
+
+//
+// What a build takes of it: static RAM as memreport -T sizes it, for the one-well firmware and for each
+//  well added, and the stack as cyclebench measured it on lwc.elf under iss430, the deepest the main
+//  loop goes with GIE set and the deepest ISR on top.  The base is what every build takes; each option
+//  left in adds its part.  wellbench fails when a build outgrows these, and a build that won't fit stops
+//  here.  With every option out two wells fit on the G2553; with them all in, one.
+//
+#define WELL_ONE_BASE               249
+#define WELL_EACH_BASE              102
+#define WELL_STACK_BASE             122
+
+#ifndef LWC_NO_TRACE
+#define WELL_ONE_TRACE              ( 6 + 4 * TRACE_LEN )   // TraceLog and TraceLast
+#define WELL_STACK_TRACE            4                       // a record from the main loop's deepest call
+#else
+#define WELL_ONE_TRACE              0
+#define WELL_STACK_TRACE            0
+#endif
+
+#ifndef LWC_NO_WARM
+#define WELL_ONE_WARM               36          // WarmSnap
+#define WELL_EACH_WARM              22
+#else
+#define WELL_ONE_WARM               0
+#define WELL_EACH_WARM              0
+#endif
+
+#ifndef LWC_NO_STATS
+#define WELL_ONE_STATS              28          // counters and on times not yet in flash
+#define WELL_EACH_STATS             9
+#else
+#define WELL_ONE_STATS              0
+#define WELL_EACH_STATS             0
+#endif
+
+#ifdef LWC_TELEMETRY
+#define WELL_ONE_TELEM              50          // frame ring and its UART state
+#else
+#define WELL_ONE_TELEM              0
+#endif
+
+#define WELL_RAM_ONE                ( WELL_ONE_BASE + WELL_ONE_TRACE + WELL_ONE_WARM + WELL_ONE_STATS + \
+                                      WELL_ONE_TELEM )
+#define WELL_RAM_EACH               ( WELL_EACH_BASE + WELL_EACH_WARM + WELL_EACH_STATS )
+#define WELL_RAM( n )               ( WELL_RAM_ONE + ( ( n ) - 1 ) * WELL_RAM_EACH )
+#define WELL_STACK_BYTES            ( WELL_STACK_BASE + WELL_STACK_TRACE )
+
+#if !defined( LWC_SIM ) && WELL_RAM( LWC_WELLS ) + WELL_STACK_BYTES > LWC_RAM_BYTES
+#error LWC_WELLS wells do not fit in LWC_RAM_BYTES; LWC_NO_TRACE, LWC_NO_WARM and LWC_NO_STATS give RAM back
+#endif
+
+// Initializer for a per-well array with every element v
+#if LWC_WELLS == 1
+#define WELLS_OF( v )               { v }
+#elif LWC_WELLS == 2
+#define WELLS_OF( v )               { v, v }
+#elif LWC_WELLS == 3
+#define WELLS_OF( v )               { v, v, v }
+#else
+#define WELLS_OF( v )               { v, v, v, v }
+#endif
+
+#endif